@@ -0,0 +1,563 @@
+// headless dsp micro benchmarks, no window, gl context or audio device.
+//
+//   Signalbox_bench [--filter <substring>] [--min-time <seconds>] [--csv] [--isa <sse2|avx2|avx512|neon>]
+//
+// every case reports ns per sample and million samples per second, where a sample is one frame of one
+// channel, so cases with different channel counts compare directly. --isa forces the kernel variant,
+// otherwise the best one the cpu supports is used.
+
+#include "dsp/biquad.h"
+#include "dsp/convolver.h"
+#include "dsp/fir.h"
+#include "dsp/graph.h"
+#include "dsp/kernels.h"
+#include "dsp/nodes.h"
+#include "dsp/oversampler.h"
+#include "dsp/resampler.h"
+#include "dsp/response.h"
+#include "dsp/voices.h"
+#include "dsp/wavetable.h"
+#include "dsp/workers.h"
+#include "enc.h"
+
+#include <fft.h>
+#include <algorithm>
+#include <chrono>
+#include <complex>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Bench_Options final {
+    std::string filter;
+    float64 min_time = 0.25;
+    bool csv = false;
+};
+
+class Bench_Runner final {
+  public:
+    explicit Bench_Runner(const Bench_Options& options) : m_options{options} {
+        if (m_options.csv)
+            std::printf("name,block,channels,ns_per_sample,msamples_per_sec\n");
+        else
+            std::printf("%-40s %7s %4s %12s %12s\n", "case", "block", "ch", "ns/sample", "Msamples/s");
+    }
+
+    // fn processes one block of block * channels samples
+    void run(const std::string& name, uint32 block, uint32 channels, const std::function<void()>& fn) {
+        if (!m_options.filter.empty() && name.find(m_options.filter) == std::string::npos)
+            return;
+
+        using Clock = std::chrono::steady_clock;
+
+        // warm caches and branch predictors, then double the batch until it takes long enough to time
+        fn();
+        uint64 iterations = 1;
+        float64 seconds = 0.0;
+        for (;;) {
+            const auto start = Clock::now();
+            for (uint64 i = 0; i < iterations; ++i)
+                fn();
+            seconds = std::chrono::duration<float64>(Clock::now() - start).count();
+            if (seconds >= m_options.min_time)
+                break;
+            iterations *= 2;
+        }
+
+        const auto samples = static_cast<float64>(iterations) * block * channels;
+        const auto ns = seconds * 1e9 / samples;
+        const auto msps = samples / seconds / 1e6;
+        if (m_options.csv)
+            std::printf("%s,%u,%u,%.4f,%.2f\n", name.c_str(), block, channels, ns, msps);
+        else
+            std::printf("%-40s %7u %4u %12.3f %12.2f\n", name.c_str(), block, channels, ns, msps);
+        std::fflush(stdout);
+    }
+
+  private:
+    Bench_Options m_options;
+};
+
+static std::vector<float32> noise(size_t count, uint32 seed = 1) {
+    std::mt19937 rng{seed};
+    std::uniform_real_distribution<float32> dist{-0.5f, 0.5f};
+    std::vector<float32> v(count);
+    for (auto& x : v)
+        x = dist(rng);
+    return v;
+}
+
+static constexpr uint32 BLOCKS[] = {32, 128, 512, 2048};
+static constexpr uint32 CHANNELS[] = {1, 2, 8};
+static constexpr uint32 SAMPLE_RATE = 48000;
+
+static void bench_biquad(Bench_Runner& bench) {
+    constexpr uint32 sections = 4;
+    std::vector<Biquad_Coeffs> coeffs;
+    std::vector<Biquad_Coeffs_F64> coeffs_f64;
+    for (uint32 s = 0; s < sections; ++s) {
+        const auto hz = 200.0 * (s + 1);
+        coeffs.push_back(biquad_design(Biquad_Type::Peak, SAMPLE_RATE, hz, 0.7, 3.0));
+        coeffs_f64.push_back(biquad_design<float64>(Biquad_Type::Peak, SAMPLE_RATE, hz, 0.7, 3.0));
+    }
+
+    for (const auto block : BLOCKS) {
+        for (const auto channels : CHANNELS) {
+            auto signal = noise(static_cast<size_t>(block) * channels);
+            std::vector<float32*> ptrs(channels);
+            for (uint32 c = 0; c < channels; ++c)
+                ptrs[c] = signal.data() + static_cast<size_t>(c) * block;
+
+            std::vector<Biquad_State> state(sections * channels);
+            bench.run("biquad/scalar x4", block, channels, [&] {
+                for (uint32 c = 0; c < channels; ++c) {
+                    for (uint32 s = 0; s < sections; ++s)
+                        biquad_process(coeffs[s], state[s * channels + c], ptrs[c], ptrs[c], block);
+                }
+            });
+
+            std::fill(state.begin(), state.end(), Biquad_State{});
+            bench.run("biquad/planar x4", block, channels, [&] {
+                biquad_cascade_planar(coeffs.data(), sections, state.data(), ptrs.data(), channels, block);
+            });
+
+            std::vector<float64> signal_f64(signal.begin(), signal.end());
+            std::vector<float64*> ptrs_f64(channels);
+            for (uint32 c = 0; c < channels; ++c)
+                ptrs_f64[c] = signal_f64.data() + static_cast<size_t>(c) * block;
+            std::vector<Biquad_State_F64> state_f64(sections * channels);
+            bench.run("biquad/planar f64 x4", block, channels, [&] {
+                biquad_cascade_planar(
+                    coeffs_f64.data(), sections, state_f64.data(), ptrs_f64.data(), channels, block);
+            });
+
+            if (channels == 2) {
+                std::fill(state.begin(), state.end(), Biquad_State{});
+                bench.run("biquad/stereo x4", block, channels, [&] {
+                    biquad_cascade_stereo(coeffs.data(), sections, state.data(), signal.data(), block);
+                });
+            }
+        }
+
+        // a bank turns one input into many outputs; count each output as a channel
+        for (const uint32 filters : {8u, 32u}) {
+            Biquad_Bank bank;
+            bank.create(filters, 2);
+            for (uint32 f = 0; f < filters; ++f) {
+                for (uint32 s = 0; s < 2; ++s)
+                    bank.set(f, s, biquad_design(Biquad_Type::Bandpass, SAMPLE_RATE, 50.0 * (f + 1), 4.0));
+            }
+            const auto in = noise(block);
+            std::vector<float32> out(static_cast<size_t>(filters) * block);
+            std::vector<float32*> ptrs(filters);
+            for (uint32 f = 0; f < filters; ++f)
+                ptrs[f] = out.data() + static_cast<size_t>(f) * block;
+            bench.run("biquad/bank x2", block, filters, [&] { bank.process(in.data(), ptrs.data(), block); });
+        }
+    }
+}
+
+static void bench_fft(Bench_Runner& bench) {
+    for (uint32 size = 256; size <= 16384; size *= 2) {
+        auto* plan = mufft_create_plan_1d_r2c(size, MUFFT_FLAG_CPU_ANY);
+        auto* in = static_cast<float32*>(mufft_calloc(size * sizeof(float32)));
+        auto* out = static_cast<float32*>(mufft_calloc((size / 2 + 1) * 2 * sizeof(float32)));
+        const auto signal = noise(size);
+        std::memcpy(in, signal.data(), size * sizeof(float32));
+
+        bench.run("fft/r2c", size, 1, [&] { mufft_execute_plan_1d(plan, out, in); });
+
+        mufft_free(out);
+        mufft_free(in);
+        mufft_free_plan_1d(plan);
+    }
+}
+
+static void bench_convolver(Bench_Runner& bench) {
+    for (const auto ir_seconds : {0.1f, 1.f}) {
+        const auto ir_samples = noise(static_cast<size_t>(ir_seconds * SAMPLE_RATE), 2);
+        for (const uint32 partition : {64u, 256u, 1024u}) {
+            auto ir = std::make_shared<const Convolver_Ir>(ir_samples, partition);
+            Convolver conv;
+            conv.create(ir);
+
+            const uint32 block = 512;
+            const auto in = noise(block);
+            std::vector<float32> out(block);
+            const auto name = "convolver/ir " + std::to_string(ir_samples.size()) + " part " +
+                              std::to_string(partition);
+            bench.run(name, block, 1, [&] { conv.process(in.data(), out.data(), block); });
+        }
+    }
+}
+
+static void bench_fir(Bench_Runner& bench) {
+    const uint32 block = 512;
+    const auto in = noise(block);
+    std::vector<float32> out(static_cast<size_t>(block) * 4);
+
+    for (const uint32 taps : {31u, 127u, 511u}) {
+        auto h = fir_design_windowed_sinc(Fir_Response::Lowpass, taps, SAMPLE_RATE, 8000.0);
+        Fir_Filter folded;
+        folded.create(h, block);
+        bench.run("fir/folded " + std::to_string(taps) + " taps", block, 1, [&] {
+            folded.process(in.data(), out.data(), block);
+        });
+
+        // one nudged tap defeats the symmetry check
+        h[0] *= 1.0001f;
+        Fir_Filter direct;
+        direct.create(h, block);
+        bench.run("fir/direct " + std::to_string(taps) + " taps", block, 1, [&] {
+            direct.process(in.data(), out.data(), block);
+        });
+    }
+
+    for (const uint32 factor : {2u, 4u}) {
+        const auto h = fir_design_windowed_sinc(Fir_Response::Lowpass, 127, SAMPLE_RATE, 20000.0 / factor);
+        Fir_Decimator decimator;
+        decimator.create(h, factor, block);
+        bench.run("fir/decimate x" + std::to_string(factor) + " 127 taps", block, 1, [&] {
+            decimator.process(in.data(), block, out.data());
+        });
+
+        Fir_Interpolator interpolator;
+        interpolator.create(h, factor, block);
+        bench.run("fir/interpolate x" + std::to_string(factor) + " 127 taps", block, 1, [&] {
+            interpolator.process(in.data(), block, out.data());
+        });
+    }
+}
+
+// stereo, timed per output frame
+static void bench_resampler(Bench_Runner& bench) {
+    static constexpr std::string_view QUALITIES[] = {"draft", "normal", "high", "best"};
+    const uint32 block = 512;
+    std::vector<float32> out(static_cast<size_t>(block) * 2);
+
+    for (const auto& [from, to] : {std::pair{44100u, 48000u}, std::pair{48000u, 96000u}}) {
+        for (uint32 q = 0; q < std::size(QUALITIES); ++q) {
+            Sinc_Resampler resampler;
+            resampler.create(2, from, to, static_cast<Resampler_Quality>(q), block * 2);
+            const auto in = noise(static_cast<size_t>(resampler.input_frames_needed(block) + 64) * 2);
+            const auto name = "resampler/" + std::to_string(from) + "->" + std::to_string(to) + " " +
+                              std::string{QUALITIES[q]};
+            bench.run(name, block, 2, [&] {
+                const auto frames = resampler.input_frames_needed(block);
+                resampler.process(in.data(), frames, out.data(), block);
+            });
+        }
+    }
+}
+
+// the vectorized transcendentals against the scalar library calls they replace
+static void bench_math(Bench_Runner& bench) {
+    const uint32 block = 512;
+    const auto in = noise(block);
+    std::vector<float32> out(block);
+    const auto& kernels = dsp_kernels();
+
+    using Array_Fn = void (*)(const float32*, float32*, uint32);
+    using Scalar_Fn = float32 (*)(float32);
+    struct Math_Case final {
+        std::string_view name;
+        Array_Fn array;
+        Scalar_Fn scalar;
+    };
+    const Math_Case cases[] = {
+        {"exp", kernels.exp, [](float32 x) { return std::exp(x); }},
+        {"log", kernels.log, [](float32 x) { return std::log(std::abs(x)); }},
+        {"sin", kernels.sin, [](float32 x) { return std::sin(x); }},
+        {"tanh", kernels.tanh, [](float32 x) { return std::tanh(x); }},
+        {"db_to_linear", kernels.db_to_linear, [](float32 x) { return std::pow(10.f, x * 0.05f); }},
+    };
+
+    for (const auto& c : cases) {
+        bench.run("math/std " + std::string{c.name}, block, 1, [&] {
+            for (uint32 i = 0; i < block; ++i)
+                out[i] = c.scalar(in[i]);
+        });
+        bench.run("math/simd " + std::string{c.name}, block, 1, [&] {
+            c.array(in.data(), out.data(), block);
+        });
+    }
+}
+
+// a 20 band eq's curve at 2048 points, timed per point: every band with std::complex, every band with the
+// kernel, and the per-frame case of one band moving while the rest stay cached
+static void bench_response(Bench_Runner& bench) {
+    const uint32 points = 2048;
+    const uint32 bands = 20;
+    std::vector<Biquad_Coeffs> eq(bands);
+    for (uint32 b = 0; b < bands; ++b) {
+        const auto hz = 25.0 * std::pow(1.4, b);
+        eq[b] = biquad_design(Biquad_Type::Peak, SAMPLE_RATE, hz, 2.0, static_cast<float64>(b % 5) - 2.0);
+    }
+
+    Freq_Response response;
+    response.create(SAMPLE_RATE, points);
+    response.set_stage_count(1);
+    std::vector<float32> db(points);
+    bench.run("response/complex eq20", points, 1, [&] {
+        const auto freqs = response.freqs();
+        for (uint32 i = 0; i < points; ++i) {
+            const auto w = 2.f * Math_Consts<float32>::pi * freqs[i] / SAMPLE_RATE;
+            const auto z1 = std::polar(1.f, -w);
+            const auto z2 = z1 * z1;
+            std::complex<float32> h = 1.f;
+            for (const auto& c : eq)
+                h *= (c.b0 + c.b1 * z1 + c.b2 * z2) / (1.f + c.a1 * z1 + c.a2 * z2);
+            db[i] = 20.f * std::log10(std::abs(h));
+        }
+    });
+
+    uint32 moved = 0;
+    bench.run("response/all bands eq20", points, 1, [&] {
+        eq[moved].b0 = eq[moved].b0 == 1.f ? 1.001f : 1.f;
+        response.set_stage(0, {});
+        response.set_stage(0, eq);
+        response.update();
+    });
+    bench.run("response/one band eq20", points, 1, [&] {
+        moved = (moved + 1) % bands;
+        eq[moved].b0 = eq[moved].b0 == 1.f ? 1.001f : 1.f;
+        response.set_stage(0, eq);
+        response.update();
+    });
+}
+
+// timed per voice per frame, against a scalar loop over the same tables a voice at a time
+static void bench_wavetable(Bench_Runner& bench) {
+    const uint32 block = 256;
+    const auto table = std::make_shared<Wavetable>(Wavetable_Shape::Saw);
+    std::vector<float32> out(block);
+    Dsp_Buffer buffer{out.data(), 1, block};
+    const Dsp_Process_Args args{nullptr, nullptr, 0, &buffer, 1, block};
+
+    for (const uint32 voices : {1u, 16u, 256u}) {
+        Dsp_Wavetable_Node node{1, table, voices};
+        node.prepare({SAMPLE_RATE, block});
+        std::vector<float32> inc(voices);
+        std::vector<float32> phase(voices, 0.f);
+        for (uint32 v = 0; v < voices; ++v) {
+            const auto hz = 55.f * std::exp2(static_cast<float32>(v % 72) / 12.f);
+            node.set_voice(v, hz, 1.f / static_cast<float32>(voices));
+            inc[v] = hz / SAMPLE_RATE;
+        }
+
+        const auto name = " x" + std::to_string(voices);
+        bench.run("wavetable/scalar" + name, block, voices, [&] {
+            std::memset(out.data(), 0, block * sizeof(float32));
+            for (uint32 v = 0; v < voices; ++v) {
+                const auto* level = table->level(Wavetable::level_for(inc[v]));
+                auto p = phase[v];
+                for (uint32 i = 0; i < block; ++i) {
+                    const auto pos = p * static_cast<float32>(Wavetable::SIZE);
+                    const auto k = static_cast<uint32>(pos);
+                    out[i] += level[k] + (pos - static_cast<float32>(k)) * (level[k + 1] - level[k]);
+                    p += inc[v];
+                    p -= std::floor(p);
+                }
+                phase[v] = p;
+            }
+        });
+        bench.run("wavetable/node" + name, block, voices, [&] { node.process(args); });
+    }
+
+    // held notes through envelopes and filters, with the allocator's own per-chunk bookkeeping
+    for (const uint32 voices : {16u, 256u}) {
+        Voice_Allocator allocator{table, voices};
+        allocator.set_sample_rate(SAMPLE_RATE);
+        for (uint32 v = 0; v < voices; ++v)
+            allocator.note_on(v, static_cast<float32>(36 + v % 60), 0.8f);
+        bench.run("voices/held x" + std::to_string(voices), block, voices, [&] {
+            allocator.render(out.data(), block);
+        });
+    }
+}
+
+// a round trip up and back down, timed per base-rate frame
+static void bench_oversampler(Bench_Runner& bench) {
+    const uint32 block = 256;
+    const auto in = noise(block);
+    std::vector<float32> high(static_cast<size_t>(block) * Oversampler::MAX_FACTOR);
+    std::vector<float32> out(block);
+
+    for (const uint32 factor : {2u, 4u, 8u}) {
+        Oversampler oversampler;
+        oversampler.create(factor, block);
+        bench.run("oversampler/x" + std::to_string(factor), block, 1, [&] {
+            oversampler.upsample(in.data(), high.data(), block);
+            oversampler.downsample(high.data(), out.data(), block);
+        });
+    }
+}
+
+// the project encoding through the iostream helpers and through Enc_Writer and Enc_Reader, timed per
+// value: named parameters one at a time, then sample data as one array
+static void bench_enc(Bench_Runner& bench) {
+    for (const uint32 count : {64u, 4096u}) {
+        std::stringstream ss;
+        Enc_Writer writer;
+        bench.run("enc/stream params", count, 1, [&] {
+            ss.str({});
+            for (uint32 i = 0; i < count; ++i) {
+                enc_encode_string(ss, "filter.cutoff_hz");
+                enc_encode_one(ss, static_cast<float32>(i));
+            }
+        });
+        bench.run("enc/writer params", count, 1, [&] {
+            writer.clear();
+            for (uint32 i = 0; i < count; ++i) {
+                writer.encode_string("filter.cutoff_hz");
+                writer.encode_one(static_cast<float32>(i));
+            }
+        });
+
+        const auto encoded = writer.release();
+        const std::string encoded_str{reinterpret_cast<const char*>(encoded.data()), encoded.size()};
+        float32 sum = 0.f;
+        bench.run("enc/stream decode params", count, 1, [&] {
+            std::istringstream is{encoded_str};
+            for (uint32 i = 0; i < count; ++i) {
+                sum += static_cast<float32>(enc_decode_string(is).size());
+                sum += enc_decode_one<float32>(is);
+            }
+        });
+        bench.run("enc/reader params", count, 1, [&] {
+            Enc_Reader reader{encoded};
+            for (uint32 i = 0; i < count; ++i) {
+                sum += static_cast<float32>(reader.decode_string()->size());
+                sum += *reader.decode_one<float32>();
+            }
+        });
+    }
+
+    for (const uint32 count : {4096u, 1u << 20}) {
+        const auto samples = noise(count);
+        std::stringstream ss;
+        Enc_Writer writer;
+        bench.run("enc/stream samples", count, 1, [&] {
+            ss.str({});
+            enc_encode_span(ss, std::span<const float32>{samples});
+        });
+        bench.run("enc/writer samples", count, 1, [&] {
+            writer.clear();
+            writer.encode_span(std::span<const float32>{samples});
+        });
+
+        const auto encoded = writer.release();
+        const std::string encoded_str{reinterpret_cast<const char*>(encoded.data()), encoded.size()};
+        float32 first = 0.f;
+        bench.run("enc/stream decode samples", count, 1, [&] {
+            std::istringstream is{encoded_str};
+            first += enc_decode_vec<float32>(is)[0];
+        });
+        // a view, nothing is copied
+        bench.run("enc/reader samples", count, 1, [&] {
+            Enc_Reader reader{encoded};
+            first += (*reader.decode_span<float32>())[0];
+        });
+    }
+}
+
+// a chain of gain nodes: nearly all of the time is the schedule's own per-step cost
+static void bench_graph(Bench_Runner& bench, Dsp_Worker_Pool& workers) {
+    for (const uint32 nodes : {4u, 64u}) {
+        for (const auto block : BLOCKS) {
+            Dsp_Graph graph;
+            auto prev = graph.add<Dsp_Sine_Node>(2, 440.f, 0.5f);
+            for (uint32 i = 0; i < nodes; ++i) {
+                const auto gain = graph.add<Dsp_Gain_Node>(2, 1.f);
+                graph.connect(prev, 0, gain, 0);
+                prev = gain;
+            }
+            const auto output = graph.add<Dsp_Device_Output_Node>(2);
+            graph.connect(prev, 0, output, 0);
+
+            Dsp_Schedule schedule;
+            schedule.compile(std::move(graph), SAMPLE_RATE, block, 2);
+            std::vector<float32> out(static_cast<size_t>(block) * 2);
+            bench.run("graph/chain " + std::to_string(nodes) + " gains", block, 2, [&] {
+                schedule.process(nullptr, out.data(), block);
+            });
+        }
+    }
+
+    // wide graph: independent filter tracks into a mixer, serial and spread over the worker pool
+    for (const uint32 tracks : {8u, 32u}) {
+        for (const bool parallel : {false, true}) {
+            Dsp_Graph graph;
+            const auto mixer = graph.add<Dsp_Mixer_Node>(2, tracks);
+            for (uint32 t = 0; t < tracks; ++t) {
+                const auto sine = graph.add<Dsp_Sine_Node>(2, 100.f + 10.f * t, 0.1f);
+                const auto eq = graph.add<Dsp_Graphic_Eq_Node>(2, 10);
+                graph.connect(sine, 0, eq, 0);
+                graph.connect(eq, 0, mixer, t);
+            }
+            const auto output = graph.add<Dsp_Device_Output_Node>(2);
+            graph.connect(mixer, 0, output, 0);
+
+            const uint32 block = 512;
+            Dsp_Schedule schedule;
+            schedule.compile(std::move(graph), SAMPLE_RATE, block, 2);
+            if (parallel)
+                schedule.set_worker_pool(&workers);
+            std::vector<float32> out(static_cast<size_t>(block) * 2);
+            const auto name = "graph/" + std::to_string(tracks) + " eq tracks " +
+                              (schedule.parallel() ? "parallel" : "serial");
+            bench.run(name, block, 2 * tracks, [&] { schedule.process(nullptr, out.data(), block); });
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    Bench_Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc)
+            options.filter = argv[++i];
+        else if (arg == "--min-time" && i + 1 < argc)
+            options.min_time = std::atof(argv[++i]);
+        else if (arg == "--csv")
+            options.csv = true;
+        else if (arg == "--isa" && i + 1 < argc) {
+            const auto isa = cpu_isa_from_name(argv[++i]);
+            if (!isa || !dsp_force_isa(*isa)) {
+                std::fprintf(stderr, "%s isn't built or not supported by this cpu\n", argv[i]);
+                return 1;
+            }
+        } else {
+            std::fprintf(
+                stderr, "usage: %s [--filter <substring>] [--min-time <seconds>] [--csv] [--isa <name>]\n",
+                argv[0]);
+            return 1;
+        }
+    }
+    if (!options.csv)
+        std::printf("kernels: %s\n", std::string{cpu_isa_name(dsp_kernels().isa)}.c_str());
+
+    Dsp_Worker_Pool workers;
+    const auto cores = std::thread::hardware_concurrency();
+    workers.create(cores > 1 ? cores - 1 : 0);
+
+    Bench_Runner bench{options};
+    bench_biquad(bench);
+    bench_fft(bench);
+    bench_convolver(bench);
+    bench_fir(bench);
+    bench_resampler(bench);
+    bench_oversampler(bench);
+    bench_math(bench);
+    bench_response(bench);
+    bench_wavetable(bench);
+    bench_enc(bench);
+    bench_graph(bench, workers);
+
+    workers.destroy();
+    return 0;
+}
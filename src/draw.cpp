@@ -63,6 +63,16 @@ void Draw_List::execute() {
             nvgLineTo(m_nvg, cmd.p1.x, cmd.p1.y);
             cmd.paint.apply(m_nvg, Rect2_F32::from_point_fit(cmd.p0, cmd.p1));
         },
+        [&](const Cmd_Path& cmd) {
+            if (cmd.points.empty())
+                return;
+            nvgBeginPath(m_nvg);
+            nvgMoveTo(m_nvg, cmd.points[0].x, cmd.points[0].y);
+            for (size_t i = 1; i < cmd.points.size(); ++i)
+                nvgLineTo(m_nvg, cmd.points[i].x, cmd.points[i].y);
+            nvgLineJoin(m_nvg, NVG_ROUND);
+            cmd.paint.apply(m_nvg, cmd.bounds);
+        },
         [&](const Cmd_Text& cmd) {
             nvgFontFace(m_nvg, get_font_name(cmd.font));
             nvgFontSize(m_nvg, cmd.size);
@@ -213,6 +223,17 @@ void Draw_List::stroke_line(Vector2_F32 p0, Vector2_F32 p1, NVGcolor color, floa
     m_list[m_layer].cmds.emplace_back(cmdline);
 }
 
+void Draw_List::stroke_polyline(std::span<const Vector2_F32> points, NVGcolor color, float32 stroke_width) {
+    Cmd_Path cmdpath;
+    cmdpath.points.assign(points.begin(), points.end());
+    cmdpath.bounds = Rect2_F32::from_point_list_fit(cmdpath.points);
+    cmdpath.paint.stroke = true;
+    cmdpath.paint.width = stroke_width;
+    cmdpath.paint.color = color;
+
+    m_list[m_layer].cmds.emplace_back(std::move(cmdpath));
+}
+
 Vector2_F32
 Draw_List::measure_text(std::string_view text, Draw_Font font, float32 size, float32* advance) const {
     nvgFontFace(m_nvg, get_font_name(font));
@@ -40,6 +40,7 @@ struct Draw_List final {
     void tb_grad_fill_circle(Vector2_F32 center, float32 radius, NVGcolor from, NVGcolor to);
 
     void stroke_line(Vector2_F32 p0, Vector2_F32 p1, NVGcolor color, float32 stroke_width);
+    void stroke_polyline(std::span<const Vector2_F32> points, NVGcolor color, float32 stroke_width);
 
     Vector2_F32
     measure_text(std::string_view text, Draw_Font font, float32 size, float32* advance = nullptr) const;
@@ -85,6 +86,12 @@ struct Draw_List final {
         Cmd_Paint paint;
     };
 
+    struct Cmd_Path final {
+        std::vector<Vector2_F32> points;
+        Rect2_F32 bounds;
+        Cmd_Paint paint;
+    };
+
     struct Cmd_Text final {
         Vector2_F32 pos;
         Text_Align align = Text_Align::Center_Middle;
@@ -99,7 +106,7 @@ struct Draw_List final {
         Rect2_F32 rect;
     };
 
-    using Command = std::variant<Cmd_Rect, Cmd_RRect, Cmd_Circle, Cmd_Line, Cmd_Text, Cmd_Clip>;
+    using Command = std::variant<Cmd_Rect, Cmd_RRect, Cmd_Circle, Cmd_Line, Cmd_Path, Cmd_Text, Cmd_Clip>;
 
     struct Layer {
         std::vector<Command> cmds;
@@ -0,0 +1,135 @@
+#include "analyzer.h"
+#include "kernels.h"
+
+#include <fft.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static float32* analyzer_alloc(size_t count) {
+    return static_cast<float32*>(mufft_calloc(std::max<size_t>(count, 1) * sizeof(float32)));
+}
+
+Spectrum_Analyzer::~Spectrum_Analyzer() {
+    destroy();
+}
+
+void Spectrum_Analyzer::create(uint32 sample_rate, uint32 channels, uint32 fft_size, uint32 hop) {
+    sb_ASSERT((fft_size & (fft_size - 1)) == 0); // mufft needs a power of two
+    sb_ASSERT(hop > 0 && hop <= fft_size);
+    sb_ASSERT(static_cast<size_t>(hop) * channels < RING_SIZE);
+    destroy();
+
+    m_sample_rate = sample_rate;
+    m_channels = channels;
+    m_fft_size = fft_size;
+    m_hop = hop;
+    m_filled = 0;
+    m_sequence = 0;
+
+    m_plan = mufft_create_plan_1d_r2c(fft_size, MUFFT_FLAG_CPU_ANY);
+    m_window = analyzer_alloc(fft_size);
+    m_history = analyzer_alloc(fft_size);
+    m_time = analyzer_alloc(fft_size);
+    m_spectrum = analyzer_alloc(static_cast<size_t>(fft_size / 2 + 1) * 2);
+    m_hop_samples.assign(static_cast<size_t>(hop) * channels, 0.f);
+
+    // periodic hann
+    float64 sum = 0.0;
+    for (uint32 i = 0; i < fft_size; ++i) {
+        const auto w = 0.5 - 0.5 * std::cos(2.0 * Math_Consts<float64>::pi * i / fft_size);
+        m_window[i] = static_cast<float32>(w);
+        sum += w;
+    }
+    m_norm = static_cast<float32>(2.0 / sum);
+
+    const auto bin_hz = static_cast<float32>(sample_rate) / static_cast<float32>(fft_size);
+    m_frames.for_each([&](Spectrum_Frame& frame) {
+        frame.magnitudes_db.assign(fft_size / 2 + 1, -std::numeric_limits<float32>::infinity());
+        frame.bin_hz = bin_hz;
+        frame.sequence = 0;
+    });
+
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread{[this] { run(); }};
+}
+
+void Spectrum_Analyzer::destroy() {
+    if (!m_plan)
+        return;
+
+    m_running.store(false, std::memory_order_release);
+    if (m_thread.joinable())
+        m_thread.join();
+    // whatever the thread left unread is at the old rate and would smear into the next create's first frames.
+    // the device is stopped before this, so with the thread gone nothing else touches the ring
+    m_ring.consumerClear();
+
+    mufft_free_plan_1d(m_plan);
+    for (auto* p : {m_window, m_history, m_time, m_spectrum})
+        mufft_free(p);
+    m_plan = nullptr;
+}
+
+void Spectrum_Analyzer::push(const float32* interleaved, uint32 frame_count) {
+    const auto count = static_cast<size_t>(frame_count) * m_channels;
+    if (count == 0 || m_ring.writeAvailable() < count)
+        return;
+    m_ring.writeBuff(interleaved, count);
+}
+
+const Spectrum_Frame& Spectrum_Analyzer::latest() {
+    m_frames.update();
+    return m_frames.read_slot();
+}
+
+void Spectrum_Analyzer::run() {
+    const auto count = m_hop_samples.size();
+    // wake a few times per hop so frames go out close to when their samples arrive
+    const auto idle = std::chrono::microseconds{static_cast<int64>(m_hop) * 250'000 / m_sample_rate};
+
+    while (m_running.load(std::memory_order_acquire)) {
+        if (m_ring.readAvailable() < count) {
+            std::this_thread::sleep_for(idle);
+            continue;
+        }
+
+        m_ring.readBuff(m_hop_samples.data(), count);
+
+        // slide the mono history along by one hop, downmixing the new samples onto the end
+        std::memmove(m_history, m_history + m_hop, (m_fft_size - m_hop) * sizeof(float32));
+        auto* dst = m_history + (m_fft_size - m_hop);
+        const auto gain = 1.f / static_cast<float32>(m_channels);
+        for (uint32 i = 0; i < m_hop; ++i) {
+            float32 sum = 0.f;
+            for (uint32 c = 0; c < m_channels; ++c)
+                sum += m_hop_samples[static_cast<size_t>(i) * m_channels + c];
+            dst[i] = sum * gain;
+        }
+
+        m_filled = std::min(m_filled + m_hop, m_fft_size);
+        if (m_filled == m_fft_size)
+            analyze();
+    }
+}
+
+void Spectrum_Analyzer::analyze() {
+    for (uint32 i = 0; i < m_fft_size; ++i)
+        m_time[i] = m_history[i] * m_window[i];
+    mufft_execute_plan_1d(m_plan, m_spectrum, m_time);
+
+    auto& frame = m_frames.write_slot();
+    const auto norm2 = m_norm * m_norm;
+    const auto bins = m_fft_size / 2 + 1;
+    for (uint32 k = 0; k < bins; ++k) {
+        const auto re = m_spectrum[k * 2];
+        const auto im = m_spectrum[k * 2 + 1];
+        frame.magnitudes_db[k] = std::max((re * re + im * im) * norm2, 1e-20f);
+    }
+    // a power ratio, so half of 20 * log10
+    dsp_kernels().linear_to_db(frame.magnitudes_db.data(), frame.magnitudes_db.data(), bins);
+    for (uint32 k = 0; k < bins; ++k)
+        frame.magnitudes_db[k] *= 0.5f;
+    frame.sequence = ++m_sequence;
+    m_frames.publish();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "triple_buffer.h"
+
+#include <ringbuffer.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+struct mufft_plan_1d;
+
+struct Spectrum_Frame final {
+    // fft_size / 2 + 1 bins, dB relative to a full scale sine
+    std::vector<float32> magnitudes_db;
+    float32 bin_hz = 0.f;
+    // counts analysed hops, 0 until the first one lands
+    uint64 sequence = 0;
+};
+
+// live spectrum of the device output. the audio thread only copies samples into a ring buffer, a
+// background thread runs hann windowed stfts with plans and buffers allocated in create(), and the ui
+// thread picks up the newest frame through a triple buffer.
+class Spectrum_Analyzer final {
+  public:
+    // interleaved samples, about 340 ms of stereo at 48 kHz
+    static constexpr size_t RING_SIZE = 1 << 15;
+
+    Spectrum_Analyzer() = default;
+    ~Spectrum_Analyzer();
+
+    Spectrum_Analyzer(const Spectrum_Analyzer&) = delete;
+    Spectrum_Analyzer& operator=(const Spectrum_Analyzer&) = delete;
+
+    void create(uint32 sample_rate, uint32 channels, uint32 fft_size = 4096, uint32 hop = 1024);
+    void destroy();
+
+    // audio thread. a period that doesn't fit because the analysis thread fell behind is dropped whole so
+    // the channels stay aligned.
+    void push(const float32* interleaved, uint32 frame_count);
+
+    // ui thread. the newest frame, valid until the next call
+    const Spectrum_Frame& latest();
+
+  private:
+    void run();
+    void analyze();
+
+    jnk0le::Ringbuffer<float32, RING_SIZE> m_ring;
+    Triple_Buffer<Spectrum_Frame> m_frames;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running = false;
+
+    uint32 m_sample_rate = 0;
+    uint32 m_channels = 0;
+    uint32 m_fft_size = 0;
+    uint32 m_hop = 0;
+    // mono frames in m_history so far, analysis starts once it's full
+    uint32 m_filled = 0;
+    uint64 m_sequence = 0;
+
+    mufft_plan_1d* m_plan = nullptr;
+    float32* m_window = nullptr;
+    float32* m_history = nullptr;
+    float32* m_time = nullptr;
+    float32* m_spectrum = nullptr;
+    // one hop of interleaved samples read from the ring
+    std::vector<float32> m_hop_samples;
+    // scales a bin magnitude so a full scale sine reads 0 dB
+    float32 m_norm = 1.f;
+};
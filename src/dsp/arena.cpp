@@ -0,0 +1,60 @@
+#include "arena.h"
+
+#include <cstring>
+#include <new>
+
+static constexpr size_t ARENA_ALIGN = 64;
+
+Dsp_Arena::~Dsp_Arena() {
+    destroy();
+}
+
+void Dsp_Arena::create(size_t capacity, std::pmr::memory_resource* upstream) {
+    destroy();
+
+    m_upstream = upstream;
+    m_capacity = capacity;
+    m_used = 0;
+    m_overflow = 0;
+    m_block = static_cast<std::byte*>(::operator new(capacity, std::align_val_t{ARENA_ALIGN}));
+    // commit every page now rather than on the audio thread
+    std::memset(m_block, 0, capacity);
+}
+
+void Dsp_Arena::destroy() {
+    if (!m_block)
+        return;
+    ::operator delete(m_block, std::align_val_t{ARENA_ALIGN});
+    m_block = nullptr;
+    m_capacity = 0;
+    m_used = 0;
+}
+
+void Dsp_Arena::reset() {
+    m_used = 0;
+    m_overflow = 0;
+}
+
+void* Dsp_Arena::do_allocate(size_t bytes, size_t alignment) {
+    const auto begin = (m_used + alignment - 1) & ~(alignment - 1);
+    if (m_block && begin + bytes <= m_capacity) {
+        m_used = begin + bytes;
+        return m_block + begin;
+    }
+    m_overflow += bytes;
+    return m_upstream->allocate(bytes, alignment);
+}
+
+void Dsp_Arena::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    if (!owns(p))
+        m_upstream->deallocate(p, bytes, alignment);
+}
+
+bool Dsp_Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+bool Dsp_Arena::owns(const void* p) const {
+    const auto* b = static_cast<const std::byte*>(p);
+    return m_block && b >= m_block && b < m_block + m_capacity;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "util.h"
+
+#include <memory_resource>
+
+// bump allocator over one block reserved up front, for node state and the schedule's buffer pool.
+// the block is touched page by page when it's created so the audio thread never takes the first-use page
+// fault. deallocation is a no-op; reset() reclaims everything once nothing built from the arena is alive.
+// running out falls back to the upstream resource and is counted in overflow() so it can be reported.
+// not thread safe; graphs are built on one thread and the audio thread only touches what's already there.
+class Dsp_Arena final : public std::pmr::memory_resource {
+  public:
+    Dsp_Arena() = default;
+    ~Dsp_Arena() override;
+
+    Dsp_Arena(const Dsp_Arena&) = delete;
+    Dsp_Arena& operator=(const Dsp_Arena&) = delete;
+
+    void create(size_t capacity, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    void destroy();
+    void reset();
+
+    size_t capacity() const {
+        return m_capacity;
+    }
+
+    size_t used() const {
+        return m_used;
+    }
+
+    size_t overflow() const {
+        return m_overflow;
+    }
+
+  private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    bool owns(const void* p) const;
+
+    std::byte* m_block = nullptr;
+    size_t m_capacity = 0;
+    size_t m_used = 0;
+    size_t m_overflow = 0;
+    std::pmr::memory_resource* m_upstream = nullptr;
+};
@@ -0,0 +1,403 @@
+#include "biquad.h"
+#include "kernels.h"
+#include "simd_math.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+// frames transposed into registers at a time by the lane kernels
+static constexpr uint32 BIQUAD_CHUNK = 64;
+
+template <typename T>
+Biquad_Coeffs_T<T>
+biquad_design(Biquad_Type type, float64 sample_rate, float64 freq, float64 q, float64 gain_db) {
+    const auto w0 = 2.0 * Math_Consts<float64>::pi * clamp(1.0, sample_rate * 0.49, freq) / sample_rate;
+    const auto cos_w0 = std::cos(w0);
+    const auto alpha = std::sin(w0) / (2.0 * std::max(q, 1e-3));
+    const auto a = std::pow(10.0, gain_db / 40.0);
+
+    float64 b0 = 1.0, b1 = 0.0, b2 = 0.0, a0 = 1.0, a1 = 0.0, a2 = 0.0;
+    switch (type) {
+    case Biquad_Type::Lowpass:
+        b0 = (1.0 - cos_w0) / 2.0;
+        b1 = 1.0 - cos_w0;
+        b2 = b0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cos_w0;
+        a2 = 1.0 - alpha;
+        break;
+    case Biquad_Type::Highpass:
+        b0 = (1.0 + cos_w0) / 2.0;
+        b1 = -(1.0 + cos_w0);
+        b2 = b0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cos_w0;
+        a2 = 1.0 - alpha;
+        break;
+    case Biquad_Type::Bandpass:
+        b0 = alpha;
+        b1 = 0.0;
+        b2 = -alpha;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cos_w0;
+        a2 = 1.0 - alpha;
+        break;
+    case Biquad_Type::Notch:
+        b0 = 1.0;
+        b1 = -2.0 * cos_w0;
+        b2 = 1.0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cos_w0;
+        a2 = 1.0 - alpha;
+        break;
+    case Biquad_Type::Allpass:
+        b0 = 1.0 - alpha;
+        b1 = -2.0 * cos_w0;
+        b2 = 1.0 + alpha;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cos_w0;
+        a2 = 1.0 - alpha;
+        break;
+    case Biquad_Type::Peak:
+        b0 = 1.0 + alpha * a;
+        b1 = -2.0 * cos_w0;
+        b2 = 1.0 - alpha * a;
+        a0 = 1.0 + alpha / a;
+        a1 = -2.0 * cos_w0;
+        a2 = 1.0 - alpha / a;
+        break;
+    case Biquad_Type::Low_Shelf: {
+        const auto k = 2.0 * std::sqrt(a) * alpha;
+        b0 = a * ((a + 1.0) - (a - 1.0) * cos_w0 + k);
+        b1 = 2.0 * a * ((a - 1.0) - (a + 1.0) * cos_w0);
+        b2 = a * ((a + 1.0) - (a - 1.0) * cos_w0 - k);
+        a0 = (a + 1.0) + (a - 1.0) * cos_w0 + k;
+        a1 = -2.0 * ((a - 1.0) + (a + 1.0) * cos_w0);
+        a2 = (a + 1.0) + (a - 1.0) * cos_w0 - k;
+        break;
+    }
+    case Biquad_Type::High_Shelf: {
+        const auto k = 2.0 * std::sqrt(a) * alpha;
+        b0 = a * ((a + 1.0) + (a - 1.0) * cos_w0 + k);
+        b1 = -2.0 * a * ((a - 1.0) + (a + 1.0) * cos_w0);
+        b2 = a * ((a + 1.0) + (a - 1.0) * cos_w0 - k);
+        a0 = (a + 1.0) - (a - 1.0) * cos_w0 + k;
+        a1 = 2.0 * ((a - 1.0) - (a + 1.0) * cos_w0);
+        a2 = (a + 1.0) - (a - 1.0) * cos_w0 - k;
+        break;
+    }
+    }
+
+    return Biquad_Coeffs_T<T>{
+        .b0 = static_cast<T>(b0 / a0),
+        .b1 = static_cast<T>(b1 / a0),
+        .b2 = static_cast<T>(b2 / a0),
+        .a1 = static_cast<T>(a1 / a0),
+        .a2 = static_cast<T>(a2 / a0),
+    };
+}
+
+template <typename T>
+void biquad_process(
+    const Biquad_Coeffs_T<T>& c, Biquad_State_T<T>& s, const T* in, T* out, uint32 frame_count) {
+    auto s1 = s.s1;
+    auto s2 = s.s2;
+    for (uint32 i = 0; i < frame_count; ++i) {
+        const auto x = in[i];
+        const auto y = c.b0 * x + s1;
+        s1 = c.b1 * x - c.a1 * y + s2;
+        s2 = c.b2 * x - c.a2 * y;
+        out[i] = y;
+    }
+    s.s1 = s1;
+    s.s2 = s2;
+}
+
+template <typename T>
+void biquad_cascade_planar(
+    const Biquad_Coeffs_T<T>* sections, uint32 section_count, Biquad_State_T<T>* state, T* const* channels,
+    uint32 channel_count, uint32 frame_count) {
+    // stereo would fill two of the eight lanes; interleaved, both channels share one register instead
+    if constexpr (std::is_same_v<T, float32>) {
+        if (channel_count == 2) {
+            float32 frames[BIQUAD_CHUNK * 2];
+            for (uint32 f0 = 0; f0 < frame_count; f0 += BIQUAD_CHUNK) {
+                const auto n = std::min(BIQUAD_CHUNK, frame_count - f0);
+                auto* left = channels[0] + f0;
+                auto* right = channels[1] + f0;
+                for (uint32 i = 0; i < n; ++i) {
+                    frames[i * 2] = left[i];
+                    frames[i * 2 + 1] = right[i];
+                }
+                biquad_cascade_stereo(sections, section_count, state, frames, n);
+                for (uint32 i = 0; i < n; ++i) {
+                    left[i] = frames[i * 2];
+                    right[i] = frames[i * 2 + 1];
+                }
+            }
+            return;
+        }
+    }
+
+    constexpr auto L = BIQUAD_KERNEL_LANES;
+    const auto& kernels = dsp_kernels();
+
+    T buf[BIQUAD_CHUNK * L];
+    // b0, b1, b2, a1, a2 then s1, s2, each broadcast or gathered across the lanes
+    T coeffs[L * 5];
+    T lane_state[L * 2];
+
+    for (uint32 c0 = 0; c0 < channel_count; c0 += L) {
+        const auto lanes = std::min(L, channel_count - c0);
+        for (uint32 f0 = 0; f0 < frame_count; f0 += BIQUAD_CHUNK) {
+            const auto n = std::min(BIQUAD_CHUNK, frame_count - f0);
+
+            for (uint32 l = 0; l < L; ++l) {
+                const auto* src = l < lanes ? channels[c0 + l] + f0 : nullptr;
+                for (uint32 i = 0; i < n; ++i)
+                    buf[i * L + l] = src ? src[i] : T{0};
+            }
+
+            for (uint32 s = 0; s < section_count; ++s) {
+                const auto& c = sections[s];
+                auto* st = state + static_cast<size_t>(s) * channel_count + c0;
+                for (uint32 l = 0; l < L; ++l) {
+                    coeffs[l] = c.b0;
+                    coeffs[L + l] = c.b1;
+                    coeffs[L * 2 + l] = c.b2;
+                    coeffs[L * 3 + l] = c.a1;
+                    coeffs[L * 4 + l] = c.a2;
+                    lane_state[l] = l < lanes ? st[l].s1 : T{0};
+                    lane_state[L + l] = l < lanes ? st[l].s2 : T{0};
+                }
+                if constexpr (std::is_same_v<T, float64>)
+                    kernels.biquad_lanes_f64(coeffs, lane_state, buf, n);
+                else
+                    kernels.biquad_lanes(coeffs, lane_state, buf, n);
+                for (uint32 l = 0; l < lanes; ++l)
+                    st[l] = {lane_state[l], lane_state[L + l]};
+            }
+
+            for (uint32 l = 0; l < lanes; ++l) {
+                auto* dst = channels[c0 + l] + f0;
+                for (uint32 i = 0; i < n; ++i)
+                    dst[i] = buf[i * L + l];
+            }
+        }
+    }
+}
+
+template Biquad_Coeffs_T<float32> biquad_design<float32>(Biquad_Type, float64, float64, float64, float64);
+template Biquad_Coeffs_T<float64> biquad_design<float64>(Biquad_Type, float64, float64, float64, float64);
+template void biquad_process<float32>(
+    const Biquad_Coeffs&, Biquad_State&, const float32*, float32*, uint32);
+template void biquad_process<float64>(
+    const Biquad_Coeffs_F64&, Biquad_State_F64&, const float64*, float64*, uint32);
+template void biquad_cascade_planar<float32>(
+    const Biquad_Coeffs*, uint32, Biquad_State*, float32* const*, uint32, uint32);
+template void biquad_cascade_planar<float64>(
+    const Biquad_Coeffs_F64*, uint32, Biquad_State_F64*, float64* const*, uint32, uint32);
+
+void biquad_cascade_stereo(
+    const Biquad_Coeffs* sections, uint32 section_count, Biquad_State* state, float32* frames,
+    uint32 frame_count) {
+    for (uint32 s = 0; s < section_count; ++s) {
+        const auto& c = sections[s];
+        const auto b0 = _mm_set1_ps(c.b0);
+        const auto b1 = _mm_set1_ps(c.b1);
+        const auto b2 = _mm_set1_ps(c.b2);
+        const auto a1 = _mm_set1_ps(c.a1);
+        const auto a2 = _mm_set1_ps(c.a2);
+
+        auto* st = state + static_cast<size_t>(s) * 2;
+        auto z1 = _mm_setr_ps(st[0].s1, st[1].s1, 0.f, 0.f);
+        auto z2 = _mm_setr_ps(st[0].s2, st[1].s2, 0.f, 0.f);
+        for (uint32 i = 0; i < frame_count; ++i) {
+            auto* p = reinterpret_cast<double*>(frames + static_cast<size_t>(i) * 2);
+            const auto x = _mm_castpd_ps(_mm_load_sd(p));
+            const auto y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+            z1 = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(b1, x), z2), _mm_mul_ps(a1, y));
+            z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+            _mm_store_sd(p, _mm_castps_pd(y));
+        }
+
+        alignas(16) float32 out1[4];
+        alignas(16) float32 out2[4];
+        _mm_store_ps(out1, z1);
+        _mm_store_ps(out2, z2);
+        st[0] = {out1[0], out2[0]};
+        st[1] = {out1[1], out2[1]};
+    }
+}
+
+void Biquad_Bank::create(uint32 filter_count, uint32 stages) {
+    m_filter_count = filter_count;
+    m_stages = stages;
+    m_groups = (filter_count + LANES - 1) / LANES;
+    m_lanes.assign(static_cast<size_t>(m_groups) * stages, Lanes{});
+    for (auto& l : m_lanes) {
+        std::fill(std::begin(l.b0), std::end(l.b0), 1.f);
+    }
+}
+
+void Biquad_Bank::reset() {
+    for (auto& l : m_lanes) {
+        std::fill(std::begin(l.s1), std::end(l.s1), 0.f);
+        std::fill(std::begin(l.s2), std::end(l.s2), 0.f);
+    }
+}
+
+void Biquad_Bank::set(uint32 filter, uint32 stage, const Biquad_Coeffs& c) {
+    auto& l = lanes(filter / LANES, stage);
+    const auto i = filter % LANES;
+    l.b0[i] = c.b0;
+    l.b1[i] = c.b1;
+    l.b2[i] = c.b2;
+    l.a1[i] = c.a1;
+    l.a2[i] = c.a2;
+}
+
+void Biquad_Bank::design(
+    Biquad_Type type, float32 sample_rate, std::span<const float32> freqs, std::span<const float32> qs,
+    std::span<const float32> gains_db, uint32 stage) {
+    const auto one = _mm_set1_ps(1.f);
+    const auto two = _mm_set1_ps(2.f);
+    const auto half = _mm_set1_ps(0.5f);
+
+    for (uint32 f0 = 0; f0 < m_filter_count; f0 += 4) {
+        alignas(16) float32 f[4], q[4], g[4];
+        for (uint32 i = 0; i < 4; ++i) {
+            const auto k = f0 + i;
+            f[i] = k < freqs.size() ? clamp(1.f, sample_rate * 0.49f, freqs[k]) : 1000.f;
+            q[i] = k < qs.size() ? std::max(qs[k], 1e-3f) : 0.707f;
+            g[i] = k < gains_db.size() ? gains_db[k] : 0.f;
+        }
+
+        const auto w0 = _mm_mul_ps(_mm_load_ps(f), _mm_set1_ps(2.f * Math_Consts<float32>::pi / sample_rate));
+        const auto sn = simd_sin<Simd_F32x4>(w0);
+        const auto cs = simd_cos<Simd_F32x4>(w0);
+        const auto alpha = _mm_div_ps(sn, _mm_mul_ps(two, _mm_load_ps(q)));
+        // 10^(g / 40)
+        const auto a = simd_db_to_linear<Simd_F32x4>(_mm_mul_ps(_mm_load_ps(g), half));
+        const auto m2cs = _mm_mul_ps(_mm_set1_ps(-2.f), cs);
+
+        auto b0 = one, b1 = _mm_setzero_ps(), b2 = _mm_setzero_ps();
+        auto a0 = one, a1 = _mm_setzero_ps(), a2 = _mm_setzero_ps();
+        switch (type) {
+        case Biquad_Type::Lowpass:
+            b1 = _mm_sub_ps(one, cs);
+            b0 = _mm_mul_ps(b1, half);
+            b2 = b0;
+            a0 = _mm_add_ps(one, alpha);
+            a1 = m2cs;
+            a2 = _mm_sub_ps(one, alpha);
+            break;
+        case Biquad_Type::Highpass:
+            b0 = _mm_mul_ps(_mm_add_ps(one, cs), half);
+            b1 = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(one, cs));
+            b2 = b0;
+            a0 = _mm_add_ps(one, alpha);
+            a1 = m2cs;
+            a2 = _mm_sub_ps(one, alpha);
+            break;
+        case Biquad_Type::Bandpass:
+            b0 = alpha;
+            b1 = _mm_setzero_ps();
+            b2 = _mm_sub_ps(_mm_setzero_ps(), alpha);
+            a0 = _mm_add_ps(one, alpha);
+            a1 = m2cs;
+            a2 = _mm_sub_ps(one, alpha);
+            break;
+        case Biquad_Type::Notch:
+            b0 = one;
+            b1 = m2cs;
+            b2 = one;
+            a0 = _mm_add_ps(one, alpha);
+            a1 = m2cs;
+            a2 = _mm_sub_ps(one, alpha);
+            break;
+        case Biquad_Type::Allpass:
+            b0 = _mm_sub_ps(one, alpha);
+            b1 = m2cs;
+            b2 = _mm_add_ps(one, alpha);
+            a0 = _mm_add_ps(one, alpha);
+            a1 = m2cs;
+            a2 = _mm_sub_ps(one, alpha);
+            break;
+        case Biquad_Type::Peak: {
+            const auto aa = _mm_mul_ps(alpha, a);
+            const auto ad = _mm_div_ps(alpha, a);
+            b0 = _mm_add_ps(one, aa);
+            b1 = m2cs;
+            b2 = _mm_sub_ps(one, aa);
+            a0 = _mm_add_ps(one, ad);
+            a1 = m2cs;
+            a2 = _mm_sub_ps(one, ad);
+            break;
+        }
+        case Biquad_Type::Low_Shelf:
+        case Biquad_Type::High_Shelf: {
+            const auto k = _mm_mul_ps(_mm_mul_ps(two, _mm_sqrt_ps(a)), alpha);
+            const auto ap1 = _mm_add_ps(a, one);
+            const auto am1 = _mm_sub_ps(a, one);
+            const auto am1c = _mm_mul_ps(am1, cs);
+            const auto ap1c = _mm_mul_ps(ap1, cs);
+            if (type == Biquad_Type::Low_Shelf) {
+                b0 = _mm_mul_ps(a, _mm_add_ps(_mm_sub_ps(ap1, am1c), k));
+                b1 = _mm_mul_ps(_mm_mul_ps(two, a), _mm_sub_ps(am1, ap1c));
+                b2 = _mm_mul_ps(a, _mm_sub_ps(_mm_sub_ps(ap1, am1c), k));
+                a0 = _mm_add_ps(_mm_add_ps(ap1, am1c), k);
+                a1 = _mm_mul_ps(_mm_set1_ps(-2.f), _mm_add_ps(am1, ap1c));
+                a2 = _mm_sub_ps(_mm_add_ps(ap1, am1c), k);
+            } else {
+                b0 = _mm_mul_ps(a, _mm_add_ps(_mm_add_ps(ap1, am1c), k));
+                b1 = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(-2.f), a), _mm_add_ps(am1, ap1c));
+                b2 = _mm_mul_ps(a, _mm_sub_ps(_mm_add_ps(ap1, am1c), k));
+                a0 = _mm_add_ps(_mm_sub_ps(ap1, am1c), k);
+                a1 = _mm_mul_ps(two, _mm_sub_ps(am1, ap1c));
+                a2 = _mm_sub_ps(_mm_sub_ps(ap1, am1c), k);
+            }
+            break;
+        }
+        }
+
+        const auto inv = _mm_div_ps(one, a0);
+        auto& l = lanes(f0 / LANES, stage);
+        const auto i = f0 % LANES;
+        _mm_store_ps(l.b0 + i, _mm_mul_ps(b0, inv));
+        _mm_store_ps(l.b1 + i, _mm_mul_ps(b1, inv));
+        _mm_store_ps(l.b2 + i, _mm_mul_ps(b2, inv));
+        _mm_store_ps(l.a1 + i, _mm_mul_ps(a1, inv));
+        _mm_store_ps(l.a2 + i, _mm_mul_ps(a2, inv));
+    }
+}
+
+void Biquad_Bank::process(const float32* in, float32* const* out, uint32 frame_count) {
+    static_assert(LANES == BIQUAD_KERNEL_LANES);
+    const auto& kernels = dsp_kernels();
+
+    float32 buf[BIQUAD_CHUNK * LANES];
+
+    for (uint32 g = 0; g < m_groups; ++g) {
+        const auto active = std::min(LANES, m_filter_count - g * LANES);
+        for (uint32 f0 = 0; f0 < frame_count; f0 += BIQUAD_CHUNK) {
+            const auto n = std::min(BIQUAD_CHUNK, frame_count - f0);
+
+            for (uint32 i = 0; i < n; ++i)
+                std::fill_n(buf + i * LANES, LANES, in[f0 + i]);
+
+            // b0 through a2 and s1, s2 are laid out the way the kernel reads them
+            for (uint32 s = 0; s < m_stages; ++s) {
+                auto& l = lanes(g, s);
+                kernels.biquad_lanes(l.b0, l.s1, buf, n);
+            }
+
+            for (uint32 k = 0; k < active; ++k) {
+                auto* dst = out[g * LANES + k] + f0;
+                for (uint32 i = 0; i < n; ++i)
+                    dst[i] = buf[i * LANES + k];
+            }
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "util.h"
+
+#include <span>
+#include <vector>
+
+enum class Biquad_Type { Lowpass, Highpass, Bandpass, Notch, Allpass, Peak, Low_Shelf, High_Shelf };
+
+// normalized so that a0 == 1. the float64 sections and kernels are for filters whose poles sit too close to
+// the unit circle for float32, low cutoffs with a high q, which drift off tune and get noisy in single
+// precision.
+template <typename T>
+struct Biquad_Coeffs_T final {
+    T b0 = 1;
+    T b1 = 0;
+    T b2 = 0;
+    T a1 = 0;
+    T a2 = 0;
+
+    bool operator==(const Biquad_Coeffs_T&) const = default;
+};
+
+// transposed direct form II delay line
+template <typename T>
+struct Biquad_State_T final {
+    T s1 = 0;
+    T s2 = 0;
+};
+
+using Biquad_Coeffs = Biquad_Coeffs_T<float32>;
+using Biquad_Coeffs_F64 = Biquad_Coeffs_T<float64>;
+using Biquad_State = Biquad_State_T<float32>;
+using Biquad_State_F64 = Biquad_State_T<float64>;
+
+// rbj audio eq cookbook. the following are instantiated for float32 and float64.
+template <typename T = float32>
+Biquad_Coeffs_T<T>
+biquad_design(Biquad_Type type, float64 sample_rate, float64 freq, float64 q, float64 gain_db = 0.0);
+
+template <typename T>
+void biquad_process(
+    const Biquad_Coeffs_T<T>& c, Biquad_State_T<T>& s, const T* in, T* out, uint32 frame_count);
+
+// cascade applied in place to each planar channel, eight channels at a time. float32 stereo is interleaved
+// through biquad_cascade_stereo instead. state is indexed [section * channel_count + channel].
+template <typename T>
+void biquad_cascade_planar(
+    const Biquad_Coeffs_T<T>* sections, uint32 section_count, Biquad_State_T<T>* state, T* const* channels,
+    uint32 channel_count, uint32 frame_count);
+
+// cascade applied in place to interleaved stereo frames, both channels in one register.
+// state is indexed [section * 2 + channel].
+void biquad_cascade_stereo(
+    const Biquad_Coeffs* sections, uint32 section_count, Biquad_State* state, float32* frames,
+    uint32 frame_count);
+
+// many independent filters over one signal, each a cascade of `stages` sections, with coefficients and
+// state kept structure-of-arrays so a simd register holds the same section of adjacent filters.
+class Biquad_Bank final {
+  public:
+    static constexpr uint32 LANES = 8;
+
+    void create(uint32 filter_count, uint32 stages);
+    void reset();
+
+    void set(uint32 filter, uint32 stage, const Biquad_Coeffs& c);
+    // designs one stage of every filter at once, four filters per sse register (sin/cos/exp via
+    // simd_math.h). gains are ignored by the types that don't use them.
+    void design(
+        Biquad_Type type, float32 sample_rate, std::span<const float32> freqs, std::span<const float32> qs,
+        std::span<const float32> gains_db, uint32 stage = 0);
+
+    // out[i] receives filter i's output
+    void process(const float32* in, float32* const* out, uint32 frame_count);
+
+    uint32 filter_count() const {
+        return m_filter_count;
+    }
+
+  private:
+    struct alignas(32) Lanes final {
+        float32 b0[LANES];
+        float32 b1[LANES];
+        float32 b2[LANES];
+        float32 a1[LANES];
+        float32 a2[LANES];
+        float32 s1[LANES];
+        float32 s2[LANES];
+    };
+
+    Lanes& lanes(uint32 group, uint32 stage) {
+        return m_lanes[group * m_stages + stage];
+    }
+
+    uint32 m_filter_count = 0;
+    uint32 m_stages = 0;
+    uint32 m_groups = 0;
+    std::vector<Lanes> m_lanes;
+};
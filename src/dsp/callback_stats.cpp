@@ -0,0 +1,124 @@
+#include "callback_stats.h"
+
+#include <algorithm>
+#include <cstdio>
+
+static void store_max(std::atomic<float32>& target, float32 value) {
+    // only the audio thread writes, so a plain compare is enough
+    if (value > target.load(std::memory_order_relaxed))
+        target.store(value, std::memory_order_relaxed);
+}
+
+void Callback_Stats::record(int64 start_ns, int64 end_ns, uint32 frame_count, uint32 sample_rate) {
+    if (m_reset.exchange(false, std::memory_order_acquire)) {
+        m_callbacks.store(0, std::memory_order_relaxed);
+        m_xruns.store(0, std::memory_order_relaxed);
+        m_frames.store(0, std::memory_order_relaxed);
+        m_total_ns.store(0, std::memory_order_relaxed);
+        m_max_us.store(0.f, std::memory_order_relaxed);
+        m_max_jitter_us.store(0.f, std::memory_order_relaxed);
+        m_peak_load.store(0.f, std::memory_order_relaxed);
+        for (auto& bucket : m_histogram)
+            bucket.store(0, std::memory_order_relaxed);
+        m_window.fill(0);
+        m_window_pos = 0;
+        m_last_start_ns = 0;
+    }
+
+    const auto period_ns =
+        static_cast<int64>(frame_count) * 1'000'000'000 / std::max<uint32>(sample_rate, 1);
+    const auto duration_ns = end_ns - start_ns;
+    const auto load =
+        period_ns > 0 ? static_cast<float32>(duration_ns) / static_cast<float32>(period_ns) : 0.f;
+
+    // arrival jitter against the previous callback's period, so a device that changes period size mid
+    // stream doesn't read as jitter
+    float32 jitter_us = 0.f;
+    bool late = false;
+    if (m_last_start_ns != 0) {
+        const auto interval_ns = start_ns - m_last_start_ns;
+        const auto deviation_ns = interval_ns - m_last_period_ns;
+        jitter_us = static_cast<float32>(std::abs(deviation_ns)) / 1000.f;
+        late = deviation_ns > m_last_period_ns / 2;
+    }
+    m_last_start_ns = start_ns;
+    m_last_period_ns = period_ns;
+
+    const auto callbacks = m_callbacks.load(std::memory_order_relaxed) + 1;
+    const auto total_ns = m_total_ns.load(std::memory_order_relaxed) + duration_ns;
+    m_callbacks.store(callbacks, std::memory_order_relaxed);
+    m_total_ns.store(total_ns, std::memory_order_relaxed);
+    m_frames.store(m_frames.load(std::memory_order_relaxed) + frame_count, std::memory_order_relaxed);
+    if (load > 1.f || late)
+        m_xruns.store(m_xruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    const auto duration_us = static_cast<float32>(duration_ns) / 1000.f;
+    m_budget_us.store(static_cast<float32>(period_ns) / 1000.f, std::memory_order_relaxed);
+    m_last_us.store(duration_us, std::memory_order_relaxed);
+    m_last_jitter_us.store(jitter_us, std::memory_order_relaxed);
+    m_load.store(load, std::memory_order_relaxed);
+    store_max(m_max_us, duration_us);
+    store_max(m_max_jitter_us, jitter_us);
+    store_max(m_peak_load, load);
+
+    constexpr auto last_bucket = Callback_Stats_Snapshot::BUCKETS - 1;
+    const auto bucket = static_cast<uint8>(
+        std::min<uint32>(static_cast<uint32>(load / Callback_Stats_Snapshot::BUCKET_LOAD), last_bucket));
+    if (callbacks > WINDOW)
+        m_histogram[m_window[m_window_pos]].fetch_sub(1, std::memory_order_relaxed);
+    m_histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_window[m_window_pos] = bucket;
+    m_window_pos = (m_window_pos + 1) % WINDOW;
+}
+
+Callback_Stats_Snapshot Callback_Stats::snapshot() const {
+    Callback_Stats_Snapshot s;
+    s.callbacks = m_callbacks.load(std::memory_order_relaxed);
+    s.xruns = m_xruns.load(std::memory_order_relaxed);
+    s.frames = m_frames.load(std::memory_order_relaxed);
+    s.budget_us = m_budget_us.load(std::memory_order_relaxed);
+    s.last_us = m_last_us.load(std::memory_order_relaxed);
+    s.max_us = m_max_us.load(std::memory_order_relaxed);
+    s.last_jitter_us = m_last_jitter_us.load(std::memory_order_relaxed);
+    s.max_jitter_us = m_max_jitter_us.load(std::memory_order_relaxed);
+    s.load = m_load.load(std::memory_order_relaxed);
+    s.peak_load = m_peak_load.load(std::memory_order_relaxed);
+    if (s.callbacks > 0)
+        s.mean_us = static_cast<float32>(m_total_ns.load(std::memory_order_relaxed)) / 1000.f /
+                    static_cast<float32>(s.callbacks);
+    for (uint32 i = 0; i < Callback_Stats_Snapshot::BUCKETS; ++i)
+        s.histogram[i] = m_histogram[i].load(std::memory_order_relaxed);
+    return s;
+}
+
+void Callback_Stats::reset() {
+    m_reset.store(true, std::memory_order_release);
+}
+
+bool Callback_Stats::dump(const char* path) const {
+    auto* file = std::fopen(path, "w");
+    if (!file)
+        return false;
+
+    const auto s = snapshot();
+    std::fprintf(file, "callbacks %llu\n", static_cast<unsigned long long>(s.callbacks));
+    std::fprintf(file, "frames %llu\n", static_cast<unsigned long long>(s.frames));
+    std::fprintf(file, "xruns %llu\n", static_cast<unsigned long long>(s.xruns));
+    std::fprintf(file, "budget_us %.1f\n", s.budget_us);
+    std::fprintf(file, "last_us %.1f\n", s.last_us);
+    std::fprintf(file, "mean_us %.1f\n", s.mean_us);
+    std::fprintf(file, "max_us %.1f\n", s.max_us);
+    std::fprintf(file, "last_jitter_us %.1f\n", s.last_jitter_us);
+    std::fprintf(file, "max_jitter_us %.1f\n", s.max_jitter_us);
+    std::fprintf(file, "load %.3f\n", s.load);
+    std::fprintf(file, "peak_load %.3f\n", s.peak_load);
+    std::fprintf(file, "\n# load_from load_to callbacks, last %u callbacks\n", WINDOW);
+    for (uint32 i = 0; i < Callback_Stats_Snapshot::BUCKETS; ++i) {
+        const auto from = static_cast<float32>(i) * Callback_Stats_Snapshot::BUCKET_LOAD;
+        const auto to = from + Callback_Stats_Snapshot::BUCKET_LOAD;
+        std::fprintf(file, "%.2f %.2f %u\n", from, to, s.histogram[i]);
+    }
+
+    std::fclose(file);
+    return true;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "util.h"
+
+#include <array>
+#include <atomic>
+
+struct Callback_Stats_Snapshot final {
+    static constexpr uint32 BUCKETS = 40;
+    // each histogram bucket covers this much of the period budget; the last one also takes everything over
+    static constexpr float32 BUCKET_LOAD = 0.05f;
+
+    uint64 callbacks = 0;
+    uint64 xruns = 0;
+    uint64 frames = 0;
+
+    // microseconds
+    float32 budget_us = 0.f;
+    float32 last_us = 0.f;
+    float32 mean_us = 0.f;
+    float32 max_us = 0.f;
+    float32 last_jitter_us = 0.f;
+    float32 max_jitter_us = 0.f;
+
+    // time spent in the callback over the period it had, 1 is the deadline
+    float32 load = 0.f;
+    float32 peak_load = 0.f;
+
+    // callback duration over budget, for the last Callback_Stats::WINDOW callbacks
+    std::array<uint32, BUCKETS> histogram = {};
+};
+
+// timing of the device callback, written by the audio thread and read from anywhere.
+// every field is a relaxed atomic so readers never block the writer; a snapshot can mix two consecutive
+// callbacks, which doesn't matter for a display.
+//
+// a callback counts as an xrun when it overran its period or arrived more than half a period late, since
+// miniaudio doesn't report underruns to the callback itself.
+class Callback_Stats final {
+  public:
+    // callbacks kept in the rolling histogram
+    static constexpr uint32 WINDOW = 1024;
+
+    // audio thread. start_ns/end_ns bracket the callback on a steady clock
+    void record(int64 start_ns, int64 end_ns, uint32 frame_count, uint32 sample_rate);
+
+    Callback_Stats_Snapshot snapshot() const;
+    void reset();
+
+    // writes the snapshot as text, false if the file couldn't be opened
+    bool dump(const char* path) const;
+
+  private:
+    using Atomic_F32 = std::atomic<float32>;
+
+    std::atomic<uint64> m_callbacks = 0;
+    std::atomic<uint64> m_xruns = 0;
+    std::atomic<uint64> m_frames = 0;
+    std::atomic<int64> m_total_ns = 0;
+
+    Atomic_F32 m_budget_us = 0.f;
+    Atomic_F32 m_last_us = 0.f;
+    Atomic_F32 m_max_us = 0.f;
+    Atomic_F32 m_last_jitter_us = 0.f;
+    Atomic_F32 m_max_jitter_us = 0.f;
+    Atomic_F32 m_load = 0.f;
+    Atomic_F32 m_peak_load = 0.f;
+
+    std::array<std::atomic<uint32>, Callback_Stats_Snapshot::BUCKETS> m_histogram = {};
+
+    // audio thread only: the bucket of each callback in the window, to take it back out when it falls off
+    std::array<uint8, WINDOW> m_window = {};
+    uint32 m_window_pos = 0;
+    int64 m_last_start_ns = 0;
+    int64 m_last_period_ns = 0;
+    // set by reset() on another thread, picked up by the next record()
+    std::atomic<bool> m_reset = false;
+};
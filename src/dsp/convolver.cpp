@@ -0,0 +1,209 @@
+#include "convolver.h"
+#include "kernels.h"
+#include "simd.h"
+
+#include <fft.h>
+#include <miniaudio.h>
+#include <algorithm>
+#include <cstring>
+
+static uint32 convolver_bin_stride(uint32 block_size) {
+    const auto bins = block_size + 1;
+    return (bins + SIMD_MAX_WIDTH - 1) / SIMD_MAX_WIDTH * SIMD_MAX_WIDTH;
+}
+
+static float32* convolver_alloc(size_t count) {
+    return static_cast<float32*>(mufft_calloc(std::max<size_t>(count, 1) * sizeof(float32)));
+}
+
+Convolver_Ir::Convolver_Ir(std::span<const float32> ir, uint32 block_size)
+    : m_block_size{block_size}, m_bin_stride{convolver_bin_stride(block_size)} {
+    sb_ASSERT((block_size & (block_size - 1)) == 0); // mufft needs a power of two
+    m_partitions = std::max<uint32>(1, static_cast<uint32>((ir.size() + block_size - 1) / block_size));
+
+    m_re = convolver_alloc(static_cast<size_t>(m_partitions) * m_bin_stride);
+    m_im = convolver_alloc(static_cast<size_t>(m_partitions) * m_bin_stride);
+
+    const auto fft_size = block_size * 2;
+    auto* plan = mufft_create_plan_1d_r2c(fft_size, MUFFT_FLAG_CPU_ANY);
+    auto* time = convolver_alloc(fft_size);
+    auto* spectrum = convolver_alloc(static_cast<size_t>(block_size + 1) * 2);
+
+    for (uint32 p = 0; p < m_partitions; ++p) {
+        // zero padded to twice the block so the circular convolution doesn't wrap
+        std::memset(time, 0, fft_size * sizeof(float32));
+        const auto begin = static_cast<size_t>(p) * block_size;
+        const auto count = std::min<size_t>(block_size, ir.size() - std::min(ir.size(), begin));
+        if (count > 0)
+            std::memcpy(time, ir.data() + begin, count * sizeof(float32));
+
+        mufft_execute_plan_1d(plan, spectrum, time);
+
+        auto* re = m_re + static_cast<size_t>(p) * m_bin_stride;
+        auto* im = m_im + static_cast<size_t>(p) * m_bin_stride;
+        for (uint32 k = 0; k <= block_size; ++k) {
+            re[k] = spectrum[k * 2];
+            im[k] = spectrum[k * 2 + 1];
+        }
+    }
+
+    mufft_free(spectrum);
+    mufft_free(time);
+    mufft_free_plan_1d(plan);
+}
+
+Convolver_Ir::~Convolver_Ir() {
+    mufft_free(m_re);
+    mufft_free(m_im);
+}
+
+Convolver::~Convolver() {
+    destroy();
+}
+
+void Convolver::create(std::shared_ptr<const Convolver_Ir> ir) {
+    destroy();
+
+    m_ir = std::move(ir);
+    m_block = m_ir->block_size();
+    m_bins = m_block + 1;
+
+    const auto fft_size = m_block * 2;
+    const auto stride = m_ir->bin_stride();
+    const auto partitions = m_ir->partitions();
+
+    m_forward = mufft_create_plan_1d_r2c(fft_size, MUFFT_FLAG_CPU_ANY);
+    m_inverse = mufft_create_plan_1d_c2r(fft_size, MUFFT_FLAG_CPU_ANY);
+
+    m_window = convolver_alloc(fft_size);
+    m_spectrum = convolver_alloc(static_cast<size_t>(m_bins) * 2);
+    m_time = convolver_alloc(fft_size);
+    m_fdl_re = convolver_alloc(static_cast<size_t>(partitions) * stride);
+    m_fdl_im = convolver_alloc(static_cast<size_t>(partitions) * stride);
+    m_acc_re = convolver_alloc(stride);
+    m_acc_im = convolver_alloc(stride);
+    m_in_fifo = convolver_alloc(m_block);
+    m_out_fifo = convolver_alloc(m_block);
+
+    reset();
+}
+
+void Convolver::destroy() {
+    if (!m_ir)
+        return;
+
+    mufft_free_plan_1d(m_forward);
+    mufft_free_plan_1d(m_inverse);
+    for (auto* p : {m_window, m_spectrum, m_time, m_fdl_re, m_fdl_im, m_acc_re, m_acc_im, m_in_fifo,
+                    m_out_fifo})
+        mufft_free(p);
+
+    m_ir.reset();
+}
+
+void Convolver::reset() {
+    const auto stride = m_ir->bin_stride();
+    const auto partitions = m_ir->partitions();
+    std::memset(m_window, 0, m_block * 2 * sizeof(float32));
+    std::memset(m_fdl_re, 0, static_cast<size_t>(partitions) * stride * sizeof(float32));
+    std::memset(m_fdl_im, 0, static_cast<size_t>(partitions) * stride * sizeof(float32));
+    std::memset(m_in_fifo, 0, m_block * sizeof(float32));
+    std::memset(m_out_fifo, 0, m_block * sizeof(float32));
+    m_fdl_pos = 0;
+    m_fifo_pos = 0;
+}
+
+void Convolver::process(const float32* in, float32* out, uint32 frame_count) {
+    for (uint32 done = 0; done < frame_count;) {
+        const auto n = std::min(frame_count - done, m_block - m_fifo_pos);
+        std::memcpy(m_in_fifo + m_fifo_pos, in + done, n * sizeof(float32));
+        std::memcpy(out + done, m_out_fifo + m_fifo_pos, n * sizeof(float32));
+        m_fifo_pos += n;
+        done += n;
+
+        if (m_fifo_pos == m_block) {
+            process_block();
+            m_fifo_pos = 0;
+        }
+    }
+}
+
+void Convolver::process_block() {
+    const auto& kernels = dsp_kernels();
+
+    const auto& ir = *m_ir;
+    const auto stride = ir.bin_stride();
+    const auto partitions = ir.partitions();
+
+    // overlap-save: transform the previous block followed by the new one
+    std::memcpy(m_window, m_window + m_block, m_block * sizeof(float32));
+    std::memcpy(m_window + m_block, m_in_fifo, m_block * sizeof(float32));
+    mufft_execute_plan_1d(m_forward, m_spectrum, m_window);
+
+    auto* fdl_re = m_fdl_re + static_cast<size_t>(m_fdl_pos) * stride;
+    auto* fdl_im = m_fdl_im + static_cast<size_t>(m_fdl_pos) * stride;
+    for (uint32 k = 0; k < m_bins; ++k) {
+        fdl_re[k] = m_spectrum[k * 2];
+        fdl_im[k] = m_spectrum[k * 2 + 1];
+    }
+
+    // acc = sum over p of input spectrum from p blocks ago times ir partition p
+    std::memset(m_acc_re, 0, stride * sizeof(float32));
+    std::memset(m_acc_im, 0, stride * sizeof(float32));
+    for (uint32 p = 0; p < partitions; ++p) {
+        const auto slot = (m_fdl_pos + partitions - p) % partitions;
+        const auto* xr = m_fdl_re + static_cast<size_t>(slot) * stride;
+        const auto* xi = m_fdl_im + static_cast<size_t>(slot) * stride;
+        kernels.complex_madd(xr, xi, ir.re(p), ir.im(p), m_acc_re, m_acc_im, stride);
+    }
+    m_fdl_pos = (m_fdl_pos + 1) % partitions;
+
+    for (uint32 k = 0; k < m_bins; ++k) {
+        m_spectrum[k * 2] = m_acc_re[k];
+        m_spectrum[k * 2 + 1] = m_acc_im[k];
+    }
+    mufft_execute_plan_1d(m_inverse, m_time, m_spectrum);
+
+    // the first half is wrapped-around garbage; mufft's inverse is unnormalized
+    const auto scale = 1.f / static_cast<float32>(m_block * 2);
+    for (uint32 i = 0; i < m_block; ++i)
+        m_out_fifo[i] = m_time[m_block + i] * scale;
+}
+
+std::optional<std::vector<float32>> convolver_load_ir(const char* path, uint32 sample_rate) {
+    const auto config = ma_decoder_config_init(ma_format_f32, 1, sample_rate);
+    ma_decoder decoder;
+    if (ma_decoder_init_file(path, &config, &decoder) != MA_SUCCESS)
+        return std::nullopt;
+
+    std::vector<float32> ir;
+    float32 chunk[4096];
+    ma_uint64 read = 0;
+    do {
+        // a short read comes back as MA_AT_END, so only the frame count matters
+        read = 0;
+        ma_decoder_read_pcm_frames(&decoder, chunk, std::size(chunk), &read);
+        ir.insert(ir.end(), chunk, chunk + read);
+    } while (read > 0);
+
+    ma_decoder_uninit(&decoder);
+    return ir;
+}
+
+Dsp_Convolver_Node::Dsp_Convolver_Node(uint32 channels, std::shared_ptr<const Convolver_Ir> ir)
+    : channels{channels} {
+    m_convolvers = std::make_unique<Convolver[]>(channels);
+    for (uint32 c = 0; c < channels; ++c)
+        m_convolvers[c].create(ir);
+}
+
+Dsp_Node_Desc Dsp_Convolver_Node::desc() const {
+    return {"Convolver", 1, 1, channels, m_convolvers[0].latency()};
+}
+
+void Dsp_Convolver_Node::process(const Dsp_Process_Args& args) {
+    const auto& in = args.inputs[0];
+    const auto& out = args.outputs[0];
+    for (uint32 c = 0; c < channels; ++c)
+        m_convolvers[c].process(in.channel(c), out.channel(c), args.frame_count);
+}
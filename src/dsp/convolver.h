@@ -0,0 +1,116 @@
+#pragma once
+
+#include "graph.h"
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+struct mufft_plan_1d;
+
+// impulse response cut into uniform partitions of block_size, each transformed once at load time and stored
+// split-complex. immutable after creation so it can be shared between channels and convolvers.
+class Convolver_Ir final {
+  public:
+    Convolver_Ir(std::span<const float32> ir, uint32 block_size);
+    ~Convolver_Ir();
+
+    Convolver_Ir(const Convolver_Ir&) = delete;
+    Convolver_Ir& operator=(const Convolver_Ir&) = delete;
+
+    uint32 block_size() const {
+        return m_block_size;
+    }
+
+    uint32 partitions() const {
+        return m_partitions;
+    }
+
+    // complex bins per partition, padded to a whole number of simd registers
+    uint32 bin_stride() const {
+        return m_bin_stride;
+    }
+
+    const float32* re(uint32 partition) const {
+        return m_re + static_cast<size_t>(partition) * m_bin_stride;
+    }
+
+    const float32* im(uint32 partition) const {
+        return m_im + static_cast<size_t>(partition) * m_bin_stride;
+    }
+
+  private:
+    uint32 m_block_size;
+    uint32 m_partitions;
+    uint32 m_bin_stride;
+    float32* m_re;
+    float32* m_im;
+};
+
+// uniformly partitioned overlap-save convolution with a frequency-domain delay line.
+// every block of block_size input frames costs one forward fft, one inverse fft and one complex
+// multiply-accumulate per partition, regardless of how the caller slices its frames.
+// output lags input by block_size frames.
+class Convolver final {
+  public:
+    Convolver() = default;
+    ~Convolver();
+
+    Convolver(const Convolver&) = delete;
+    Convolver& operator=(const Convolver&) = delete;
+
+    void create(std::shared_ptr<const Convolver_Ir> ir);
+    void destroy();
+    void reset();
+
+    void process(const float32* in, float32* out, uint32 frame_count);
+
+    uint32 latency() const {
+        return m_block;
+    }
+
+  private:
+    void process_block();
+
+    std::shared_ptr<const Convolver_Ir> m_ir;
+    uint32 m_block = 0;
+    uint32 m_bins = 0;
+
+    mufft_plan_1d* m_forward = nullptr;
+    mufft_plan_1d* m_inverse = nullptr;
+
+    // last two blocks of input, fed to the forward fft
+    float32* m_window = nullptr;
+    // interleaved complex scratch, shared by both transforms
+    float32* m_spectrum = nullptr;
+    float32* m_time = nullptr;
+
+    // ring of past input spectra, one per partition
+    float32* m_fdl_re = nullptr;
+    float32* m_fdl_im = nullptr;
+    uint32 m_fdl_pos = 0;
+
+    float32* m_acc_re = nullptr;
+    float32* m_acc_im = nullptr;
+
+    float32* m_in_fifo = nullptr;
+    float32* m_out_fifo = nullptr;
+    uint32 m_fifo_pos = 0;
+};
+
+// decodes any file miniaudio understands to mono float32 at sample_rate
+std::optional<std::vector<float32>> convolver_load_ir(const char* path, uint32 sample_rate);
+
+// convolves every channel with the same impulse response
+struct Dsp_Convolver_Node final {
+    Dsp_Convolver_Node(uint32 channels, std::shared_ptr<const Convolver_Ir> ir);
+
+    Dsp_Node_Desc desc() const;
+    void process(const Dsp_Process_Args& args);
+
+    uint32 channels;
+
+  private:
+    std::unique_ptr<Convolver[]> m_convolvers;
+};
@@ -0,0 +1,89 @@
+#include "cpu.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SB_CPU_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+static constexpr std::string_view CPU_ISA_NAMES[] = {"sse2", "avx2", "avx512", "neon"};
+
+#if defined(SB_CPU_X86)
+struct Cpu_Regs final {
+    uint32 eax = 0, ebx = 0, ecx = 0, edx = 0;
+};
+
+static Cpu_Regs cpuid(uint32 leaf, uint32 subleaf) {
+    Cpu_Regs r;
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuidex(regs, static_cast<int>(leaf), static_cast<int>(subleaf));
+    r = {static_cast<uint32>(regs[0]), static_cast<uint32>(regs[1]), static_cast<uint32>(regs[2]),
+         static_cast<uint32>(regs[3])};
+#else
+    if (!__get_cpuid_count(leaf, subleaf, &r.eax, &r.ebx, &r.ecx, &r.edx))
+        return {};
+#endif
+    return r;
+}
+
+// which register files the os saves on a context switch
+static uint64 xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32 lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<uint64>(hi) << 32) | lo;
+#endif
+}
+#endif
+
+Cpu_Isa cpu_detect_isa() {
+#if defined(SB_CPU_X86)
+    const auto leaf1 = cpuid(1, 0);
+    const auto osxsave = (leaf1.ecx >> 27) & 1;
+    const auto avx = (leaf1.ecx >> 28) & 1;
+    const auto fma = (leaf1.ecx >> 12) & 1;
+    if (!osxsave || !avx || !fma)
+        return Cpu_Isa::Sse2;
+
+    // xmm and ymm state, then opmask and both halves of the zmm state on top
+    const auto xcr0 = xgetbv0();
+    if ((xcr0 & 0x06) != 0x06 || cpuid(0, 0).eax < 7)
+        return Cpu_Isa::Sse2;
+
+    const auto leaf7 = cpuid(7, 0);
+    const auto avx2 = (leaf7.ebx >> 5) & 1;
+    const auto avx512f = (leaf7.ebx >> 16) & 1;
+    if (!avx2)
+        return Cpu_Isa::Sse2;
+    if (avx512f && (xcr0 & 0xe6) == 0xe6)
+        return Cpu_Isa::Avx512;
+    return Cpu_Isa::Avx2;
+#else
+    return Cpu_Isa::Neon;
+#endif
+}
+
+bool cpu_supports(Cpu_Isa isa) {
+    const auto best = cpu_detect_isa();
+    if (best == Cpu_Isa::Neon || isa == Cpu_Isa::Neon)
+        return best == isa;
+    return static_cast<uint32>(isa) <= static_cast<uint32>(best);
+}
+
+std::string_view cpu_isa_name(Cpu_Isa isa) {
+    return CPU_ISA_NAMES[static_cast<uint32>(isa)];
+}
+
+std::optional<Cpu_Isa> cpu_isa_from_name(std::string_view name) {
+    for (uint32 i = 0; i < std::size(CPU_ISA_NAMES); ++i) {
+        if (CPU_ISA_NAMES[i] == name)
+            return static_cast<Cpu_Isa>(i);
+    }
+    return std::nullopt;
+}
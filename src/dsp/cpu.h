@@ -0,0 +1,17 @@
+#pragma once
+
+#include "util.h"
+
+#include <optional>
+#include <string_view>
+
+// instruction set levels the hot dsp kernels are built for, lowest first on each architecture. neon
+// builds go through sse2neon, so they run the sse code paths.
+enum class Cpu_Isa { Sse2, Avx2, Avx512, Neon };
+
+// the highest level both the cpu and the os support. avx2 includes fma, avx-512 means the foundation set.
+Cpu_Isa cpu_detect_isa();
+bool cpu_supports(Cpu_Isa isa);
+
+std::string_view cpu_isa_name(Cpu_Isa isa);
+std::optional<Cpu_Isa> cpu_isa_from_name(std::string_view name);
@@ -0,0 +1,79 @@
+#include "kernels.h"
+
+#include <atomic>
+#include <cstdlib>
+
+// one per kernel variant the build compiled, see CMakeLists.txt
+#if defined(SB_KERNELS_SSE2)
+extern const Dsp_Kernels dsp_kernels_sse2;
+#endif
+#if defined(SB_KERNELS_AVX2)
+extern const Dsp_Kernels dsp_kernels_avx2;
+#endif
+#if defined(SB_KERNELS_AVX512)
+extern const Dsp_Kernels dsp_kernels_avx512;
+#endif
+#if defined(SB_KERNELS_NEON)
+extern const Dsp_Kernels dsp_kernels_neon;
+#endif
+
+static std::atomic<const Dsp_Kernels*> g_kernels{nullptr};
+
+static const Dsp_Kernels* kernels_for(Cpu_Isa isa) {
+    switch (isa) {
+#if defined(SB_KERNELS_SSE2)
+    case Cpu_Isa::Sse2:
+        return &dsp_kernels_sse2;
+#endif
+#if defined(SB_KERNELS_AVX2)
+    case Cpu_Isa::Avx2:
+        return &dsp_kernels_avx2;
+#endif
+#if defined(SB_KERNELS_AVX512)
+    case Cpu_Isa::Avx512:
+        return &dsp_kernels_avx512;
+#endif
+#if defined(SB_KERNELS_NEON)
+    case Cpu_Isa::Neon:
+        return &dsp_kernels_neon;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+static const Dsp_Kernels* select_kernels() {
+    if (const auto* name = std::getenv("SB_ISA")) {
+        const auto isa = cpu_isa_from_name(name);
+        if (isa && cpu_supports(*isa)) {
+            if (const auto* k = kernels_for(*isa))
+                return k;
+        }
+    }
+
+    // the best level that was built, working down from what the cpu supports
+    auto isa = cpu_detect_isa();
+    for (;;) {
+        if (const auto* k = kernels_for(isa))
+            return k;
+        sb_ASSERT(isa != Cpu_Isa::Sse2 && isa != Cpu_Isa::Neon);
+        isa = static_cast<Cpu_Isa>(static_cast<uint32>(isa) - 1);
+    }
+}
+
+const Dsp_Kernels& dsp_kernels() {
+    auto* k = g_kernels.load(std::memory_order_acquire);
+    if (!k) {
+        k = select_kernels();
+        g_kernels.store(k, std::memory_order_release);
+    }
+    return *k;
+}
+
+bool dsp_force_isa(Cpu_Isa isa) {
+    const auto* k = kernels_for(isa);
+    if (!k || !cpu_supports(isa))
+        return false;
+    g_kernels.store(k, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,481 @@
+#include "fir.h"
+#include "kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using Pi = Math_Consts<float64>;
+
+// remez grid points per cosine term, and exchange iterations before giving up
+static constexpr uint32 REMEZ_GRID_DENSITY = 16;
+static constexpr uint32 REMEZ_MAX_ITERATIONS = 64;
+
+float64 fir_kaiser_beta(float64 atten_db) {
+    if (atten_db > 50.0)
+        return 0.1102 * (atten_db - 8.7);
+    if (atten_db >= 21.0)
+        return 0.5842 * std::pow(atten_db - 21.0, 0.4) + 0.07886 * (atten_db - 21.0);
+    return 0.0;
+}
+
+uint32 fir_kaiser_taps(float64 atten_db, float64 transition_hz, float64 sample_rate) {
+    const auto width = 2.0 * Pi::pi * transition_hz / sample_rate;
+    const auto taps = static_cast<uint32>(std::ceil((atten_db - 7.95) / (2.285 * width))) + 1;
+    return std::max<uint32>(3, taps | 1);
+}
+
+// zeroth-order modified bessel function of the first kind, by its power series
+static float64 bessel_i0(float64 x) {
+    auto sum = 1.0;
+    auto term = 1.0;
+    const auto q = x * x * 0.25;
+    for (uint32 k = 1; k < 64 && term > sum * 1e-12; ++k) {
+        term *= q / static_cast<float64>(k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+float64 fir_window(Fir_Window window, float64 pos, float64 kaiser_beta) {
+    switch (window) {
+    case Fir_Window::Rectangular:
+        return 1.0;
+    case Fir_Window::Hann:
+        return 0.5 + 0.5 * std::cos(Pi::pi * pos);
+    case Fir_Window::Hamming:
+        return 0.54 + 0.46 * std::cos(Pi::pi * pos);
+    case Fir_Window::Blackman:
+        return 0.42 + 0.5 * std::cos(Pi::pi * pos) + 0.08 * std::cos(2.0 * Pi::pi * pos);
+    case Fir_Window::Kaiser:
+        return bessel_i0(kaiser_beta * std::sqrt(std::max(0.0, 1.0 - pos * pos))) / bessel_i0(kaiser_beta);
+    }
+    return 1.0;
+}
+
+// ideal lowpass with cutoff fc in cycles per sample, t frames from the centre
+static float64 sinc_lowpass(float64 fc, float64 t) {
+    if (t == 0.0)
+        return 2.0 * fc;
+    return std::sin(2.0 * Pi::pi * fc * t) / (Pi::pi * t);
+}
+
+std::vector<float32> fir_design_windowed_sinc(
+    Fir_Response response, uint32 taps, float64 sample_rate, float64 cutoff_hz, float64 cutoff2_hz,
+    Fir_Window window, float64 kaiser_beta) {
+    sb_ASSERT(taps > 0);
+    sb_ASSERT((taps & 1) || response == Fir_Response::Lowpass || response == Fir_Response::Bandpass);
+    const auto f1 = clamp(0.0, 0.5, cutoff_hz / sample_rate);
+    const auto f2 = clamp(f1, 0.5, cutoff2_hz / sample_rate);
+
+    // computed for the first half and mirrored so the result is exactly symmetric and folds
+    const auto centre = static_cast<float64>(taps - 1) * 0.5;
+    std::vector<float64> h(taps);
+    for (uint32 n = 0; n < (taps + 1) / 2; ++n) {
+        const auto t = static_cast<float64>(n) - centre;
+        const auto impulse = t == 0.0 ? 1.0 : 0.0;
+        float64 ideal = 0.0;
+        switch (response) {
+        case Fir_Response::Lowpass:
+            ideal = sinc_lowpass(f1, t);
+            break;
+        case Fir_Response::Highpass:
+            ideal = impulse - sinc_lowpass(f1, t);
+            break;
+        case Fir_Response::Bandpass:
+            ideal = sinc_lowpass(f2, t) - sinc_lowpass(f1, t);
+            break;
+        case Fir_Response::Bandstop:
+            ideal = impulse - sinc_lowpass(f2, t) + sinc_lowpass(f1, t);
+            break;
+        }
+        const auto pos = taps > 1 ? t / centre : 0.0;
+        h[n] = h[taps - 1 - n] = ideal * fir_window(window, pos, kaiser_beta);
+    }
+
+    // unity gain in the middle of the passband
+    auto ref = 0.0;
+    if (response == Fir_Response::Highpass)
+        ref = 0.5;
+    else if (response == Fir_Response::Bandpass)
+        ref = (f1 + f2) * 0.5;
+    auto re = 0.0, im = 0.0;
+    for (uint32 n = 0; n < taps; ++n) {
+        re += h[n] * std::cos(2.0 * Pi::pi * ref * n);
+        im -= h[n] * std::sin(2.0 * Pi::pi * ref * n);
+    }
+    const auto gain = std::hypot(re, im);
+    const auto scale = gain > 0.0 ? 1.0 / gain : 1.0;
+
+    std::vector<float32> out(taps);
+    for (uint32 n = 0; n < taps; ++n)
+        out[n] = static_cast<float32>(h[n] * scale);
+    return out;
+}
+
+namespace {
+
+// weighted chebyshev approximation on a dense grid, in x = cos(w). even-length filters carry a cos(w / 2)
+// factor, folded into the desired response and weight so both cases fit a plain cosine polynomial.
+struct Remez_Grid final {
+    std::vector<float64> x;
+    std::vector<float64> desired;
+    std::vector<float64> weight;
+    std::vector<uint32> band;
+};
+
+// barycentric lagrange interpolation through the points of one exchange iteration
+struct Remez_Interp final {
+    std::vector<float64> x;
+    std::vector<float64> y;
+    std::vector<float64> w;
+
+    void build(std::span<const float64> xs, std::span<const float64> ys) {
+        x.assign(xs.begin(), xs.end());
+        y.assign(ys.begin(), ys.end());
+        w = barycentric_weights(x);
+    }
+
+    float64 operator()(float64 at) const {
+        auto num = 0.0, den = 0.0;
+        for (size_t i = 0; i < x.size(); ++i) {
+            const auto d = at - x[i];
+            if (d == 0.0)
+                return y[i];
+            const auto c = w[i] / d;
+            num += c * y[i];
+            den += c;
+        }
+        return num / den;
+    }
+
+    // the factor of two keeps the products of differences in [-1, 1] near unit magnitude
+    static std::vector<float64> barycentric_weights(std::span<const float64> xs) {
+        std::vector<float64> w(xs.size());
+        for (size_t i = 0; i < xs.size(); ++i) {
+            auto prod = 1.0;
+            for (size_t j = 0; j < xs.size(); ++j)
+                if (j != i)
+                    prod *= 2.0 * (xs[i] - xs[j]);
+            w[i] = 1.0 / prod;
+        }
+        return w;
+    }
+};
+
+} // namespace
+
+std::optional<std::vector<float32>>
+fir_design_equiripple(uint32 taps, std::span<const Fir_Band> bands, float64 sample_rate) {
+    if (taps < 3 || bands.empty())
+        return std::nullopt;
+
+    const auto nyquist = sample_rate * 0.5;
+    auto prev = 0.0;
+    for (const auto& b : bands) {
+        if (b.low_hz < prev || b.high_hz <= b.low_hz || b.high_hz > nyquist || b.weight <= 0.0)
+            return std::nullopt;
+        prev = b.high_hz;
+    }
+
+    const auto odd = (taps & 1) != 0;
+    if (!odd && bands.back().high_hz >= nyquist && bands.back().gain != 0.0)
+        return std::nullopt;
+
+    // cosine terms; the exchange works on r + 1 extremal frequencies
+    const auto r = odd ? (taps + 1) / 2 : taps / 2;
+
+    auto total = 0.0;
+    for (const auto& b : bands)
+        total += b.high_hz - b.low_hz;
+    const auto spacing = total / sample_rate / static_cast<float64>(REMEZ_GRID_DENSITY * r);
+
+    Remez_Grid grid;
+    for (uint32 i = 0; i < bands.size(); ++i) {
+        const auto& b = bands[i];
+        auto lo = b.low_hz / sample_rate;
+        auto hi = b.high_hz / sample_rate;
+        // the cos(w / 2) factor is zero at nyquist
+        if (!odd)
+            hi = std::min(hi, 0.5 - spacing);
+        if (hi <= lo)
+            continue;
+        const auto points = std::max<uint32>(2, static_cast<uint32>(std::ceil((hi - lo) / spacing)) + 1);
+        for (uint32 p = 0; p < points; ++p) {
+            const auto f = lo + (hi - lo) * p / (points - 1);
+            const auto c = odd ? 1.0 : std::cos(Pi::pi * f);
+            grid.x.push_back(std::cos(2.0 * Pi::pi * f));
+            grid.desired.push_back(b.gain / c);
+            grid.weight.push_back(b.weight * c);
+            grid.band.push_back(i);
+        }
+    }
+
+    const auto size = static_cast<uint32>(grid.x.size());
+    if (size < r + 1)
+        return std::nullopt;
+
+    std::vector<uint32> ext(r + 1);
+    for (uint32 i = 0; i <= r; ++i)
+        ext[i] = static_cast<uint32>(static_cast<uint64>(i) * (size - 1) / r);
+
+    Remez_Interp interp;
+    std::vector<float64> xs(r + 1), ys(r + 1), error(size);
+    std::vector<uint32> found;
+    auto converged = false;
+
+    for (uint32 iteration = 0; iteration < REMEZ_MAX_ITERATIONS && !converged; ++iteration) {
+        for (uint32 i = 0; i <= r; ++i)
+            xs[i] = grid.x[ext[i]];
+
+        // the levelled error delta that makes the r + 1 points alternate exactly
+        const auto bary = Remez_Interp::barycentric_weights(xs);
+        auto num = 0.0, den = 0.0;
+        for (uint32 i = 0; i <= r; ++i) {
+            const auto sign = (i & 1) ? -1.0 : 1.0;
+            num += bary[i] * grid.desired[ext[i]];
+            den += bary[i] * sign / grid.weight[ext[i]];
+        }
+        if (den == 0.0)
+            return std::nullopt;
+        const auto delta = num / den;
+        for (uint32 i = 0; i <= r; ++i) {
+            const auto sign = (i & 1) ? -1.0 : 1.0;
+            ys[i] = grid.desired[ext[i]] - sign * delta / grid.weight[ext[i]];
+        }
+
+        // a degree r - 1 polynomial is pinned by r of the points
+        interp.build(std::span{xs}.first(r), std::span{ys}.first(r));
+        auto max_error = 0.0;
+        for (uint32 j = 0; j < size; ++j) {
+            error[j] = grid.weight[j] * (grid.desired[j] - interp(grid.x[j]));
+            max_error = std::max(max_error, std::abs(error[j]));
+        }
+
+        // local extrema, band edges included
+        found.clear();
+        for (uint32 j = 0; j < size; ++j) {
+            const auto e = error[j];
+            const auto has_left = j > 0 && grid.band[j - 1] == grid.band[j];
+            const auto has_right = j + 1 < size && grid.band[j + 1] == grid.band[j];
+            const auto left = has_left ? error[j - 1] : (e > 0.0 ? -HUGE_VAL : HUGE_VAL);
+            const auto right = has_right ? error[j + 1] : (e > 0.0 ? -HUGE_VAL : HUGE_VAL);
+            if ((e > 0.0 && e >= left && e >= right) || (e < 0.0 && e <= left && e <= right))
+                found.push_back(j);
+        }
+
+        // neighbours must alternate in sign; of a same-signed run only the largest survives
+        const auto alternate = [&] {
+            uint32 kept = 0;
+            for (uint32 i = 0; i < found.size(); ++i) {
+                if (kept > 0 && (error[found[kept - 1]] > 0.0) == (error[found[i]] > 0.0)) {
+                    if (std::abs(error[found[i]]) > std::abs(error[found[kept - 1]]))
+                        found[kept - 1] = found[i];
+                } else {
+                    found[kept++] = found[i];
+                }
+            }
+            found.resize(kept);
+        };
+        alternate();
+
+        // trim the smaller end until exactly r + 1 remain, which keeps the alternation intact
+        while (found.size() > r + 1) {
+            if (std::abs(error[found.front()]) < std::abs(error[found.back()]))
+                found.erase(found.begin());
+            else
+                found.pop_back();
+        }
+        if (found.size() < r + 1)
+            break;
+
+        converged = found == ext || max_error - std::abs(delta) <= 1e-6 * max_error;
+        ext = found;
+    }
+    if (!converged)
+        return std::nullopt;
+
+    // frequency sampling of the amplitude response around the whole circle. for even lengths the cos(w / 2)
+    // factor flips sign past nyquist, which is what keeps the inverse transform real.
+    std::vector<float64> amplitude(taps);
+    for (uint32 m = 0; m < taps; ++m) {
+        const auto w = 2.0 * Pi::pi * m / taps;
+        amplitude[m] = interp(std::cos(w)) * (odd ? 1.0 : std::cos(w * 0.5));
+    }
+
+    const auto centre = static_cast<float64>(taps - 1) * 0.5;
+    std::vector<float32> h(taps);
+    for (uint32 n = 0; n < (taps + 1) / 2; ++n) {
+        auto sum = 0.0;
+        for (uint32 m = 0; m < taps; ++m)
+            sum += amplitude[m] * std::cos(2.0 * Pi::pi * m / taps * (n - centre));
+        h[n] = h[taps - 1 - n] = static_cast<float32>(sum / taps);
+    }
+    return h;
+}
+
+Fir_Filter::Fir_Filter(const allocator_type& alloc) : m_taps{alloc}, m_history{alloc} {
+}
+
+Fir_Filter::Fir_Filter(Fir_Filter&& other, const allocator_type& alloc)
+    : m_taps{std::move(other.m_taps), alloc}, m_history{std::move(other.m_history), alloc},
+      m_max_frames{other.m_max_frames}, m_symmetric{other.m_symmetric} {
+}
+
+void Fir_Filter::create(std::span<const float32> taps, uint32 max_frames) {
+    sb_ASSERT(!taps.empty() && max_frames > 0);
+    m_taps.assign(taps.rbegin(), taps.rend());
+    m_max_frames = max_frames;
+    m_history.assign(taps.size() - 1 + max_frames, 0.f);
+
+    m_symmetric = true;
+    for (size_t k = 0; k < taps.size() / 2; ++k)
+        m_symmetric = m_symmetric && taps[k] == taps[taps.size() - 1 - k];
+}
+
+void Fir_Filter::reset() {
+    std::fill(m_history.begin(), m_history.end(), 0.f);
+}
+
+void Fir_Filter::process(const float32* in, float32* out, uint32 frame_count) {
+    const auto& kernels = dsp_kernels();
+    const auto taps = this->taps();
+    const auto history = taps - 1;
+    auto* x = m_history.data();
+    for (uint32 done = 0; done < frame_count;) {
+        const auto n = std::min(frame_count - done, m_max_frames);
+        std::memcpy(x + history, in + done, n * sizeof(float32));
+        if (m_symmetric)
+            kernels.fir_folded(x, m_taps.data(), taps, out + done, n);
+        else
+            kernels.fir(x, m_taps.data(), taps, out + done, n);
+        std::memmove(x, x + n, history * sizeof(float32));
+        done += n;
+    }
+}
+
+Fir_Decimator::Fir_Decimator(const allocator_type& alloc) : m_taps{alloc}, m_history{alloc} {
+}
+
+Fir_Decimator::Fir_Decimator(Fir_Decimator&& other, const allocator_type& alloc)
+    : m_taps{std::move(other.m_taps), alloc}, m_history{std::move(other.m_history), alloc},
+      m_factor{other.m_factor}, m_max_frames{other.m_max_frames}, m_skip{other.m_skip} {
+}
+
+void Fir_Decimator::create(std::span<const float32> taps, uint32 factor, uint32 max_input_frames) {
+    sb_ASSERT(!taps.empty() && factor > 0 && max_input_frames > 0);
+    m_taps.assign(taps.rbegin(), taps.rend());
+    m_factor = factor;
+    m_max_frames = max_input_frames;
+    m_history.assign(taps.size() - 1 + max_input_frames, 0.f);
+    m_skip = 0;
+}
+
+void Fir_Decimator::reset() {
+    std::fill(m_history.begin(), m_history.end(), 0.f);
+    m_skip = 0;
+}
+
+uint32 Fir_Decimator::process(const float32* in, uint32 frame_count, float32* out) {
+    const auto& kernels = dsp_kernels();
+    const auto taps = static_cast<uint32>(m_taps.size());
+    const auto history = taps - 1;
+    auto* x = m_history.data();
+    uint32 written = 0;
+    for (uint32 done = 0; done < frame_count;) {
+        const auto n = std::min(frame_count - done, m_max_frames);
+        std::memcpy(x + history, in + done, n * sizeof(float32));
+        auto i = m_skip;
+        for (; i < n; i += m_factor)
+            out[written++] = kernels.dot(x + i, m_taps.data(), taps);
+        m_skip = i - n;
+        std::memmove(x, x + n, history * sizeof(float32));
+        done += n;
+    }
+    return written;
+}
+
+Fir_Interpolator::Fir_Interpolator(const allocator_type& alloc)
+    : m_phases{alloc}, m_history{alloc}, m_scratch{alloc} {
+}
+
+Fir_Interpolator::Fir_Interpolator(Fir_Interpolator&& other, const allocator_type& alloc)
+    : m_phases{std::move(other.m_phases), alloc}, m_history{std::move(other.m_history), alloc},
+      m_scratch{std::move(other.m_scratch), alloc}, m_factor{other.m_factor},
+      m_phase_taps{other.m_phase_taps}, m_tap_count{other.m_tap_count}, m_max_frames{other.m_max_frames} {
+}
+
+void Fir_Interpolator::create(std::span<const float32> taps, uint32 factor, uint32 max_input_frames) {
+    sb_ASSERT(!taps.empty() && factor > 0 && max_input_frames > 0);
+    const auto count = static_cast<uint32>(taps.size());
+    m_factor = factor;
+    m_phase_taps = (count + factor - 1) / factor;
+    m_tap_count = count;
+    m_max_frames = max_input_frames;
+
+    // phase p holds taps p, p + factor, ... reversed, zero padded at the front
+    m_phases.assign(static_cast<size_t>(factor) * m_phase_taps, 0.f);
+    for (uint32 p = 0; p < factor; ++p) {
+        auto* phase = m_phases.data() + static_cast<size_t>(p) * m_phase_taps;
+        for (uint32 i = 0; i < m_phase_taps && i * factor + p < count; ++i)
+            phase[m_phase_taps - 1 - i] = taps[i * factor + p] * static_cast<float32>(factor);
+    }
+
+    m_history.assign(m_phase_taps - 1 + max_input_frames, 0.f);
+    m_scratch.assign(static_cast<size_t>(factor) * max_input_frames, 0.f);
+}
+
+void Fir_Interpolator::reset() {
+    std::fill(m_history.begin(), m_history.end(), 0.f);
+}
+
+void Fir_Interpolator::process(const float32* in, uint32 frame_count, float32* out) {
+    const auto& kernels = dsp_kernels();
+    const auto history = m_phase_taps - 1;
+    auto* x = m_history.data();
+    for (uint32 done = 0; done < frame_count;) {
+        const auto n = std::min(frame_count - done, m_max_frames);
+        std::memcpy(x + history, in + done, n * sizeof(float32));
+        for (uint32 p = 0; p < m_factor; ++p) {
+            kernels.fir(
+                x, m_phases.data() + static_cast<size_t>(p) * m_phase_taps, m_phase_taps,
+                m_scratch.data() + static_cast<size_t>(p) * m_max_frames, n);
+        }
+
+        auto* dst = out + static_cast<size_t>(done) * m_factor;
+        for (uint32 p = 0; p < m_factor; ++p) {
+            const auto* src = m_scratch.data() + static_cast<size_t>(p) * m_max_frames;
+            for (uint32 i = 0; i < n; ++i)
+                dst[i * m_factor + p] = src[i];
+        }
+        std::memmove(x, x + n, history * sizeof(float32));
+        done += n;
+    }
+}
+
+Dsp_Fir_Node::Dsp_Fir_Node(uint32 channels, std::span<const float32> taps)
+    : Dsp_Fir_Node{std::allocator_arg, {}, channels, taps} {
+}
+
+Dsp_Fir_Node::Dsp_Fir_Node(
+    std::allocator_arg_t, const allocator_type& alloc, uint32 channels, std::span<const float32> taps)
+    : channels{channels}, m_taps{taps.begin(), taps.end(), alloc}, m_filters{alloc} {
+    sb_ASSERT(!taps.empty());
+    m_filters.resize(channels);
+}
+
+Dsp_Node_Desc Dsp_Fir_Node::desc() const {
+    return {"FIR", 1, 1, channels, (static_cast<uint32>(m_taps.size()) - 1) / 2};
+}
+
+void Dsp_Fir_Node::prepare(const Dsp_Prepare& prepare) {
+    for (auto& filter : m_filters)
+        filter.create(m_taps, prepare.max_frames);
+}
+
+void Dsp_Fir_Node::process(const Dsp_Process_Args& args) {
+    const auto& in = args.inputs[0];
+    const auto& out = args.outputs[0];
+    for (uint32 c = 0; c < channels; ++c)
+        m_filters[c].process(in.channel(c), out.channel(c), args.frame_count);
+}
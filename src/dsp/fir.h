@@ -0,0 +1,168 @@
+#pragma once
+
+#include "graph.h"
+
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <vector>
+
+enum class Fir_Response { Lowpass, Highpass, Bandpass, Bandstop };
+
+enum class Fir_Window { Rectangular, Hann, Hamming, Blackman, Kaiser };
+
+// kaiser's empirical formulas: the beta and tap count that reach atten_db of stopband rejection with the
+// given transition width. the tap count is rounded up to odd so every response type can use it.
+float64 fir_kaiser_beta(float64 atten_db);
+uint32 fir_kaiser_taps(float64 atten_db, float64 transition_hz, float64 sample_rate);
+
+// window value at pos, which runs from -1 to 1 across the filter
+float64 fir_window(Fir_Window window, float64 pos, float64 kaiser_beta = 8.0);
+
+// linear-phase windowed sinc. cutoff2_hz is the upper edge for band responses and ignored otherwise.
+// highpass and bandstop need an odd tap count, since even-length symmetric filters are zero at nyquist.
+std::vector<float32> fir_design_windowed_sinc(
+    Fir_Response response, uint32 taps, float64 sample_rate, float64 cutoff_hz, float64 cutoff2_hz = 0.0,
+    Fir_Window window = Fir_Window::Kaiser, float64 kaiser_beta = 8.0);
+
+// piecewise-constant desired response; the gaps between bands are don't-care transition regions
+struct Fir_Band final {
+    float64 low_hz;
+    float64 high_hz;
+    float64 gain;
+    float64 weight = 1.0;
+};
+
+// parks-mcclellan: minimax-optimal linear-phase filter through the remez exchange. bands must be sorted
+// and non-overlapping within [0, sample_rate / 2]. fails on bad band specs, on a non-zero band at nyquist
+// with an even tap count, or when the exchange doesn't converge, which in practice means a spec whose
+// ripple would sit far below float32 precision.
+std::optional<std::vector<float32>>
+fir_design_equiripple(uint32 taps, std::span<const Fir_Band> bands, float64 sample_rate);
+
+// direct-form convolution over a linear history buffer, vectorized across output frames and blocked
+// over taps so a tile of coefficients and the input it touches stay in l1. symmetric tap sets (every
+// linear-phase design above) are folded, adding the two mirrored inputs before a single multiply.
+class Fir_Filter final {
+  public:
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    explicit Fir_Filter(const allocator_type& alloc = {});
+    Fir_Filter(Fir_Filter&& other, const allocator_type& alloc);
+
+    // allocates; max_frames only bounds the history buffer, longer calls are split
+    void create(std::span<const float32> taps, uint32 max_frames);
+    void reset();
+
+    void process(const float32* in, float32* out, uint32 frame_count);
+
+    uint32 taps() const {
+        return static_cast<uint32>(m_taps.size());
+    }
+
+    bool symmetric() const {
+        return m_symmetric;
+    }
+
+    // group delay of a linear-phase filter, in frames
+    uint32 latency() const {
+        return (taps() - 1) / 2;
+    }
+
+  private:
+    // reversed, so output n is the dot product of m_taps with m_history[n, n + taps)
+    std::pmr::vector<float32> m_taps;
+    // taps - 1 frames of past input followed by the current block
+    std::pmr::vector<float32> m_history;
+    uint32 m_max_frames = 0;
+    bool m_symmetric = false;
+};
+
+// filters then keeps every factor-th frame, only ever computing the frames it keeps
+class Fir_Decimator final {
+  public:
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    explicit Fir_Decimator(const allocator_type& alloc = {});
+    Fir_Decimator(Fir_Decimator&& other, const allocator_type& alloc);
+
+    void create(std::span<const float32> taps, uint32 factor, uint32 max_input_frames);
+    void reset();
+
+    // returns the number of frames written, which depends on where the previous call left off.
+    // out must hold frame_count / factor + 1 frames.
+    uint32 process(const float32* in, uint32 frame_count, float32* out);
+
+    uint32 factor() const {
+        return m_factor;
+    }
+
+    // in input frames
+    uint32 latency() const {
+        return (static_cast<uint32>(m_taps.size()) - 1) / 2;
+    }
+
+  private:
+    std::pmr::vector<float32> m_taps;
+    std::pmr::vector<float32> m_history;
+    uint32 m_factor = 1;
+    uint32 m_max_frames = 0;
+    // input frames to skip before the next kept output
+    uint32 m_skip = 0;
+};
+
+// upsamples by factor without ever multiplying the zeros stuffed between input frames: the taps are split
+// into factor phases of taps / factor coefficients, and output frame n * factor + p is phase p run over the
+// input. the phases are scaled by factor so passband gain is preserved.
+class Fir_Interpolator final {
+  public:
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    explicit Fir_Interpolator(const allocator_type& alloc = {});
+    Fir_Interpolator(Fir_Interpolator&& other, const allocator_type& alloc);
+
+    void create(std::span<const float32> taps, uint32 factor, uint32 max_input_frames);
+    void reset();
+
+    // writes frame_count * factor frames
+    void process(const float32* in, uint32 frame_count, float32* out);
+
+    uint32 factor() const {
+        return m_factor;
+    }
+
+    // in output frames
+    uint32 latency() const {
+        return (m_tap_count - 1) / 2;
+    }
+
+  private:
+    // factor phases of m_phase_taps reversed coefficients each
+    std::pmr::vector<float32> m_phases;
+    std::pmr::vector<float32> m_history;
+    // one block of output per phase, interleaved into out at the end
+    std::pmr::vector<float32> m_scratch;
+    uint32 m_factor = 1;
+    uint32 m_phase_taps = 0;
+    uint32 m_tap_count = 0;
+    uint32 m_max_frames = 0;
+};
+
+// same fir on every channel. coefficients are fixed once the node is in a graph; rebuild it to change them.
+struct Dsp_Fir_Node final {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    Dsp_Fir_Node(uint32 channels, std::span<const float32> taps);
+    Dsp_Fir_Node(
+        std::allocator_arg_t, const allocator_type& alloc, uint32 channels, std::span<const float32> taps);
+
+    Dsp_Node_Desc desc() const;
+    void prepare(const Dsp_Prepare& prepare);
+    void process(const Dsp_Process_Args& args);
+
+    uint32 channels;
+
+  private:
+    std::pmr::vector<float32> m_taps;
+    std::pmr::vector<Fir_Filter> m_filters;
+};
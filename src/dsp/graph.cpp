@@ -0,0 +1,403 @@
+#include "graph.h"
+
+#include <algorithm>
+#include <cstring>
+
+static constexpr size_t DSP_BUFFER_ALIGN = 64;
+
+template <typename From, typename To>
+struct Dsp_Convert_Node final {
+    uint32 channels;
+
+    Dsp_Node_Desc desc() const {
+        return {"Convert", 1, 1, channels, 0, DSP_SAMPLE_TYPE<From>, DSP_SAMPLE_TYPE<To>};
+    }
+
+    void process(const Dsp_Process_Args& args) {
+        for (uint32 c = 0; c < channels; ++c) {
+            const auto* in = args.inputs[0].channel_as<From>(c);
+            auto* out = args.outputs[0].channel_as<To>(c);
+            for (uint32 i = 0; i < args.frame_count; ++i)
+                out[i] = static_cast<To>(in[i]);
+        }
+    }
+};
+
+// float32 and float64 samples per pool float
+static uint32 pool_words(Dsp_Sample_Type type) {
+    return type == Dsp_Sample_Type::Float64 ? 2 : 1;
+}
+
+Dsp_Graph::Dsp_Graph(std::pmr::memory_resource* memory) : m_memory{memory} {
+}
+
+Dsp_Graph::~Dsp_Graph() {
+    release();
+}
+
+Dsp_Graph::Dsp_Graph(Dsp_Graph&& other) noexcept
+    : m_memory{other.m_memory}, m_nodes{std::move(other.m_nodes)}, m_edges{std::move(other.m_edges)} {
+    other.m_nodes.clear();
+    other.m_edges.clear();
+}
+
+Dsp_Graph& Dsp_Graph::operator=(Dsp_Graph&& other) noexcept {
+    if (this != &other) {
+        release();
+        m_memory = other.m_memory;
+        m_nodes = std::move(other.m_nodes);
+        m_edges = std::move(other.m_edges);
+        other.m_nodes.clear();
+        other.m_edges.clear();
+    }
+    return *this;
+}
+
+void Dsp_Graph::connect(Dsp_Node_Id src, uint32 src_port, Dsp_Node_Id dst, uint32 dst_port) {
+    sb_ASSERT(src < m_nodes.size() && dst < m_nodes.size());
+    sb_ASSERT(src_port < m_nodes[src].desc.output_count);
+    sb_ASSERT(dst_port < m_nodes[dst].desc.input_count);
+    sb_ASSERT_EQ(m_nodes[src].desc.channels, m_nodes[dst].desc.channels);
+    m_edges.push_back({src, src_port, dst, dst_port});
+}
+
+void Dsp_Graph::insert_conversions() {
+    struct Conversion final {
+        Dsp_Node_Id src;
+        uint32 src_port;
+        Dsp_Node_Id node;
+    };
+    // one per converted output, however many inputs it feeds
+    std::vector<Conversion> conversions;
+
+    const auto edge_count = m_edges.size();
+    for (size_t e = 0; e < edge_count; ++e) {
+        const auto edge = m_edges[e];
+        const auto from = m_nodes[edge.src].desc.output_type;
+        if (from == m_nodes[edge.dst].desc.input_type)
+            continue;
+
+        auto it = std::find_if(conversions.begin(), conversions.end(), [&](const Conversion& c) {
+            return c.src == edge.src && c.src_port == edge.src_port;
+        });
+        if (it == conversions.end()) {
+            const auto channels = m_nodes[edge.src].desc.channels;
+            const auto node = from == Dsp_Sample_Type::Float32
+                                  ? add<Dsp_Convert_Node<float32, float64>>(channels)
+                                  : add<Dsp_Convert_Node<float64, float32>>(channels);
+            m_edges.push_back({edge.src, edge.src_port, node, 0});
+            conversions.push_back({edge.src, edge.src_port, node});
+            it = conversions.end() - 1;
+        }
+        m_edges[e].src = it->node;
+        m_edges[e].src_port = 0;
+    }
+}
+
+void Dsp_Graph::release() {
+    for (auto& node : m_nodes) {
+        node.destroy(node.state, m_memory);
+    }
+    m_nodes.clear();
+    m_edges.clear();
+}
+
+void Dsp_Schedule::Pool_Delete::operator()(float32* p) const {
+    memory->deallocate(p, bytes, DSP_BUFFER_ALIGN);
+}
+
+void Dsp_Schedule::compile(Dsp_Graph&& graph, uint32 sample_rate, uint32 max_frames, uint32 device_channels) {
+    m_graph = std::move(graph);
+    m_graph.insert_conversions();
+    m_steps.clear();
+    m_level_offsets.clear();
+    m_ports.clear();
+    m_params.clear();
+    m_pool.reset();
+
+    m_context = {};
+    m_latency = 0;
+    m_block_frames = 0;
+    m_block_fill = 0;
+    m_context.sample_rate = sample_rate;
+    m_context.device_channels = device_channels;
+    m_max_frames = max_frames;
+
+    const auto nodes = m_graph.nodes();
+    const auto edges = m_graph.edges();
+    const auto node_count = static_cast<uint32>(nodes.size());
+
+    // flat port numbering: node i's inputs start at input_base[i], outputs at output_base[i]
+    std::vector<uint32> input_base(node_count + 1, 0);
+    std::vector<uint32> output_base(node_count + 1, 0);
+    for (uint32 i = 0; i < node_count; ++i) {
+        input_base[i + 1] = input_base[i] + nodes[i].desc.input_count;
+        output_base[i + 1] = output_base[i] + nodes[i].desc.output_count;
+    }
+
+    static constexpr uint32 UNCONNECTED = UINT32_MAX;
+    std::vector<uint32> input_source(input_base[node_count], UNCONNECTED);
+    std::vector<std::vector<Dsp_Node_Id>> successors(node_count);
+    std::vector<uint32> in_degree(node_count, 0);
+    for (const auto& edge : edges) {
+        auto& source = input_source[input_base[edge.dst] + edge.dst_port];
+        sb_ASSERT(source == UNCONNECTED); // use a mixer to sum several outputs
+        source = output_base[edge.src] + edge.src_port;
+        successors[edge.src].push_back(edge.dst);
+        ++in_degree[edge.dst];
+    }
+
+    // kahn's algorithm, one dependency level at a time
+    std::vector<uint32> level(node_count, 0);
+    std::vector<Dsp_Node_Id> order;
+    order.reserve(node_count);
+    std::vector<Dsp_Node_Id> frontier;
+    for (uint32 i = 0; i < node_count; ++i) {
+        if (in_degree[i] == 0)
+            frontier.push_back(i);
+    }
+    uint32 level_count = 0;
+    while (!frontier.empty()) {
+        m_level_offsets.push_back(static_cast<uint32>(order.size()));
+        std::vector<Dsp_Node_Id> next;
+        for (const auto n : frontier) {
+            level[n] = level_count;
+            order.push_back(n);
+            for (const auto s : successors[n]) {
+                if (--in_degree[s] == 0)
+                    next.push_back(s);
+            }
+        }
+        std::sort(next.begin(), next.end());
+        frontier = std::move(next);
+        ++level_count;
+    }
+    m_level_offsets.push_back(static_cast<uint32>(order.size()));
+    sb_ASSERT_EQ(order.size(), static_cast<size_t>(node_count)); // graph has a cycle
+
+    // each node's latency plus the slowest of the paths feeding it
+    std::vector<uint32> path_latency(node_count, 0);
+    for (const auto n : order) {
+        path_latency[n] += nodes[n].desc.latency;
+        for (const auto s : successors[n])
+            path_latency[s] = std::max(path_latency[s], path_latency[n]);
+        if (nodes[n].desc.output_count == 0)
+            m_latency = std::max(m_latency, path_latency[n]);
+    }
+
+    uint32 widest = 0;
+    for (uint32 l = 0; l < level_count; ++l)
+        widest = std::max(widest, m_level_offsets[l + 1] - m_level_offsets[l]);
+    sb_ASSERT(widest <= Dsp_Worker_Pool::MAX_ITEMS);
+    m_parallel = widest > 1 && node_count >= DSP_PARALLEL_MIN_STEPS;
+
+    // an output stays live until the level after its last reader
+    std::vector<uint32> last_use(output_base[node_count], 0);
+    for (uint32 i = 0; i < node_count; ++i) {
+        for (uint32 p = output_base[i]; p < output_base[i + 1]; ++p)
+            last_use[p] = level[i];
+    }
+    for (uint32 i = 0; i < node_count; ++i) {
+        for (uint32 p = input_base[i]; p < input_base[i + 1]; ++p) {
+            if (input_source[p] != UNCONNECTED)
+                last_use[input_source[p]] = std::max(last_use[input_source[p]], level[i]);
+        }
+    }
+
+    const uint32 stride = (max_frames + 15) & ~15u;
+
+    // ports of either sample type share one pool, sized in floats
+    uint32 max_words = 0;
+    for (const auto& node : nodes) {
+        const auto words = std::max(pool_words(node.desc.input_type), pool_words(node.desc.output_type));
+        max_words = std::max(max_words, node.desc.channels * words);
+    }
+
+    // offset 0 is a shared block of silence for unconnected inputs
+    size_t pool_size = static_cast<size_t>(max_words) * stride;
+    std::vector<size_t> output_offset(output_base[node_count], 0);
+    // indexed by channels times words per sample
+    std::vector<std::vector<size_t>> free_lists(max_words + 1);
+    std::vector<std::vector<uint32>> release_at(level_count + 1);
+
+    for (uint32 l = 0; l < level_count; ++l) {
+        for (const auto p : release_at[l]) {
+            const auto owner = static_cast<uint32>(
+                std::upper_bound(output_base.begin(), output_base.end(), p) - output_base.begin() - 1);
+            const auto& desc = nodes[owner].desc;
+            free_lists[desc.channels * pool_words(desc.output_type)].push_back(output_offset[p]);
+        }
+
+        for (uint32 k = m_level_offsets[l]; k < m_level_offsets[l + 1]; ++k) {
+            const auto n = order[k];
+            const auto words = nodes[n].desc.channels * pool_words(nodes[n].desc.output_type);
+            for (uint32 p = output_base[n]; p < output_base[n + 1]; ++p) {
+                auto& free_list = free_lists[words];
+                if (!free_list.empty()) {
+                    output_offset[p] = free_list.back();
+                    free_list.pop_back();
+                } else {
+                    output_offset[p] = pool_size;
+                    pool_size += static_cast<size_t>(words) * stride;
+                }
+                release_at[last_use[p] + 1].push_back(p);
+            }
+        }
+    }
+
+    const auto pool_bytes = std::max<size_t>(pool_size, 1) * sizeof(float32);
+    auto* memory = m_graph.memory();
+    m_pool = {static_cast<float32*>(memory->allocate(pool_bytes, DSP_BUFFER_ALIGN)), {memory, pool_bytes}};
+    std::memset(m_pool.get(), 0, pool_size * sizeof(float32));
+
+    const Dsp_Prepare prepare{sample_rate, max_frames};
+
+    m_params.reserve(node_count);
+    for (const auto& node : nodes) {
+        m_params.push_back({node.state, node.set_param});
+    }
+
+    m_steps.reserve(node_count);
+    m_ports.reserve(input_base[node_count] + output_base[node_count]);
+    for (const auto n : order) {
+        const auto& node = nodes[n];
+        const auto channels = node.desc.channels;
+
+        if (node.prepare)
+            node.prepare(node.state, prepare);
+
+        Step step;
+        step.process = node.process;
+        step.state = node.state;
+
+        step.first_input = static_cast<uint32>(m_ports.size());
+        step.input_count = node.desc.input_count;
+        for (uint32 p = input_base[n]; p < input_base[n + 1]; ++p) {
+            const auto src = input_source[p];
+            const auto offset = src == UNCONNECTED ? 0 : output_offset[src];
+            m_ports.push_back({m_pool.get() + offset, channels, stride});
+        }
+
+        step.first_output = static_cast<uint32>(m_ports.size());
+        step.output_count = node.desc.output_count;
+        for (uint32 p = output_base[n]; p < output_base[n + 1]; ++p) {
+            m_ports.push_back({m_pool.get() + output_offset[p], channels, stride});
+        }
+
+        m_steps.push_back(step);
+    }
+}
+
+void Dsp_Schedule::process(const float32* input, float32* output, uint32 frame_count) {
+    if (m_steps.empty())
+        return;
+
+    const auto spread = parallel();
+    if (spread)
+        m_workers->begin_period();
+
+    if (m_block_frames == 0) {
+        run_chunks(input, output, frame_count);
+    } else {
+        const auto channels = m_context.device_channels;
+        for (uint32 done = 0; done < frame_count;) {
+            const auto n = std::min(frame_count - done, m_block_frames - m_block_fill);
+            const auto at = static_cast<size_t>(m_block_fill) * channels;
+            const auto io = static_cast<size_t>(done) * channels;
+            const auto bytes = static_cast<size_t>(n) * channels * sizeof(float32);
+            if (input)
+                std::memcpy(m_block_input.data() + at, input + io, bytes);
+            else
+                std::memset(m_block_input.data() + at, 0, bytes);
+            if (output)
+                std::memcpy(output + io, m_block_output.data() + at, bytes);
+            m_block_fill += n;
+            done += n;
+
+            if (m_block_fill == m_block_frames) {
+                std::fill(m_block_output.begin(), m_block_output.end(), 0.f);
+                run_chunks(m_block_input.data(), m_block_output.data(), m_block_frames);
+                m_block_fill = 0;
+            }
+        }
+    }
+
+    if (spread)
+        m_workers->end_period();
+}
+
+void Dsp_Schedule::set_block_frames(uint32 frames) {
+    sb_ASSERT(frames <= m_max_frames);
+    m_block_frames = frames;
+    m_block_fill = 0;
+    const auto samples = static_cast<size_t>(frames) * m_context.device_channels;
+    m_block_input.assign(samples, 0.f);
+    m_block_output.assign(samples, 0.f);
+}
+
+void Dsp_Schedule::run_chunks(const float32* input, float32* output, uint32 frame_count) {
+    m_context.device_input = input;
+    m_context.device_output = output;
+
+    for (uint32 offset = 0; offset < frame_count;) {
+        auto chunk = std::min(m_max_frames, frame_count - offset);
+
+        if (m_param_queue) {
+            while (const auto* event = m_param_queue->front()) {
+                if (event->time > m_context.sample_time) {
+                    // run up to the event, then pick it up at the top of the next chunk
+                    chunk = static_cast<uint32>(std::min<uint64>(chunk, event->time - m_context.sample_time));
+                    break;
+                }
+                apply(*event);
+                m_param_queue->pop();
+            }
+        }
+
+        m_context.frame_offset = offset;
+        run_chunk(chunk);
+        m_context.sample_time += chunk;
+        offset += chunk;
+    }
+}
+
+void Dsp_Schedule::apply(const Dsp_Param_Event& event) {
+    if (event.node >= m_params.size())
+        return;
+    const auto& target = m_params[event.node];
+    if (target.set_param)
+        target.set_param(target.state, event.param, event.value, event.ramp_frames);
+}
+
+void Dsp_Schedule::run_chunk(uint32 frame_count) {
+    if (!parallel()) {
+        for (const auto& step : m_steps)
+            run_step(step, frame_count);
+        return;
+    }
+
+    m_chunk_frames = frame_count;
+    for (size_t l = 0; l + 1 < m_level_offsets.size(); ++l) {
+        const auto begin = m_level_offsets[l];
+        const auto count = m_level_offsets[l + 1] - begin;
+        if (count == 1) {
+            run_step(m_steps[begin], frame_count);
+            continue;
+        }
+        m_level_begin = begin;
+        m_workers->run(
+            [](void* context, uint32 index) {
+                auto* self = static_cast<Dsp_Schedule*>(context);
+                self->run_step(self->m_steps[self->m_level_begin + index], self->m_chunk_frames);
+            },
+            this, count);
+    }
+}
+
+void Dsp_Schedule::run_step(const Step& step, uint32 frame_count) {
+    const auto* ports = m_ports.data();
+    const Dsp_Process_Args args{
+        &m_context, ports + step.first_input, step.input_count, ports + step.first_output, step.output_count,
+        frame_count};
+    step.process(step.state, args);
+}
@@ -0,0 +1,305 @@
+#pragma once
+
+#include "util.h"
+#include "params.h"
+#include "workers.h"
+
+#include <memory>
+#include <memory_resource>
+#include <vector>
+#include <string_view>
+#include <type_traits>
+
+// what a node's ports carry. where an edge joins ports of different types the schedule inserts a
+// conversion, so a run of float64 nodes stays in float64 between them.
+enum class Dsp_Sample_Type { Float32, Float64 };
+
+template <typename T>
+inline constexpr Dsp_Sample_Type DSP_SAMPLE_TYPE =
+    std::is_same_v<T, float64> ? Dsp_Sample_Type::Float64 : Dsp_Sample_Type::Float32;
+
+// planar multi-channel view into the schedule's buffer pool
+struct Dsp_Buffer final {
+    float32* data = nullptr;
+    uint32 channels = 0;
+    // in samples of the port's type
+    uint32 stride = 0;
+
+    float32* channel(uint32 c) const {
+        return data + static_cast<size_t>(c) * stride;
+    }
+
+    // the channel as the port's sample type, see Dsp_Node_Desc
+    template <typename T>
+    T* channel_as(uint32 c) const {
+        return reinterpret_cast<T*>(data) + static_cast<size_t>(c) * stride;
+    }
+};
+
+// per-block state shared by every node in a schedule
+struct Dsp_Context final {
+    const float32* device_input = nullptr;
+    float32* device_output = nullptr;
+    uint32 device_channels = 0;
+    // offset of the current chunk into the device buffers, in frames
+    uint32 frame_offset = 0;
+    uint32 sample_rate = 0;
+    uint64 sample_time = 0;
+};
+
+struct Dsp_Process_Args final {
+    const Dsp_Context* context;
+    const Dsp_Buffer* inputs;
+    uint32 input_count;
+    const Dsp_Buffer* outputs;
+    uint32 output_count;
+    uint32 frame_count;
+};
+
+struct Dsp_Prepare final {
+    uint32 sample_rate;
+    uint32 max_frames;
+};
+
+struct Dsp_Node_Desc final {
+    std::string_view name;
+    uint32 input_count;
+    uint32 output_count;
+    uint32 channels;
+    // frames the node delays its input by, summed along paths into Dsp_Schedule::latency()
+    uint32 latency = 0;
+    Dsp_Sample_Type input_type = Dsp_Sample_Type::Float32;
+    Dsp_Sample_Type output_type = Dsp_Sample_Type::Float32;
+};
+
+using Dsp_Process_Fn = void (*)(void* state, const Dsp_Process_Args& args);
+using Dsp_Prepare_Fn = void (*)(void* state, const Dsp_Prepare& prepare);
+using Dsp_Set_Param_Fn = void (*)(void* state, uint32 param, float32 value, uint32 ramp_frames);
+using Dsp_Destroy_Fn = void (*)(void* state, std::pmr::memory_resource* memory);
+
+// a node type is any struct with `Dsp_Node_Desc desc() const` and `void process(const Dsp_Process_Args&)`,
+// and optionally `void prepare(const Dsp_Prepare&)` and `void set_param(uint32, float32, uint32)`. nodes are
+// erased into plain function pointers so the compiled schedule never goes through a vtable.
+// node state comes from the graph's memory resource. node types that declare
+// `using allocator_type = std::pmr::polymorphic_allocator<>` and a constructor taking
+// `(std::allocator_arg_t, const allocator_type&, ...)` get it passed in, so their buffers live there too.
+class Dsp_Graph final {
+  public:
+    struct Node final {
+        Dsp_Node_Desc desc;
+        void* state = nullptr;
+        Dsp_Process_Fn process = nullptr;
+        Dsp_Prepare_Fn prepare = nullptr;
+        Dsp_Set_Param_Fn set_param = nullptr;
+        Dsp_Destroy_Fn destroy = nullptr;
+    };
+
+    struct Edge final {
+        Dsp_Node_Id src;
+        uint32 src_port;
+        Dsp_Node_Id dst;
+        uint32 dst_port;
+    };
+
+    explicit Dsp_Graph(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+    ~Dsp_Graph();
+
+    Dsp_Graph(const Dsp_Graph&) = delete;
+    Dsp_Graph& operator=(const Dsp_Graph&) = delete;
+
+    Dsp_Graph(Dsp_Graph&& other) noexcept;
+    Dsp_Graph& operator=(Dsp_Graph&& other) noexcept;
+
+    template <typename T, typename... Args>
+    Dsp_Node_Id add(Args&&... arg) {
+        Node node;
+        std::pmr::polymorphic_allocator<T> alloc{m_memory};
+        auto* state = alloc.template new_object<T>(std::forward<Args>(arg)...);
+        node.desc = state->desc();
+        node.state = state;
+        node.process = [](void* s, const Dsp_Process_Args& args) { static_cast<T*>(s)->process(args); };
+        if constexpr (requires(T& t, const Dsp_Prepare& p) { t.prepare(p); }) {
+            node.prepare = [](void* s, const Dsp_Prepare& p) { static_cast<T*>(s)->prepare(p); };
+        }
+        if constexpr (requires(T& t) { t.set_param(uint32{}, float32{}, uint32{}); }) {
+            node.set_param = [](void* s, uint32 param, float32 value, uint32 ramp_frames) {
+                static_cast<T*>(s)->set_param(param, value, ramp_frames);
+            };
+        }
+        node.destroy = [](void* s, std::pmr::memory_resource* memory) {
+            std::pmr::polymorphic_allocator<T>{memory}.delete_object(static_cast<T*>(s));
+        };
+        m_nodes.push_back(node);
+        return static_cast<Dsp_Node_Id>(m_nodes.size() - 1);
+    }
+
+    template <typename T>
+    T& node(Dsp_Node_Id id) {
+        return *static_cast<T*>(m_nodes[id].state);
+    }
+
+    void connect(Dsp_Node_Id src, uint32 src_port, Dsp_Node_Id dst, uint32 dst_port);
+
+    std::span<const Node> nodes() const {
+        return m_nodes;
+    }
+
+    std::span<const Edge> edges() const {
+        return m_edges;
+    }
+
+    std::pmr::memory_resource* memory() const {
+        return m_memory;
+    }
+
+  private:
+    friend class Dsp_Schedule;
+
+    void release();
+    // reroutes every edge between ports of different sample types through a conversion node
+    void insert_conversions();
+
+    std::pmr::memory_resource* m_memory;
+
+    std::vector<Node> m_nodes;
+    std::vector<Edge> m_edges;
+};
+
+// graphs with fewer steps than this always run on the calling thread; handing levels to workers costs more
+// than a few cheap nodes
+static constexpr uint32 DSP_PARALLEL_MIN_STEPS = 8;
+
+// a graph flattened into topologically sorted steps over a preallocated buffer pool.
+// steps are grouped by dependency level; ports only reuse a buffer once every reader of its previous
+// occupant has run, so the steps of one level never share an output and can run on any thread.
+class Dsp_Schedule final {
+  public:
+    struct Step final {
+        Dsp_Process_Fn process;
+        void* state;
+        uint32 first_input;
+        uint32 input_count;
+        uint32 first_output;
+        uint32 output_count;
+    };
+
+    void compile(Dsp_Graph&& graph, uint32 sample_rate, uint32 max_frames, uint32 device_channels);
+
+    // processes one device period of interleaved frames, splitting it into chunks of at most max_frames and
+    // at the sample offset of every pending parameter event
+    void process(const float32* input, float32* output, uint32 frame_count);
+
+    // runs the graph in blocks of exactly `frames`, however many frames each process() call brings, so
+    // chunk sizes and the chunk grid don't depend on the device. events still split a block at their
+    // sample. costs `frames` of latency, which latency() includes. 0 goes back to following process().
+    // frames must be at most max_frames; not safe while processing.
+    void set_block_frames(uint32 frames);
+
+    uint32 block_frames() const {
+        return m_block_frames;
+    }
+
+    // levels with more than one step are spread over the pool's workers once the graph is large enough.
+    // the pool must outlive the schedule; nullptr runs everything on the calling thread.
+    void set_worker_pool(Dsp_Worker_Pool* pool) {
+        m_workers = pool;
+    }
+
+    // whether process() hands levels to the worker pool
+    bool parallel() const {
+        return m_workers && m_workers->worker_count() > 0 && m_parallel;
+    }
+
+    // events are drained by process(); the queue must outlive the schedule
+    void set_param_queue(Dsp_Param_Queue* queue) {
+        m_param_queue = queue;
+    }
+
+    // applies a parameter change immediately; audio thread only once the schedule is running
+    void apply(const Dsp_Param_Event& event);
+
+    uint64 sample_time() const {
+        return m_context.sample_time;
+    }
+
+    Dsp_Graph& graph() {
+        return m_graph;
+    }
+
+    bool empty() const {
+        return m_steps.empty();
+    }
+
+    uint32 sample_rate() const {
+        return m_context.sample_rate;
+    }
+
+    uint32 max_frames() const {
+        return m_max_frames;
+    }
+
+    uint32 device_channels() const {
+        return m_context.device_channels;
+    }
+
+    // largest node latency summed along any path into a sink, plus the fixed block's, for the host to
+    // compensate
+    uint32 latency() const {
+        return m_latency + m_block_frames;
+    }
+
+    std::span<const Step> steps() const {
+        return m_steps;
+    }
+
+    std::span<const uint32> level_offsets() const {
+        return m_level_offsets;
+    }
+
+  private:
+    struct Pool_Delete final {
+        std::pmr::memory_resource* memory;
+        size_t bytes;
+
+        void operator()(float32* p) const;
+    };
+
+    struct Param_Target final {
+        void* state;
+        Dsp_Set_Param_Fn set_param;
+    };
+
+    void run_chunks(const float32* input, float32* output, uint32 frame_count);
+    void run_chunk(uint32 frame_count);
+    void run_step(const Step& step, uint32 frame_count);
+
+    Dsp_Graph m_graph;
+    Dsp_Context m_context;
+    uint32 m_max_frames = 0;
+    uint32 m_latency = 0;
+
+    std::vector<Step> m_steps;
+    // m_steps[m_level_offsets[i]..m_level_offsets[i + 1]] have no dependencies on each other
+    std::vector<uint32> m_level_offsets;
+    std::vector<Dsp_Buffer> m_ports;
+    // indexed by node id
+    std::vector<Param_Target> m_params;
+    Dsp_Param_Queue* m_param_queue = nullptr;
+
+    Dsp_Worker_Pool* m_workers = nullptr;
+    // large enough and with at least one level wide enough to be worth spreading
+    bool m_parallel = false;
+    // the level and chunk size the workers are currently helping with
+    uint32 m_level_begin = 0;
+    uint32 m_chunk_frames = 0;
+
+    // with a fixed block, interleaved device frames wait in m_block_input until a whole block is there,
+    // while the previous block's output drains from m_block_output at the same rate
+    uint32 m_block_frames = 0;
+    uint32 m_block_fill = 0;
+    std::vector<float32> m_block_input;
+    std::vector<float32> m_block_output;
+
+    // from the graph's memory resource
+    std::unique_ptr<float32, Pool_Delete> m_pool;
+};
@@ -0,0 +1,399 @@
+// built once per instruction set with that set's compiler flags, see the kernel variants in CMakeLists.txt.
+// everything in here stays in an anonymous namespace except the table, and nothing calls into out-of-line
+// library code, so no function compiled for a higher level can leak into the rest of the program.
+
+#include "kernels.h"
+#include "simd_math.h"
+
+#if defined(__AVX512F__)
+#define SB_KERNELS dsp_kernels_avx512
+#define SB_KERNELS_ISA Cpu_Isa::Avx512
+#elif defined(__AVX2__)
+#define SB_KERNELS dsp_kernels_avx2
+#define SB_KERNELS_ISA Cpu_Isa::Avx2
+#elif defined(SB_SIMD_NEON)
+#define SB_KERNELS dsp_kernels_neon
+#define SB_KERNELS_ISA Cpu_Isa::Neon
+#else
+#define SB_KERNELS dsp_kernels_sse2
+#define SB_KERNELS_ISA Cpu_Isa::Sse2
+#endif
+
+namespace {
+
+using V = Simd_F32;
+
+// the biquad lanes fit one avx register, or two sse ones, and in double precision one avx-512 register
+#if defined(SB_SIMD_AVX)
+using V8 = Simd_F32x8;
+#else
+using V8 = Simd_F32x4;
+#endif
+using V8_F64 = Simd_F64;
+
+// taps per pass over the output block: 256 coefficients plus the input they slide over fit in l1
+constexpr uint32 FIR_TAP_TILE = 256;
+
+uint32 min_u32(uint32 a, uint32 b) {
+    return a < b ? a : b;
+}
+
+float32 hsum(V::Reg v) {
+    float32 lanes[V::WIDTH];
+    V::storeu(lanes, v);
+    auto sum = 0.f;
+    for (const auto lane : lanes)
+        sum += lane;
+    return sum;
+}
+
+void fir(const float32* x, const float32* h, uint32 taps, float32* out, uint32 count) {
+    constexpr auto W = V::WIDTH;
+    for (uint32 t0 = 0; t0 < taps; t0 += FIR_TAP_TILE) {
+        const auto t1 = min_u32(taps, t0 + FIR_TAP_TILE);
+        const auto first = t0 == 0;
+
+        uint32 n = 0;
+        for (; n + W * 4 <= count; n += W * 4) {
+            auto a0 = first ? V::zero() : V::loadu(out + n);
+            auto a1 = first ? V::zero() : V::loadu(out + n + W);
+            auto a2 = first ? V::zero() : V::loadu(out + n + W * 2);
+            auto a3 = first ? V::zero() : V::loadu(out + n + W * 3);
+            for (uint32 k = t0; k < t1; ++k) {
+                const auto hk = V::set1(h[k]);
+                const auto* p = x + n + k;
+                a0 = V::madd(hk, V::loadu(p), a0);
+                a1 = V::madd(hk, V::loadu(p + W), a1);
+                a2 = V::madd(hk, V::loadu(p + W * 2), a2);
+                a3 = V::madd(hk, V::loadu(p + W * 3), a3);
+            }
+            V::storeu(out + n, a0);
+            V::storeu(out + n + W, a1);
+            V::storeu(out + n + W * 2, a2);
+            V::storeu(out + n + W * 3, a3);
+        }
+        for (; n + W <= count; n += W) {
+            auto a = first ? V::zero() : V::loadu(out + n);
+            for (uint32 k = t0; k < t1; ++k)
+                a = V::madd(V::set1(h[k]), V::loadu(x + n + k), a);
+            V::storeu(out + n, a);
+        }
+        for (; n < count; ++n) {
+            auto a = first ? 0.f : out[n];
+            for (uint32 k = t0; k < t1; ++k)
+                a += h[k] * x[n + k];
+            out[n] = a;
+        }
+    }
+}
+
+// each mirrored pair of inputs is summed and multiplied once
+void fir_folded(const float32* x, const float32* h, uint32 taps, float32* out, uint32 count) {
+    constexpr auto W = V::WIDTH;
+    const auto half = taps / 2;
+    const auto mirror = taps - 1;
+    const auto mid = (taps & 1) ? h[half] : 0.f;
+
+    // the middle tap of an odd-length filter seeds the accumulators
+    for (uint32 t0 = 0; t0 < (half > 0 ? half : 1); t0 += FIR_TAP_TILE) {
+        const auto t1 = min_u32(half, t0 + FIR_TAP_TILE);
+        const auto first = t0 == 0;
+        const auto hm = V::set1(mid);
+
+        uint32 n = 0;
+        for (; n + W * 4 <= count; n += W * 4) {
+            auto a0 = first ? V::mul(hm, V::loadu(x + n + half)) : V::loadu(out + n);
+            auto a1 = first ? V::mul(hm, V::loadu(x + n + half + W)) : V::loadu(out + n + W);
+            auto a2 = first ? V::mul(hm, V::loadu(x + n + half + W * 2)) : V::loadu(out + n + W * 2);
+            auto a3 = first ? V::mul(hm, V::loadu(x + n + half + W * 3)) : V::loadu(out + n + W * 3);
+            for (uint32 k = t0; k < t1; ++k) {
+                const auto hk = V::set1(h[k]);
+                const auto* p = x + n + k;
+                const auto* q = x + n + mirror - k;
+                a0 = V::madd(hk, V::add(V::loadu(p), V::loadu(q)), a0);
+                a1 = V::madd(hk, V::add(V::loadu(p + W), V::loadu(q + W)), a1);
+                a2 = V::madd(hk, V::add(V::loadu(p + W * 2), V::loadu(q + W * 2)), a2);
+                a3 = V::madd(hk, V::add(V::loadu(p + W * 3), V::loadu(q + W * 3)), a3);
+            }
+            V::storeu(out + n, a0);
+            V::storeu(out + n + W, a1);
+            V::storeu(out + n + W * 2, a2);
+            V::storeu(out + n + W * 3, a3);
+        }
+        for (; n + W <= count; n += W) {
+            auto a = first ? V::mul(hm, V::loadu(x + n + half)) : V::loadu(out + n);
+            for (uint32 k = t0; k < t1; ++k)
+                a = V::madd(V::set1(h[k]), V::add(V::loadu(x + n + k), V::loadu(x + n + mirror - k)), a);
+            V::storeu(out + n, a);
+        }
+        for (; n < count; ++n) {
+            auto a = first ? mid * x[n + half] : out[n];
+            for (uint32 k = t0; k < t1; ++k)
+                a += h[k] * (x[n + k] + x[n + mirror - k]);
+            out[n] = a;
+        }
+    }
+}
+
+float32 dot(const float32* x, const float32* h, uint32 count) {
+    constexpr auto W = V::WIDTH;
+    auto a0 = V::zero();
+    auto a1 = V::zero();
+    uint32 k = 0;
+    for (; k + W * 2 <= count; k += W * 2) {
+        a0 = V::madd(V::loadu(h + k), V::loadu(x + k), a0);
+        a1 = V::madd(V::loadu(h + k + W), V::loadu(x + k + W), a1);
+    }
+    for (; k + W <= count; k += W)
+        a0 = V::madd(V::loadu(h + k), V::loadu(x + k), a0);
+
+    auto sum = hsum(V::add(a0, a1));
+    for (; k < count; ++k)
+        sum += h[k] * x[k];
+    return sum;
+}
+
+void madd(const float32* a, float32 s, const float32* b, float32* out, uint32 count) {
+    const auto vs = V::set1(s);
+    uint32 k = 0;
+    for (; k + V::WIDTH <= count; k += V::WIDTH)
+        V::storeu(out + k, V::madd(V::loadu(a + k), vs, V::loadu(b + k)));
+    for (; k < count; ++k)
+        out[k] = a[k] * s + b[k];
+}
+
+void complex_madd(
+    const float32* x_re, const float32* x_im, const float32* h_re, const float32* h_im, float32* acc_re,
+    float32* acc_im, uint32 count) {
+    uint32 k = 0;
+    for (; k + V::WIDTH <= count; k += V::WIDTH) {
+        const auto a_re = V::loadu(x_re + k);
+        const auto a_im = V::loadu(x_im + k);
+        const auto b_re = V::loadu(h_re + k);
+        const auto b_im = V::loadu(h_im + k);
+        const auto re = V::madd(a_re, b_re, V::loadu(acc_re + k));
+        const auto im = V::madd(a_re, b_im, V::loadu(acc_im + k));
+        V::storeu(acc_re + k, V::sub(re, V::mul(a_im, b_im)));
+        V::storeu(acc_im + k, V::madd(a_im, b_re, im));
+    }
+    for (; k < count; ++k) {
+        acc_re[k] += x_re[k] * h_re[k] - x_im[k] * h_im[k];
+        acc_im[k] += x_re[k] * h_im[k] + x_im[k] * h_re[k];
+    }
+}
+
+template <typename W, typename T>
+void biquad_lanes(const T* coeffs, T* state, T* buf, uint32 frame_count) {
+    constexpr auto L = BIQUAD_KERNEL_LANES;
+    for (uint32 h = 0; h < L; h += W::WIDTH) {
+        const auto b0 = W::loadu(coeffs + h);
+        const auto b1 = W::loadu(coeffs + L + h);
+        const auto b2 = W::loadu(coeffs + L * 2 + h);
+        const auto a1 = W::loadu(coeffs + L * 3 + h);
+        const auto a2 = W::loadu(coeffs + L * 4 + h);
+        auto z1 = W::loadu(state + h);
+        auto z2 = W::loadu(state + L + h);
+        for (uint32 i = 0; i < frame_count; ++i) {
+            auto* p = buf + i * L + h;
+            const auto x = W::loadu(p);
+            const auto y = W::madd(b0, x, z1);
+            z1 = W::sub(W::madd(b1, x, z2), W::mul(a1, y));
+            z2 = W::sub(W::mul(b2, x), W::mul(a2, y));
+            W::storeu(p, y);
+        }
+        W::storeu(state + h, z1);
+        W::storeu(state + L + h, z2);
+    }
+}
+
+// the tail goes through the same code in a zero padded register, so a value's result doesn't depend on
+// where it sits in the array
+template <typename F>
+void map(const float32* in, float32* out, uint32 count, F f) {
+    uint32 k = 0;
+    for (; k + V::WIDTH <= count; k += V::WIDTH)
+        V::storeu(out + k, f(V::loadu(in + k)));
+    if (k == count)
+        return;
+
+    float32 tail[V::WIDTH] = {};
+    for (uint32 i = k; i < count; ++i)
+        tail[i - k] = in[i];
+    V::storeu(tail, f(V::loadu(tail)));
+    for (uint32 i = k; i < count; ++i)
+        out[i] = tail[i - k];
+}
+
+void array_exp(const float32* in, float32* out, uint32 count) {
+    map(in, out, count, [](V::Reg x) { return simd_exp<V>(x); });
+}
+
+void array_log(const float32* in, float32* out, uint32 count) {
+    map(in, out, count, [](V::Reg x) { return simd_log<V>(x); });
+}
+
+void array_sin(const float32* in, float32* out, uint32 count) {
+    map(in, out, count, [](V::Reg x) { return simd_sin<V>(x); });
+}
+
+void array_cos(const float32* in, float32* out, uint32 count) {
+    map(in, out, count, [](V::Reg x) { return simd_cos<V>(x); });
+}
+
+void array_tanh(const float32* in, float32* out, uint32 count) {
+    map(in, out, count, [](V::Reg x) { return simd_tanh<V>(x); });
+}
+
+void array_db_to_linear(const float32* in, float32* out, uint32 count) {
+    map(in, out, count, [](V::Reg x) { return simd_db_to_linear<V>(x); });
+}
+
+void array_linear_to_db(const float32* in, float32* out, uint32 count) {
+    map(in, out, count, [](V::Reg x) { return simd_linear_to_db<V>(x); });
+}
+
+void array_pow(const float32* x, const float32* y, float32* out, uint32 count) {
+    uint32 k = 0;
+    for (; k + V::WIDTH <= count; k += V::WIDTH)
+        V::storeu(out + k, simd_pow<V>(V::loadu(x + k), V::loadu(y + k)));
+    if (k == count)
+        return;
+
+    float32 tx[V::WIDTH] = {};
+    float32 ty[V::WIDTH] = {};
+    for (uint32 i = k; i < count; ++i) {
+        tx[i - k] = x[i];
+        ty[i - k] = y[i];
+    }
+    V::storeu(tx, simd_pow<V>(V::loadu(tx), V::loadu(ty)));
+    for (uint32 i = k; i < count; ++i)
+        out[i] = tx[i - k];
+}
+
+void biquad_response(
+    const float32* coeffs, const float32* trig, float32* db, float32* phase, float32* delay, uint32 count) {
+    const float64 c[5] = {coeffs[0], coeffs[1], coeffs[2], coeffs[3], coeffs[4]};
+    const auto b1 = V::set1(coeffs[1]);
+    const auto b2 = V::set1(coeffs[2]);
+    const auto a1 = V::set1(coeffs[3]);
+    const auto a2 = V::set1(coeffs[4]);
+    const auto b2x2 = V::set1(coeffs[2] * 2.f);
+    const auto a2x2 = V::set1(coeffs[4] * 2.f);
+    // the polynomials and their derivatives at dc, where they nearly cancel for low cutoffs
+    const auto b_dc = V::set1(static_cast<float32>(c[0] + c[1] + c[2]));
+    const auto a_dc = V::set1(static_cast<float32>(1.0 + c[3] + c[4]));
+    const auto db_dc = V::set1(static_cast<float32>(c[1] + 2.0 * c[2]));
+    const auto da_dc = V::set1(static_cast<float32>(c[3] + 2.0 * c[4]));
+    const auto tiny = V::set1(1.17549435e-38f);
+
+    const auto* cos1 = trig;
+    const auto* sin1 = trig + count;
+    const auto* cos2 = trig + count * 2;
+    const auto* sin2 = trig + count * 3;
+    for (uint32 k = 0; k < count; k += V::WIDTH) {
+        const auto c1 = V::loadu(cos1 + k);
+        const auto s1 = V::loadu(sin1 + k);
+        const auto c2 = V::loadu(cos2 + k);
+        const auto s2 = V::loadu(sin2 + k);
+
+        // b(w) = b0 + b1 e^-jw + b2 e^-2jw = br - j bn, and a(w) = ar - j an
+        const auto br = V::madd(b2, c2, V::madd(b1, c1, b_dc));
+        const auto bn = V::madd(b2, s2, V::mul(b1, s1));
+        const auto ar = V::madd(a2, c2, V::madd(a1, c1, a_dc));
+        const auto an = V::madd(a2, s2, V::mul(a1, s1));
+        const auto bb = V::max(V::madd(br, br, V::mul(bn, bn)), tiny);
+        const auto aa = V::max(V::madd(ar, ar, V::mul(an, an)), tiny);
+
+        V::storeu(db + k, V::mul(simd_log<V>(V::div(bb, aa)), V::set1(4.34294481903251828f)));
+
+        // arg(b / a) = arg(b * conj(a))
+        const auto hr = V::madd(br, ar, V::mul(bn, an));
+        const auto hi = V::sub(V::mul(br, an), V::mul(bn, ar));
+        V::storeu(phase + k, simd_atan2<V>(hi, hr));
+
+        // a polynomial p in e^-jw delays by re(sum of k p[k] e^-jkw / p), and h = b / a by b's minus a's
+        const auto dbr = V::madd(b2x2, c2, V::madd(b1, c1, db_dc));
+        const auto dbn = V::madd(b2x2, s2, V::mul(b1, s1));
+        const auto dar = V::madd(a2x2, c2, V::madd(a1, c1, da_dc));
+        const auto dan = V::madd(a2x2, s2, V::mul(a1, s1));
+        const auto tb = V::div(V::madd(dbr, br, V::mul(dbn, bn)), bb);
+        const auto ta = V::div(V::madd(dar, ar, V::mul(dan, an)), aa);
+        V::storeu(delay + k, V::sub(tb, ta));
+    }
+}
+
+void wavetable(
+    const float32* table, uint32 size, const Dsp_Wavetable_Lanes& lanes, float32* out, uint32 frame_count) {
+    // each voice block adds its lanes into acc, one register per frame, and the lanes are summed once at
+    // the end, so the horizontal adds don't grow with the voice count
+    constexpr uint32 CHUNK = 64;
+    alignas(64) float32 acc[CHUNK * V::WIDTH];
+    const auto scale = V::set1(static_cast<float32>(size));
+    const auto one = V::set1(1.f);
+
+    for (uint32 f = 0; f < frame_count; f += CHUNK) {
+        const auto n = min_u32(CHUNK, frame_count - f);
+        for (uint32 i = 0; i < n; ++i)
+            V::store(acc + i * V::WIDTH, V::zero());
+
+        for (uint32 v = 0; v < lanes.count; v += V::WIDTH) {
+            bool silent = true;
+            for (uint32 l = 0; l < V::WIDTH; ++l)
+                silent = silent && lanes.amp[v + l] == 0.f && lanes.amp_step[v + l] == 0.f;
+            if (silent)
+                continue;
+
+            const auto off = V::loadu(lanes.offset + v);
+            const auto step = V::loadu(lanes.inc + v);
+            const auto da = V::loadu(lanes.amp_step + v);
+            const auto lp = V::loadu(lanes.lp_coeff + v);
+            auto p = V::loadu(lanes.phase + v);
+            auto a = V::loadu(lanes.amp + v);
+            auto y = V::loadu(lanes.lp_state + v);
+            for (uint32 i = 0; i < n; ++i) {
+                // linear interpolation; phase below 1 keeps the index within the level's guard samples
+                const auto pos = V::mul(p, scale);
+                const auto idx = V::trunc(pos);
+                const auto at = V::add(off, idx);
+                const auto s0 = V::gather(table, at);
+                const auto s1 = V::gather(table, V::add(at, one));
+                const auto s = V::madd(V::sub(pos, idx), V::sub(s1, s0), s0);
+                y = V::madd(lp, V::sub(s, y), y);
+                V::store(acc + i * V::WIDTH, V::madd(y, a, V::load(acc + i * V::WIDTH)));
+                p = V::add(p, step);
+                p = V::sub(p, V::trunc(p));
+                a = V::add(a, da);
+            }
+            V::storeu(lanes.phase + v, p);
+            V::storeu(lanes.amp + v, a);
+            V::storeu(lanes.lp_state + v, y);
+        }
+
+        for (uint32 i = 0; i < n; ++i)
+            out[f + i] += hsum(V::load(acc + i * V::WIDTH));
+    }
+}
+
+} // namespace
+
+extern const Dsp_Kernels SB_KERNELS;
+const Dsp_Kernels SB_KERNELS = {
+    .isa = SB_KERNELS_ISA,
+    .fir = fir,
+    .fir_folded = fir_folded,
+    .dot = dot,
+    .madd = madd,
+    .complex_madd = complex_madd,
+    .biquad_lanes = biquad_lanes<V8, float32>,
+    .biquad_lanes_f64 = biquad_lanes<V8_F64, float64>,
+    .exp = array_exp,
+    .log = array_log,
+    .sin = array_sin,
+    .cos = array_cos,
+    .tanh = array_tanh,
+    .db_to_linear = array_db_to_linear,
+    .linear_to_db = array_linear_to_db,
+    .pow = array_pow,
+    .biquad_response = biquad_response,
+    .wavetable = wavetable,
+};
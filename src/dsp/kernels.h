@@ -0,0 +1,81 @@
+#pragma once
+
+#include "cpu.h"
+
+// oscillator voices in structure-of-arrays form, one lane per voice, count a multiple of SIMD_MAX_WIDTH
+struct Dsp_Wavetable_Lanes final {
+    // each voice's level start in the table, as a whole number
+    const float32* offset;
+    // cycles per frame
+    const float32* inc;
+    // in cycles, in [0, 1)
+    float32* phase;
+    float32* amp;
+    // added to amp every frame
+    const float32* amp_step;
+    // a one-pole lowpass, y += coeff * (x - y), between oscillator and amp; a coeff of 1 passes straight
+    const float32* lp_coeff;
+    float32* lp_state;
+    uint32 count;
+};
+
+// the hot inner loops, compiled once per instruction set from kernels.cpp and picked at runtime, so one
+// binary uses avx2 or avx-512 where it can and still runs on a plain x86-64 machine. only pointers and
+// counts cross this boundary; the callers own the layout and the state.
+struct Dsp_Kernels final {
+    Cpu_Isa isa;
+
+    // out[n] = sum over k of h[k] * x[n + k], for n below count
+    void (*fir)(const float32* x, const float32* h, uint32 taps, float32* out, uint32 count);
+    // the same, for h[k] == h[taps - 1 - k]
+    void (*fir_folded)(const float32* x, const float32* h, uint32 taps, float32* out, uint32 count);
+    // sum over k of h[k] * x[k]
+    float32 (*dot)(const float32* x, const float32* h, uint32 count);
+    // out[k] = a[k] * s + b[k]
+    void (*madd)(const float32* a, float32 s, const float32* b, float32* out, uint32 count);
+    // acc += x * h over split complex arrays
+    void (*complex_madd)(
+        const float32* x_re, const float32* x_im, const float32* h_re, const float32* h_im, float32* acc_re,
+        float32* acc_im, uint32 count);
+    // one tdf-ii biquad section over BIQUAD_KERNEL_LANES lanes, lane l of frame i at buf[i * lanes + l].
+    // coeffs holds b0, b1, b2, a1, a2 and state s1, s2, one row of lanes each.
+    void (*biquad_lanes)(const float32* coeffs, float32* state, float32* buf, uint32 frame_count);
+    void (*biquad_lanes_f64)(const float64* coeffs, float64* state, float64* buf, uint32 frame_count);
+
+    // elementwise over count values with the functions in simd_math.h, which documents their ranges and
+    // accuracy. in and out may be the same array.
+    void (*exp)(const float32* in, float32* out, uint32 count);
+    void (*log)(const float32* in, float32* out, uint32 count);
+    void (*sin)(const float32* in, float32* out, uint32 count);
+    void (*cos)(const float32* in, float32* out, uint32 count);
+    void (*tanh)(const float32* in, float32* out, uint32 count);
+    void (*db_to_linear)(const float32* in, float32* out, uint32 count);
+    void (*linear_to_db)(const float32* in, float32* out, uint32 count);
+    // out[k] = x[k]^y[k]
+    void (*pow)(const float32* x, const float32* y, float32* out, uint32 count);
+
+    // one biquad section's response, coeffs b0, b1, b2, a1, a2, at count frequencies given as four rows of
+    // cos w - 1, sin w, cos 2w - 1 and sin 2w; the cosines are taken about dc so the polynomials don't
+    // cancel away their precision at low frequencies. writes magnitude in db, phase in radians and group
+    // delay in samples. count is a multiple of SIMD_MAX_WIDTH.
+    void (*biquad_response)(
+        const float32* coeffs, const float32* trig, float32* db, float32* phase, float32* delay,
+        uint32 count);
+
+    // adds the lanes' wavetable oscillators into out. table holds a Wavetable's levels of size samples
+    // each. phase, amp and the lowpass state are written back; register blocks whose voices are all silent
+    // and not ramping are skipped, lowpass state and all.
+    void (*wavetable)(
+        const float32* table, uint32 size, const Dsp_Wavetable_Lanes& lanes, float32* out,
+        uint32 frame_count);
+};
+
+inline constexpr uint32 BIQUAD_KERNEL_LANES = 8;
+
+// the table for the best level the cpu supports and that was built, picked on first use. setting SB_ISA in
+// the environment to one of cpu_isa_name's names forces a lower level.
+const Dsp_Kernels& dsp_kernels();
+
+// switches every later dsp_kernels() call to isa, e.g. to compare levels in the benchmarks. fails if the
+// level wasn't built or the cpu can't run it. not safe while another thread is processing.
+bool dsp_force_isa(Cpu_Isa isa);
@@ -0,0 +1,371 @@
+#include "nodes.h"
+#include "kernels.h"
+
+#include <cstring>
+
+Dsp_Device_Input_Node::Dsp_Device_Input_Node(uint32 channels) : channels{channels} {
+}
+
+Dsp_Node_Desc Dsp_Device_Input_Node::desc() const {
+    return {"Device Input", 0, 1, channels};
+}
+
+void Dsp_Device_Input_Node::process(const Dsp_Process_Args& args) {
+    const auto& cx = *args.context;
+    const auto& out = args.outputs[0];
+    if (!cx.device_input || cx.device_channels == 0) {
+        for (uint32 c = 0; c < channels; ++c)
+            std::memset(out.channel(c), 0, args.frame_count * sizeof(float32));
+        return;
+    }
+
+    const auto stride = cx.device_channels;
+    const auto* in = cx.device_input + static_cast<size_t>(cx.frame_offset) * stride;
+    for (uint32 c = 0; c < channels; ++c) {
+        const auto src = std::min(c, stride - 1);
+        auto* dst = out.channel(c);
+        for (uint32 i = 0; i < args.frame_count; ++i)
+            dst[i] = in[i * stride + src];
+    }
+}
+
+Dsp_Device_Output_Node::Dsp_Device_Output_Node(uint32 channels) : channels{channels} {
+}
+
+Dsp_Node_Desc Dsp_Device_Output_Node::desc() const {
+    return {"Device Output", 1, 0, channels};
+}
+
+void Dsp_Device_Output_Node::process(const Dsp_Process_Args& args) {
+    const auto& cx = *args.context;
+    if (!cx.device_output)
+        return;
+
+    const auto& in = args.inputs[0];
+    const auto stride = cx.device_channels;
+    auto* out = cx.device_output + static_cast<size_t>(cx.frame_offset) * stride;
+    for (uint32 c = 0; c < stride; ++c) {
+        const auto* src = in.channel(std::min(c, channels - 1));
+        for (uint32 i = 0; i < args.frame_count; ++i)
+            out[i * stride + c] = src[i];
+    }
+}
+
+Dsp_Sine_Node::Dsp_Sine_Node(uint32 channels, float32 freq, float32 amplitude)
+    : channels{channels}, freq{freq}, amplitude{amplitude} {
+}
+
+Dsp_Node_Desc Dsp_Sine_Node::desc() const {
+    return {"Sine", 0, 1, channels};
+}
+
+void Dsp_Sine_Node::prepare(const Dsp_Prepare& prepare) {
+    m_inv_sample_rate = 1.0 / prepare.sample_rate;
+}
+
+void Dsp_Sine_Node::process(const Dsp_Process_Args& args) {
+    const auto& out = args.outputs[0];
+    auto* dst = out.channel(0);
+    // the phase accumulates in double; only the angles handed to the vectorized sine are float
+    auto phase = m_phase;
+    for (uint32 i = 0; i < args.frame_count; ++i) {
+        dst[i] = static_cast<float32>(2.0 * Math_Consts<float64>::pi * phase);
+        phase += static_cast<float64>(freq.next()) * m_inv_sample_rate;
+        phase -= std::floor(phase);
+    }
+    m_phase = phase;
+    dsp_kernels().sin(dst, dst, args.frame_count);
+    for (uint32 i = 0; i < args.frame_count; ++i)
+        dst[i] *= amplitude.next();
+    for (uint32 c = 1; c < channels; ++c)
+        std::memcpy(out.channel(c), dst, args.frame_count * sizeof(float32));
+}
+
+void Dsp_Sine_Node::set_param(uint32 param, float32 value, uint32 ramp_frames) {
+    if (param == PARAM_FREQ)
+        freq.set(value, ramp_frames);
+    else if (param == PARAM_AMPLITUDE)
+        amplitude.set(value, ramp_frames);
+}
+
+Dsp_Gain_Node::Dsp_Gain_Node(uint32 channels, float32 gain) : channels{channels}, gain{gain} {
+}
+
+Dsp_Node_Desc Dsp_Gain_Node::desc() const {
+    return {"Gain", 1, 1, channels};
+}
+
+void Dsp_Gain_Node::process(const Dsp_Process_Args& args) {
+    const auto& in = args.inputs[0];
+    const auto& out = args.outputs[0];
+    for (uint32 c = 0; c < channels; ++c) {
+        const auto* src = in.channel(c);
+        auto* dst = out.channel(c);
+        if (gain.ramping()) {
+            // every channel walks the same ramp
+            auto g = gain;
+            for (uint32 i = 0; i < args.frame_count; ++i)
+                dst[i] = src[i] * g.next();
+        } else {
+            const auto g = gain.value;
+            for (uint32 i = 0; i < args.frame_count; ++i)
+                dst[i] = src[i] * g;
+        }
+    }
+    gain.advance(args.frame_count);
+}
+
+void Dsp_Gain_Node::set_param(uint32 param, float32 value, uint32 ramp_frames) {
+    if (param == PARAM_GAIN)
+        gain.set(value, ramp_frames);
+}
+
+Dsp_Saturator_Node::Dsp_Saturator_Node(uint32 channels, float32 drive, float32 output)
+    : channels{channels}, drive{drive}, output{output} {
+}
+
+Dsp_Node_Desc Dsp_Saturator_Node::desc() const {
+    return {"Saturator", 1, 1, channels};
+}
+
+void Dsp_Saturator_Node::process(const Dsp_Process_Args& args) {
+    const auto& kernels = dsp_kernels();
+    const auto& in = args.inputs[0];
+    const auto& out = args.outputs[0];
+    for (uint32 c = 0; c < channels; ++c) {
+        const auto* src = in.channel(c);
+        auto* dst = out.channel(c);
+        // every channel walks the same ramps
+        auto d = drive;
+        for (uint32 i = 0; i < args.frame_count; ++i)
+            dst[i] = src[i] * d.next();
+        kernels.tanh(dst, dst, args.frame_count);
+        auto o = output;
+        for (uint32 i = 0; i < args.frame_count; ++i)
+            dst[i] *= o.next();
+    }
+    drive.advance(args.frame_count);
+    output.advance(args.frame_count);
+}
+
+void Dsp_Saturator_Node::set_param(uint32 param, float32 value, uint32 ramp_frames) {
+    if (param == PARAM_DRIVE)
+        drive.set(value, ramp_frames);
+    else if (param == PARAM_OUTPUT)
+        output.set(value, ramp_frames);
+}
+
+template <typename T>
+Dsp_Biquad_Node_T<T>::Dsp_Biquad_Node_T(
+    uint32 channels, Biquad_Type type, float32 freq, float32 q, float32 gain_db)
+    : Dsp_Biquad_Node_T{std::allocator_arg, {}, channels, type, freq, q, gain_db} {
+}
+
+template <typename T>
+Dsp_Biquad_Node_T<T>::Dsp_Biquad_Node_T(
+    std::allocator_arg_t, const allocator_type& alloc, uint32 channels, Biquad_Type type, float32 freq,
+    float32 q, float32 gain_db)
+    : channels{channels}, m_type{type}, m_log2_freq{std::log2(freq)}, m_q{q}, m_gain_db{gain_db},
+      m_state{alloc}, m_channels{alloc} {
+    m_state.resize(channels);
+    m_channels.resize(channels);
+    design();
+}
+
+template <typename T>
+Dsp_Node_Desc Dsp_Biquad_Node_T<T>::desc() const {
+    return {"Biquad", 1, 1, channels, 0, DSP_SAMPLE_TYPE<T>, DSP_SAMPLE_TYPE<T>};
+}
+
+template <typename T>
+void Dsp_Biquad_Node_T<T>::prepare(const Dsp_Prepare& prepare) {
+    m_sample_rate = static_cast<float32>(prepare.sample_rate);
+    design();
+}
+
+template <typename T>
+void Dsp_Biquad_Node_T<T>::process(const Dsp_Process_Args& args) {
+    const auto& in = args.inputs[0];
+    const auto& out = args.outputs[0];
+    for (uint32 c = 0; c < channels; ++c) {
+        std::memcpy(out.channel_as<T>(c), in.channel_as<T>(c), args.frame_count * sizeof(T));
+    }
+
+    if (!m_log2_freq.ramping() && !m_q.ramping() && !m_gain_db.ramping()) {
+        for (uint32 c = 0; c < channels; ++c)
+            m_channels[c] = out.channel_as<T>(c);
+        biquad_cascade_planar(&m_coeffs, 1, m_state.data(), m_channels.data(), channels, args.frame_count);
+        return;
+    }
+
+    for (uint32 i = 0; i < args.frame_count; i += DSP_CONTROL_FRAMES) {
+        const auto n = std::min(DSP_CONTROL_FRAMES, args.frame_count - i);
+        // designed at the chunk's midpoint, so the coefficients neither lead nor lag the ramp
+        const auto half = n / 2;
+        m_log2_freq.advance(half);
+        m_q.advance(half);
+        m_gain_db.advance(half);
+        design();
+        m_log2_freq.advance(n - half);
+        m_q.advance(n - half);
+        m_gain_db.advance(n - half);
+        for (uint32 c = 0; c < channels; ++c)
+            m_channels[c] = out.channel_as<T>(c) + i;
+        biquad_cascade_planar(&m_coeffs, 1, m_state.data(), m_channels.data(), channels, n);
+    }
+}
+
+template <typename T>
+void Dsp_Biquad_Node_T<T>::set_param(uint32 param, float32 value, uint32 ramp_frames) {
+    if (param == PARAM_FREQ)
+        m_log2_freq.set(std::log2(std::max(value, 1.f)), ramp_frames);
+    else if (param == PARAM_Q)
+        m_q.set(value, ramp_frames);
+    else if (param == PARAM_GAIN_DB)
+        m_gain_db.set(value, ramp_frames);
+    else
+        return;
+
+    if (ramp_frames == 0)
+        design();
+}
+
+template <typename T>
+void Dsp_Biquad_Node_T<T>::set(Biquad_Type type, float32 freq, float32 q, float32 gain_db) {
+    m_type = type;
+    m_log2_freq.set(std::log2(freq), 0);
+    m_q.set(q, 0);
+    m_gain_db.set(gain_db, 0);
+    design();
+}
+
+template <typename T>
+void Dsp_Biquad_Node_T<T>::design() {
+    m_coeffs = biquad_design<T>(
+        m_type, m_sample_rate, std::exp2(m_log2_freq.value), m_q.value, m_gain_db.value);
+}
+
+template <typename T>
+Dsp_Graphic_Eq_Node_T<T>::Dsp_Graphic_Eq_Node_T(uint32 channels, uint32 bands, float32 q)
+    : Dsp_Graphic_Eq_Node_T{std::allocator_arg, {}, channels, bands, q} {
+}
+
+template <typename T>
+Dsp_Graphic_Eq_Node_T<T>::Dsp_Graphic_Eq_Node_T(
+    std::allocator_arg_t, const allocator_type& alloc, uint32 channels, uint32 bands, float32 q)
+    : channels{channels}, m_q{q}, m_gains_db{alloc}, m_sections{alloc}, m_state{alloc}, m_channels{alloc} {
+    m_gains_db.resize(bands, Dsp_Smoothed{0.f});
+    m_sections.resize(bands);
+    m_state.resize(static_cast<size_t>(bands) * channels);
+    m_channels.resize(channels);
+}
+
+template <typename T>
+Dsp_Node_Desc Dsp_Graphic_Eq_Node_T<T>::desc() const {
+    return {"Graphic EQ", 1, 1, channels, 0, DSP_SAMPLE_TYPE<T>, DSP_SAMPLE_TYPE<T>};
+}
+
+template <typename T>
+void Dsp_Graphic_Eq_Node_T<T>::prepare(const Dsp_Prepare& prepare) {
+    m_sample_rate = static_cast<float32>(prepare.sample_rate);
+    for (uint32 b = 0; b < m_sections.size(); ++b)
+        design(b);
+}
+
+template <typename T>
+void Dsp_Graphic_Eq_Node_T<T>::process(const Dsp_Process_Args& args) {
+    const auto& in = args.inputs[0];
+    const auto& out = args.outputs[0];
+    for (uint32 c = 0; c < channels; ++c) {
+        std::memcpy(out.channel_as<T>(c), in.channel_as<T>(c), args.frame_count * sizeof(T));
+    }
+
+    const auto bands = static_cast<uint32>(m_sections.size());
+    for (uint32 i = 0; i < args.frame_count;) {
+        auto n = args.frame_count - i;
+        for (uint32 b = 0; b < bands && n > DSP_CONTROL_FRAMES; ++b) {
+            if (m_gains_db[b].ramping())
+                n = DSP_CONTROL_FRAMES;
+        }
+        // at the chunk's midpoint, as in the single biquad
+        for (uint32 b = 0; b < bands; ++b) {
+            if (m_gains_db[b].ramping()) {
+                m_gains_db[b].advance(n / 2);
+                design(b);
+                m_gains_db[b].advance(n - n / 2);
+            }
+        }
+        for (uint32 c = 0; c < channels; ++c)
+            m_channels[c] = out.channel_as<T>(c) + i;
+        biquad_cascade_planar(m_sections.data(), bands, m_state.data(), m_channels.data(), channels, n);
+        i += n;
+    }
+}
+
+template <typename T>
+void Dsp_Graphic_Eq_Node_T<T>::set_gain(uint32 band, float32 gain_db) {
+    m_gains_db[band].set(gain_db, 0);
+    design(band);
+}
+
+template <typename T>
+void Dsp_Graphic_Eq_Node_T<T>::set_param(uint32 param, float32 value, uint32 ramp_frames) {
+    if (param >= m_gains_db.size())
+        return;
+    m_gains_db[param].set(value, ramp_frames);
+    if (ramp_frames == 0)
+        design(param);
+}
+
+template <typename T>
+void Dsp_Graphic_Eq_Node_T<T>::design(uint32 band) {
+    const auto freq = 31.25f * static_cast<float32>(1u << band);
+    m_sections[band] =
+        biquad_design<T>(Biquad_Type::Peak, m_sample_rate, freq, m_q, m_gains_db[band].value);
+}
+
+template struct Dsp_Biquad_Node_T<float32>;
+template struct Dsp_Biquad_Node_T<float64>;
+template struct Dsp_Graphic_Eq_Node_T<float32>;
+template struct Dsp_Graphic_Eq_Node_T<float64>;
+
+Dsp_Mixer_Node::Dsp_Mixer_Node(uint32 channels, uint32 inputs)
+    : Dsp_Mixer_Node{std::allocator_arg, {}, channels, inputs} {
+}
+
+Dsp_Mixer_Node::Dsp_Mixer_Node(
+    std::allocator_arg_t, const allocator_type& alloc, uint32 channels, uint32 inputs)
+    : channels{channels}, gains{alloc} {
+    gains.resize(inputs, Dsp_Smoothed{1.f});
+}
+
+Dsp_Node_Desc Dsp_Mixer_Node::desc() const {
+    return {"Mixer", static_cast<uint32>(gains.size()), 1, channels};
+}
+
+void Dsp_Mixer_Node::process(const Dsp_Process_Args& args) {
+    const auto& out = args.outputs[0];
+    for (uint32 c = 0; c < channels; ++c) {
+        auto* dst = out.channel(c);
+        std::memset(dst, 0, args.frame_count * sizeof(float32));
+        for (uint32 k = 0; k < args.input_count; ++k) {
+            const auto* src = args.inputs[k].channel(c);
+            if (gains[k].ramping()) {
+                auto g = gains[k];
+                for (uint32 i = 0; i < args.frame_count; ++i)
+                    dst[i] += src[i] * g.next();
+            } else {
+                const auto g = gains[k].value;
+                for (uint32 i = 0; i < args.frame_count; ++i)
+                    dst[i] += src[i] * g;
+            }
+        }
+    }
+    for (auto& g : gains)
+        g.advance(args.frame_count);
+}
+
+void Dsp_Mixer_Node::set_param(uint32 param, float32 value, uint32 ramp_frames) {
+    if (param < gains.size())
+        gains[param].set(value, ramp_frames);
+}
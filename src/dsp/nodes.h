@@ -0,0 +1,169 @@
+#pragma once
+
+#include "graph.h"
+#include "biquad.h"
+
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// reads the device capture buffer
+struct Dsp_Device_Input_Node final {
+    explicit Dsp_Device_Input_Node(uint32 channels);
+
+    Dsp_Node_Desc desc() const;
+    void process(const Dsp_Process_Args& args);
+
+    uint32 channels;
+};
+
+// writes the device playback buffer; a graph should contain at most one
+struct Dsp_Device_Output_Node final {
+    explicit Dsp_Device_Output_Node(uint32 channels);
+
+    Dsp_Node_Desc desc() const;
+    void process(const Dsp_Process_Args& args);
+
+    uint32 channels;
+};
+
+struct Dsp_Sine_Node final {
+    static constexpr uint32 PARAM_FREQ = 0;
+    static constexpr uint32 PARAM_AMPLITUDE = 1;
+
+    Dsp_Sine_Node(uint32 channels, float32 freq, float32 amplitude);
+
+    Dsp_Node_Desc desc() const;
+    void prepare(const Dsp_Prepare& prepare);
+    void process(const Dsp_Process_Args& args);
+    void set_param(uint32 param, float32 value, uint32 ramp_frames);
+
+    uint32 channels;
+    Dsp_Smoothed freq;
+    Dsp_Smoothed amplitude;
+
+  private:
+    float64 m_phase = 0.0;
+    float64 m_inv_sample_rate = 0.0;
+};
+
+struct Dsp_Gain_Node final {
+    static constexpr uint32 PARAM_GAIN = 0;
+
+    Dsp_Gain_Node(uint32 channels, float32 gain);
+
+    Dsp_Node_Desc desc() const;
+    void process(const Dsp_Process_Args& args);
+    void set_param(uint32 param, float32 value, uint32 ramp_frames);
+
+    uint32 channels;
+    Dsp_Smoothed gain;
+};
+
+// tanh soft clipper, out = tanh(in * drive) * output with both as linear gains. wrap it in
+// Dsp_Oversampled_Node to keep the harmonics it adds from folding back.
+struct Dsp_Saturator_Node final {
+    static constexpr uint32 PARAM_DRIVE = 0;
+    static constexpr uint32 PARAM_OUTPUT = 1;
+
+    Dsp_Saturator_Node(uint32 channels, float32 drive, float32 output = 1.f);
+
+    Dsp_Node_Desc desc() const;
+    void process(const Dsp_Process_Args& args);
+    void set_param(uint32 param, float32 value, uint32 ramp_frames);
+
+    uint32 channels;
+    Dsp_Smoothed drive;
+    Dsp_Smoothed output;
+};
+
+// T is the precision it filters in and the type of its ports; Dsp_Biquad_Node_F64 keeps low, sharp filters
+// clean, with the schedule converting at the edges to float32 neighbours
+template <typename T>
+struct Dsp_Biquad_Node_T final {
+    static constexpr uint32 PARAM_FREQ = 0;
+    static constexpr uint32 PARAM_Q = 1;
+    static constexpr uint32 PARAM_GAIN_DB = 2;
+
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    Dsp_Biquad_Node_T(uint32 channels, Biquad_Type type, float32 freq, float32 q, float32 gain_db = 0.f);
+    Dsp_Biquad_Node_T(
+        std::allocator_arg_t, const allocator_type& alloc, uint32 channels, Biquad_Type type, float32 freq,
+        float32 q, float32 gain_db = 0.f);
+
+    Dsp_Node_Desc desc() const;
+    void prepare(const Dsp_Prepare& prepare);
+    void process(const Dsp_Process_Args& args);
+    // frequency ramps in octaves so sweeps sound even across the spectrum
+    void set_param(uint32 param, float32 value, uint32 ramp_frames);
+
+    // recomputes coefficients; not safe to call while the owning schedule is processing
+    void set(Biquad_Type type, float32 freq, float32 q, float32 gain_db);
+
+    uint32 channels;
+
+  private:
+    void design();
+
+    Biquad_Type m_type;
+    Dsp_Smoothed m_log2_freq;
+    Dsp_Smoothed m_q;
+    Dsp_Smoothed m_gain_db;
+    float32 m_sample_rate = 48000.f;
+
+    Biquad_Coeffs_T<T> m_coeffs;
+    std::pmr::vector<Biquad_State_T<T>> m_state;
+    std::pmr::vector<T*> m_channels;
+};
+
+using Dsp_Biquad_Node = Dsp_Biquad_Node_T<float32>;
+using Dsp_Biquad_Node_F64 = Dsp_Biquad_Node_T<float64>;
+
+// cascade of peaking sections at octave-spaced centres from 31.25 hz, in T like Dsp_Biquad_Node_T
+template <typename T>
+struct Dsp_Graphic_Eq_Node_T final {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    Dsp_Graphic_Eq_Node_T(uint32 channels, uint32 bands, float32 q = 1.41f);
+    Dsp_Graphic_Eq_Node_T(
+        std::allocator_arg_t, const allocator_type& alloc, uint32 channels, uint32 bands, float32 q = 1.41f);
+
+    Dsp_Node_Desc desc() const;
+    void prepare(const Dsp_Prepare& prepare);
+    void process(const Dsp_Process_Args& args);
+
+    void set_gain(uint32 band, float32 gain_db);
+    // param i is band i's gain in db
+    void set_param(uint32 param, float32 value, uint32 ramp_frames);
+
+    uint32 channels;
+
+  private:
+    void design(uint32 band);
+
+    float32 m_q;
+    float32 m_sample_rate = 48000.f;
+    std::pmr::vector<Dsp_Smoothed> m_gains_db;
+    std::pmr::vector<Biquad_Coeffs_T<T>> m_sections;
+    std::pmr::vector<Biquad_State_T<T>> m_state;
+    std::pmr::vector<T*> m_channels;
+};
+
+using Dsp_Graphic_Eq_Node = Dsp_Graphic_Eq_Node_T<float32>;
+using Dsp_Graphic_Eq_Node_F64 = Dsp_Graphic_Eq_Node_T<float64>;
+
+// sums its inputs, each scaled by its own gain. param i is input i's gain.
+struct Dsp_Mixer_Node final {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    Dsp_Mixer_Node(uint32 channels, uint32 inputs);
+    Dsp_Mixer_Node(std::allocator_arg_t, const allocator_type& alloc, uint32 channels, uint32 inputs);
+
+    Dsp_Node_Desc desc() const;
+    void process(const Dsp_Process_Args& args);
+    void set_param(uint32 param, float32 value, uint32 ramp_frames);
+
+    uint32 channels;
+    std::pmr::vector<Dsp_Smoothed> gains;
+};
@@ -0,0 +1,62 @@
+#include "offline.h"
+
+#include <miniaudio.h>
+#include <chrono>
+
+// dest(done, frames) returns where to render the next period, done(ptr, frames) consumes it
+template <typename Dest, typename Done>
+static Offline_Render_Stats
+render_periods(Dsp_Schedule& schedule, uint64 frame_count, uint32 block_frames, Dest&& dest, Done&& done) {
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64 pos = 0; pos < frame_count;) {
+        const auto frames = static_cast<uint32>(std::min<uint64>(block_frames, frame_count - pos));
+        auto* out = dest(pos, frames);
+        schedule.process(nullptr, out, frames);
+        done(out, frames);
+        pos += frames;
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    Offline_Render_Stats stats;
+    stats.frames = frame_count;
+    stats.audio_seconds = static_cast<float64>(frame_count) / schedule.sample_rate();
+    stats.wall_seconds = std::chrono::duration<float64>(end - start).count();
+    stats.realtime_factor = stats.wall_seconds > 0.0 ? stats.audio_seconds / stats.wall_seconds : 0.0;
+    return stats;
+}
+
+Offline_Render_Stats dsp_render_offline(
+    Dsp_Schedule& schedule, uint64 frame_count, uint32 block_frames, std::vector<float32>& out) {
+    const auto channels = schedule.device_channels();
+    out.assign(frame_count * channels, 0.f);
+    return render_periods(
+        schedule, frame_count, block_frames,
+        [&](uint64 pos, uint32) { return out.data() + pos * channels; }, [](float32*, uint32) {});
+}
+
+std::optional<Offline_Render_Stats> dsp_render_offline_wav(
+    Dsp_Schedule& schedule, uint64 frame_count, uint32 block_frames, const char* path) {
+    const auto channels = schedule.device_channels();
+
+    const auto config =
+        ma_encoder_config_init(ma_encoding_format_wav, ma_format_f32, channels, schedule.sample_rate());
+    ma_encoder encoder;
+    if (ma_encoder_init_file(path, &config, &encoder) != MA_SUCCESS)
+        return std::nullopt;
+
+    // the render runs to the end either way, only the writes stop after one fails
+    bool ok = true;
+    std::vector<float32> block(static_cast<size_t>(block_frames) * channels, 0.f);
+    const auto stats = render_periods(
+        schedule, frame_count, block_frames, [&](uint64, uint32) { return block.data(); },
+        [&](float32* data, uint32 frames) {
+            ma_uint64 written = 0;
+            ok = ok && ma_encoder_write_pcm_frames(&encoder, data, frames, &written) == MA_SUCCESS &&
+                 written == frames;
+        });
+
+    ma_encoder_uninit(&encoder);
+    if (!ok)
+        return std::nullopt;
+    return stats;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "graph.h"
+
+#include <optional>
+#include <vector>
+
+struct Offline_Render_Stats final {
+    uint64 frames = 0;
+    float64 audio_seconds = 0.0;
+    float64 wall_seconds = 0.0;
+    // audio seconds rendered per wall-clock second
+    float64 realtime_factor = 0.0;
+};
+
+// drives the schedule exactly like the device callback would, in periods of block_frames, with silence on the
+// device input, as fast as the cpu allows. output is interleaved with schedule.device_channels() channels.
+Offline_Render_Stats dsp_render_offline(
+    Dsp_Schedule& schedule, uint64 frame_count, uint32 block_frames, std::vector<float32>& out);
+
+// same as dsp_render_offline, streaming each period into a 32-bit float wav file instead of memory.
+// returns nothing if the file could not be opened or a write fell short, a full disk say.
+std::optional<Offline_Render_Stats> dsp_render_offline_wav(
+    Dsp_Schedule& schedule, uint64 frame_count, uint32 block_frames, const char* path);
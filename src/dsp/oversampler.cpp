@@ -0,0 +1,186 @@
+#include "oversampler.h"
+
+#include <algorithm>
+#include <cstring>
+
+// rejection of every stage, and how much of the original band stays flat
+static constexpr float64 OVERSAMPLER_ATTEN_DB = 90.0;
+static constexpr float64 OVERSAMPLER_PASSBAND = 0.9;
+
+Halfband_Stage::Halfband_Stage(const allocator_type& alloc)
+    : m_branch{alloc}, m_delay{alloc}, m_scratch{alloc} {
+}
+
+Halfband_Stage::Halfband_Stage(Halfband_Stage&& other, const allocator_type& alloc)
+    : m_branch{std::move(other.m_branch), alloc}, m_delay{std::move(other.m_delay), alloc},
+      m_delay_frames{other.m_delay_frames}, m_scratch{std::move(other.m_scratch), alloc},
+      m_max_frames{other.m_max_frames}, m_last{other.m_last} {
+}
+
+void Halfband_Stage::create(
+    Halfband_Direction direction, float64 transition, float64 atten_db, uint32 max_low_frames) {
+    // 4k + 3 taps put non-zero taps at both ends and the centre on an odd index
+    const auto kaiser = fir_kaiser_taps(atten_db, transition, 1.0);
+    const auto k = (std::max<uint32>(kaiser, 7) - 3 + 3) / 4;
+    const auto taps = k * 4 + 3;
+    const auto h = fir_design_windowed_sinc(
+        Fir_Response::Lowpass, taps, 1.0, 0.25, 0.0, Fir_Window::Kaiser, fir_kaiser_beta(atten_db));
+
+    // the even taps, rescaled so the whole filter has exactly unity gain at dc. interpolation makes up
+    // for the stuffed zeros with a gain of two.
+    std::vector<float32> branch(taps / 2 + 1);
+    auto sum = 0.0;
+    for (uint32 i = 0; i < branch.size(); ++i) {
+        branch[i] = h[i * 2];
+        sum += h[i * 2];
+    }
+    const auto gain = (direction == Halfband_Direction::Up ? 1.0 : 0.5) / sum;
+    for (auto& t : branch)
+        t = static_cast<float32>(t * gain);
+
+    m_branch.create(branch, max_low_frames);
+    m_delay_frames = k;
+    m_delay.assign(k + max_low_frames, 0.f);
+    m_scratch.assign(static_cast<size_t>(max_low_frames) * 2, 0.f);
+    m_max_frames = max_low_frames;
+    m_last = 0.f;
+}
+
+void Halfband_Stage::reset() {
+    m_branch.reset();
+    std::fill(m_delay.begin(), m_delay.end(), 0.f);
+    m_last = 0.f;
+}
+
+void Halfband_Stage::delay(const float32* in, float32* out, uint32 frames) {
+    std::memcpy(m_delay.data() + m_delay_frames, in, frames * sizeof(float32));
+    std::memcpy(out, m_delay.data(), frames * sizeof(float32));
+    std::memmove(m_delay.data(), m_delay.data() + frames, m_delay_frames * sizeof(float32));
+}
+
+void Halfband_Stage::upsample(const float32* in, float32* out, uint32 low_frames) {
+    for (uint32 done = 0; done < low_frames;) {
+        const auto n = std::min(low_frames - done, m_max_frames);
+        auto* even = m_scratch.data();
+        auto* odd = m_scratch.data() + m_max_frames;
+        m_branch.process(in + done, even, n);
+        delay(in + done, odd, n);
+
+        auto* dst = out + static_cast<size_t>(done) * 2;
+        for (uint32 i = 0; i < n; ++i) {
+            dst[i * 2] = even[i];
+            dst[i * 2 + 1] = odd[i];
+        }
+        done += n;
+    }
+}
+
+void Halfband_Stage::downsample(const float32* in, float32* out, uint32 low_frames) {
+    for (uint32 done = 0; done < low_frames;) {
+        const auto n = std::min(low_frames - done, m_max_frames);
+        const auto* src = in + static_cast<size_t>(done) * 2;
+        auto* even = m_scratch.data();
+        auto* odd = m_scratch.data() + m_max_frames;
+
+        // output m sees even frame 2m through the branch and odd frame 2m - 1 through the centre tap
+        odd[0] = m_last;
+        for (uint32 i = 0; i < n; ++i) {
+            even[i] = src[i * 2];
+            if (i + 1 < n)
+                odd[i + 1] = src[i * 2 + 1];
+        }
+        m_last = src[n * 2 - 1];
+
+        m_branch.process(even, out + done, n);
+        delay(odd, even, n);
+        for (uint32 i = 0; i < n; ++i)
+            out[done + i] += even[i] * 0.5f;
+        done += n;
+    }
+}
+
+Oversampler::Oversampler(const allocator_type& alloc)
+    : m_up{alloc}, m_down{alloc}, m_scratch{alloc}, m_pad{alloc} {
+}
+
+Oversampler::Oversampler(Oversampler&& other, const allocator_type& alloc)
+    : m_factor{other.m_factor}, m_up{std::move(other.m_up), alloc}, m_down{std::move(other.m_down), alloc},
+      m_scratch{std::move(other.m_scratch), alloc}, m_scratch_frames{other.m_scratch_frames},
+      m_pad{std::move(other.m_pad), alloc}, m_pad_frames{other.m_pad_frames}, m_latency{other.m_latency} {
+}
+
+void Oversampler::create(uint32 factor, uint32 max_frames) {
+    sb_ASSERT(factor > 0 && factor <= MAX_FACTOR && (factor & (factor - 1)) == 0);
+    m_factor = factor;
+
+    uint32 stages = 0;
+    while ((1u << stages) < factor)
+        ++stages;
+    m_up.resize(stages);
+    m_down.resize(stages);
+
+    for (uint32 s = 0; s < stages; ++s) {
+        // the kept band in cycles per sample at this stage's high rate; the stopband mirrors it
+        const auto passband = OVERSAMPLER_PASSBAND * 0.5 / static_cast<float64>(2u << s);
+        const auto transition = 0.5 - passband * 2.0;
+        const auto low_frames = max_frames << s;
+        m_up[s].create(Halfband_Direction::Up, transition, OVERSAMPLER_ATTEN_DB, low_frames);
+        m_down[s].create(Halfband_Direction::Down, transition, OVERSAMPLER_ATTEN_DB, low_frames);
+    }
+
+    m_scratch_frames = max_frames * factor / 2;
+    m_scratch.assign(stages > 1 ? static_cast<size_t>(m_scratch_frames) * 2 : 0, 0.f);
+
+    // each stage delays by its group delay on the way up and again on the way down, at its own high rate
+    uint32 high = 0;
+    for (uint32 s = 0; s < stages; ++s)
+        high += m_up[s].latency() * (factor >> s);
+    m_pad_frames = (factor - high % factor) % factor;
+    m_pad.assign(m_pad_frames > 0 ? m_pad_frames + max_frames * factor : 0, 0.f);
+    m_latency = (high + m_pad_frames) / factor;
+}
+
+void Oversampler::reset() {
+    for (auto& stage : m_up)
+        stage.reset();
+    for (auto& stage : m_down)
+        stage.reset();
+    std::fill(m_pad.begin(), m_pad.end(), 0.f);
+}
+
+void Oversampler::upsample(const float32* in, float32* out, uint32 frames) {
+    if (m_up.empty()) {
+        std::memcpy(out, in, frames * sizeof(float32));
+        return;
+    }
+
+    const auto stages = static_cast<uint32>(m_up.size());
+    const auto* src = in;
+    for (uint32 s = 0; s < stages; ++s) {
+        auto* dst = s + 1 == stages ? out : m_scratch.data() + (s & 1) * m_scratch_frames;
+        m_up[s].upsample(src, dst, frames << s);
+        src = dst;
+    }
+
+    if (m_pad_frames > 0) {
+        const auto n = frames * m_factor;
+        std::memcpy(m_pad.data() + m_pad_frames, out, n * sizeof(float32));
+        std::memcpy(out, m_pad.data(), n * sizeof(float32));
+        std::memmove(m_pad.data(), m_pad.data() + n, m_pad_frames * sizeof(float32));
+    }
+}
+
+void Oversampler::downsample(const float32* in, float32* out, uint32 frames) {
+    if (m_down.empty()) {
+        std::memcpy(out, in, frames * sizeof(float32));
+        return;
+    }
+
+    const auto stages = static_cast<uint32>(m_down.size());
+    const auto* src = in;
+    for (uint32 s = stages; s-- > 0;) {
+        auto* dst = s == 0 ? out : m_scratch.data() + (s & 1) * m_scratch_frames;
+        m_down[s].downsample(src, dst, frames << s);
+        src = dst;
+    }
+}
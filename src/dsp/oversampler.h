@@ -0,0 +1,221 @@
+#pragma once
+
+#include "graph.h"
+#include "fir.h"
+
+#include <cstring>
+#include <memory_resource>
+#include <vector>
+
+enum class Halfband_Direction { Up, Down };
+
+// one 2x step through a linear-phase half-band lowpass. every other tap of a half-band filter is zero and
+// the centre one is 1/2, so of the two polyphase branches one is a symmetric fir over half the taps, run
+// through Fir_Filter's folded kernel, and the other is a plain delay. a stage only runs in one direction.
+class Halfband_Stage final {
+  public:
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    explicit Halfband_Stage(const allocator_type& alloc = {});
+    Halfband_Stage(Halfband_Stage&& other, const allocator_type& alloc);
+
+    // transition is the width between passband and stopband edges in cycles per high-rate sample
+    void create(Halfband_Direction direction, float64 transition, float64 atten_db, uint32 max_low_frames);
+    void reset();
+
+    // low_frames in, low_frames * 2 out
+    void upsample(const float32* in, float32* out, uint32 low_frames);
+    // low_frames * 2 in, low_frames out
+    void downsample(const float32* in, float32* out, uint32 low_frames);
+
+    uint32 taps() const {
+        return m_delay_frames * 4 + 3;
+    }
+
+    // in high-rate frames
+    uint32 latency() const {
+        return m_delay_frames * 2 + 1;
+    }
+
+  private:
+    void delay(const float32* in, float32* out, uint32 frames);
+
+    Fir_Filter m_branch;
+    // the centre tap's branch: m_delay_frames of history followed by the current block
+    std::pmr::vector<float32> m_delay;
+    uint32 m_delay_frames = 0;
+    std::pmr::vector<float32> m_scratch;
+    uint32 m_max_frames = 0;
+    // the odd input frame that straddles two downsample calls
+    float32 m_last = 0.f;
+};
+
+// converts one channel to factor times the rate and back through cascaded half-band stages. the first
+// stage carries the sharp transition just above the original nyquist; later ones only have to reject
+// images far from the signal and get much shorter.
+class Oversampler final {
+  public:
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    static constexpr uint32 MAX_FACTOR = 8;
+
+    explicit Oversampler(const allocator_type& alloc = {});
+    Oversampler(Oversampler&& other, const allocator_type& alloc);
+
+    // factor is 1, 2, 4 or 8
+    void create(uint32 factor, uint32 max_frames);
+    void reset();
+
+    // frames in, frames * factor out
+    void upsample(const float32* in, float32* out, uint32 frames);
+    // frames * factor in, frames out
+    void downsample(const float32* in, float32* out, uint32 frames);
+
+    uint32 factor() const {
+        return m_factor;
+    }
+
+    // of a round trip through upsample and downsample, in base-rate frames
+    uint32 latency() const {
+        return m_latency;
+    }
+
+  private:
+    uint32 m_factor = 1;
+    std::pmr::vector<Halfband_Stage> m_up;
+    std::pmr::vector<Halfband_Stage> m_down;
+    // ping-pong between stages, max_frames * factor / 2 frames each
+    std::pmr::vector<float32> m_scratch;
+    uint32 m_scratch_frames = 0;
+    // the stages' delays add up to a fraction of a base frame; this many high-rate frames of delay after
+    // the last upsampling stage round the round trip up to a whole one
+    std::pmr::vector<float32> m_pad;
+    uint32 m_pad_frames = 0;
+    uint32 m_latency = 0;
+};
+
+// runs node T at factor times the graph's rate: every input channel is upsampled, T processes the whole
+// block at the higher rate, and every output channel is downsampled back. meant for nonlinear nodes whose
+// harmonics would otherwise alias; the filters' delay is added to T's and reported through desc().latency.
+// T sees a context with the raised sample rate and sample time and no device buffers, so device nodes
+// can't be wrapped.
+template <typename T>
+struct Dsp_Oversampled_Node final {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    template <typename... Args>
+    explicit Dsp_Oversampled_Node(uint32 factor, Args&&... arg)
+        : Dsp_Oversampled_Node{std::allocator_arg, {}, factor, std::forward<Args>(arg)...} {
+    }
+
+    template <typename... Args>
+    Dsp_Oversampled_Node(std::allocator_arg_t, const allocator_type& alloc, uint32 factor, Args&&... arg)
+        : inner{std::make_obj_using_allocator<T>(alloc, std::forward<Args>(arg)...)}, m_factor{factor},
+          m_pad{alloc}, m_up{alloc}, m_down{alloc}, m_buffers{alloc}, m_ports{alloc} {
+        sb_ASSERT(factor == 1 || factor == 2 || factor == 4 || factor == 8);
+        m_desc = inner.desc();
+        // the filters run in float32
+        sb_ASSERT(
+            m_desc.input_type == Dsp_Sample_Type::Float32 && m_desc.output_type == Dsp_Sample_Type::Float32);
+        const auto channels = m_desc.channels;
+        m_up.resize(static_cast<size_t>(m_desc.input_count) * channels);
+        m_down.resize(static_cast<size_t>(m_desc.output_count) * channels);
+        for (auto& o : m_up)
+            o.create(factor, 1);
+        if (!m_up.empty())
+            m_latency = m_up[0].latency();
+        else if (!m_down.empty()) {
+            m_down[0].create(factor, 1);
+            m_latency = m_down[0].latency();
+        }
+        m_pad_frames = (factor - m_desc.latency % factor) % factor;
+    }
+
+    Dsp_Node_Desc desc() const {
+        auto desc = m_desc;
+        desc.latency = (m_desc.latency + m_pad_frames) / m_factor + m_latency;
+        return desc;
+    }
+
+    void prepare(const Dsp_Prepare& prepare) {
+        for (auto& o : m_up)
+            o.create(m_factor, prepare.max_frames);
+        for (auto& o : m_down)
+            o.create(m_factor, prepare.max_frames);
+
+        // one high-rate block per port, inputs then outputs
+        m_stride = (prepare.max_frames * m_factor + 15) & ~15u;
+        const auto ports = m_desc.input_count + m_desc.output_count;
+        m_buffers.assign(static_cast<size_t>(ports) * m_desc.channels * m_stride, 0.f);
+        m_ports.resize(ports);
+        for (uint32 p = 0; p < ports; ++p) {
+            auto* data = m_buffers.data() + static_cast<size_t>(p) * m_desc.channels * m_stride;
+            m_ports[p] = {data, m_desc.channels, m_stride};
+        }
+        m_pad_stride = m_pad_frames + prepare.max_frames * m_factor;
+        const auto pads = m_pad_frames > 0 ? static_cast<size_t>(m_desc.output_count) * m_desc.channels : 0;
+        m_pad.assign(pads * m_pad_stride, 0.f);
+
+        if constexpr (requires(T& t, const Dsp_Prepare& p) { t.prepare(p); })
+            inner.prepare({prepare.sample_rate * m_factor, prepare.max_frames * m_factor});
+    }
+
+    void process(const Dsp_Process_Args& args) {
+        const auto channels = m_desc.channels;
+        const auto frames = args.frame_count;
+        for (uint32 i = 0; i < m_desc.input_count; ++i) {
+            for (uint32 c = 0; c < channels; ++c)
+                m_up[i * channels + c].upsample(args.inputs[i].channel(c), m_ports[i].channel(c), frames);
+        }
+
+        Dsp_Context context;
+        context.sample_rate = args.context->sample_rate * m_factor;
+        context.sample_time = args.context->sample_time * m_factor;
+        const auto* outputs = m_ports.data() + m_desc.input_count;
+        inner.process(
+            {&context, m_ports.data(), m_desc.input_count, outputs, m_desc.output_count, frames * m_factor});
+
+        for (uint32 o = 0; o < m_desc.output_count; ++o) {
+            for (uint32 c = 0; c < channels; ++c) {
+                auto* out = outputs[o].channel(c);
+                if (m_pad_frames > 0) {
+                    const auto n = frames * m_factor;
+                    auto* pad = m_pad.data() + static_cast<size_t>(o * channels + c) * m_pad_stride;
+                    std::memcpy(pad + m_pad_frames, out, n * sizeof(float32));
+                    std::memcpy(out, pad, n * sizeof(float32));
+                    std::memmove(pad, pad + n, m_pad_frames * sizeof(float32));
+                }
+                m_down[o * channels + c].downsample(out, args.outputs[o].channel(c), frames);
+            }
+        }
+    }
+
+    void set_param(uint32 param, float32 value, uint32 ramp_frames)
+        requires requires(T& t) { t.set_param(uint32{}, float32{}, uint32{}); }
+    {
+        inner.set_param(param, value, ramp_frames * m_factor);
+    }
+
+    uint32 factor() const {
+        return m_factor;
+    }
+
+    T inner;
+
+  private:
+    uint32 m_factor;
+    Dsp_Node_Desc m_desc;
+    // the filters' round trip, in base-rate frames
+    uint32 m_latency = 0;
+    // T's latency in high-rate frames is rarely a multiple of the factor; this many more frames of delay on
+    // each of its output channels round it up to a whole base frame
+    std::pmr::vector<float32> m_pad;
+    uint32 m_pad_frames = 0;
+    uint32 m_pad_stride = 0;
+    // per input channel, then per output channel
+    std::pmr::vector<Oversampler> m_up;
+    std::pmr::vector<Oversampler> m_down;
+    std::pmr::vector<float32> m_buffers;
+    std::pmr::vector<Dsp_Buffer> m_ports;
+    uint32 m_stride = 0;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "util.h"
+
+#include <rigtorp/SPSCQueue.h>
+
+using Dsp_Node_Id = uint32;
+
+struct Dsp_Param_Event final {
+    Dsp_Node_Id node;
+    uint32 param;
+    float32 value;
+    // engine sample time at which the change starts; times already in the past apply at the start of the
+    // next block
+    uint64 time;
+    // frames to ramp from the current value to the new one
+    uint32 ramp_frames;
+};
+
+// frames between coefficient recomputations while a parameter that's expensive to apply is ramping
+static constexpr uint32 DSP_CONTROL_FRAMES = 16;
+
+// ui -> audio thread. events must be pushed in non-decreasing time order.
+using Dsp_Param_Queue = rigtorp::SPSCQueue<Dsp_Param_Event>;
+
+// linear ramp towards a target, stepped by the audio thread
+struct Dsp_Smoothed final {
+    float32 value = 0.f;
+    float32 target = 0.f;
+    float32 step = 0.f;
+    uint32 remaining = 0;
+
+    explicit Dsp_Smoothed(float32 v = 0.f) : value{v}, target{v} {
+    }
+
+    void set(float32 t, uint32 ramp_frames) {
+        target = t;
+        if (ramp_frames == 0) {
+            value = t;
+            step = 0.f;
+            remaining = 0;
+            return;
+        }
+        step = (t - value) / static_cast<float32>(ramp_frames);
+        remaining = ramp_frames;
+    }
+
+    bool ramping() const {
+        return remaining > 0;
+    }
+
+    float32 next() {
+        if (remaining > 0) {
+            value = --remaining == 0 ? target : value + step;
+        }
+        return value;
+    }
+
+    float32 advance(uint32 frames) {
+        if (frames >= remaining) {
+            value = target;
+            remaining = 0;
+        } else {
+            value += step * static_cast<float32>(frames);
+            remaining -= frames;
+        }
+        return value;
+    }
+};
@@ -0,0 +1,127 @@
+#include "resampler.h"
+#include "fir.h"
+#include "kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+struct Resampler_Spec final {
+    uint32 taps;
+    uint32 phases;
+    // fraction of the lower of the two nyquists that is kept flat
+    float64 passband;
+    float64 atten_db;
+};
+
+static constexpr Resampler_Spec RESAMPLER_SPECS[] = {
+    {8, 64, 0.80, 50.0},
+    {16, 128, 0.88, 75.0},
+    {32, 256, 0.93, 100.0},
+    {64, 512, 0.96, 120.0},
+};
+
+void Sinc_Resampler::create(
+    uint32 channels, uint32 in_rate, uint32 out_rate, Resampler_Quality quality, uint32 max_input_frames) {
+    sb_ASSERT(channels > 0 && in_rate > 0 && out_rate > 0 && max_input_frames > 0);
+    const auto& spec = RESAMPLER_SPECS[static_cast<uint32>(quality)];
+
+    const auto gcd = std::gcd(in_rate, out_rate);
+    m_in_step = in_rate / gcd;
+    m_out_step = out_rate / gcd;
+
+    // downsampling narrows the cutoff, so the kernel stretches to keep the same transition in output terms
+    const auto ratio = std::max(1.0, static_cast<float64>(in_rate) / out_rate);
+    // a multiple of 8 keeps the dot products clear of their scalar tails up to avx
+    m_taps = (static_cast<uint32>(std::ceil(spec.taps * ratio)) + 7) / 8 * 8;
+    m_phases = spec.phases;
+    m_phase_scale = static_cast<float64>(m_phases) / static_cast<float64>(m_out_step);
+    m_channels = channels;
+
+    const auto cutoff = spec.passband / ratio;
+    const auto beta = fir_kaiser_beta(spec.atten_db);
+    const auto half = static_cast<float64>(m_taps / 2);
+
+    // row p is the kernel for an output p / phases of a frame past tap taps / 2 - 1
+    m_rows.assign(static_cast<size_t>(m_phases + 1) * m_taps, 0.f);
+    for (uint32 p = 0; p <= m_phases; ++p) {
+        const auto frac = static_cast<float64>(p) / m_phases;
+        auto* row = m_rows.data() + static_cast<size_t>(p) * m_taps;
+        for (uint32 j = 0; j < m_taps; ++j) {
+            const auto t = static_cast<float64>(j) - (half - 1.0) - frac;
+            const auto x = Math_Consts<float64>::pi * cutoff * t;
+            const auto sinc = x == 0.0 ? 1.0 : std::sin(x) / x;
+            row[j] = static_cast<float32>(cutoff * sinc * fir_window(Fir_Window::Kaiser, t / half, beta));
+        }
+    }
+    m_deltas.assign(static_cast<size_t>(m_phases) * m_taps, 0.f);
+    for (size_t i = 0; i < m_deltas.size(); ++i)
+        m_deltas[i] = m_rows[i + m_taps] - m_rows[i];
+    m_kernel.assign(m_taps, 0.f);
+
+    // room for a full kernel of leftovers plus the largest block
+    m_capacity = m_taps * 2 + max_input_frames;
+    m_history.assign(static_cast<size_t>(m_capacity) * channels, 0.f);
+    reset();
+}
+
+void Sinc_Resampler::reset() {
+    // primed with half a kernel of silence so the first output lines up with the first input frame
+    std::fill(m_history.begin(), m_history.end(), 0.f);
+    m_fill = m_taps / 2 - 1;
+    m_index = 0;
+    m_frac = 0;
+}
+
+uint32 Sinc_Resampler::input_frames_needed(uint32 out_frames) const {
+    if (out_frames == 0)
+        return 0;
+    const auto last = m_index + (m_frac + static_cast<uint64>(out_frames - 1) * m_in_step) / m_out_step;
+    const auto need = last + m_taps;
+    return need > m_fill ? static_cast<uint32>(need - m_fill) : 0;
+}
+
+uint32 Sinc_Resampler::process(const float32* in, uint32 in_frames, float32* out, uint32 max_out_frames) {
+    const auto& kernels = dsp_kernels();
+    sb_ASSERT(m_fill + in_frames <= m_capacity);
+
+    for (uint32 c = 0; c < m_channels; ++c) {
+        auto* dst = m_history.data() + static_cast<size_t>(c) * m_capacity + m_fill;
+        for (uint32 i = 0; i < in_frames; ++i)
+            dst[i] = in[static_cast<size_t>(i) * m_channels + c];
+    }
+    m_fill += in_frames;
+
+    uint32 written = 0;
+    while (written < max_out_frames && m_index + m_taps <= m_fill) {
+        const auto pos = static_cast<float32>(static_cast<float64>(m_frac) * m_phase_scale);
+        const auto phase = std::min(static_cast<uint32>(pos), m_phases - 1);
+        const auto blend = pos - static_cast<float32>(phase);
+        const auto* row = m_rows.data() + static_cast<size_t>(phase) * m_taps;
+        const auto* delta = m_deltas.data() + static_cast<size_t>(phase) * m_taps;
+        kernels.madd(delta, blend, row, m_kernel.data(), m_taps);
+
+        for (uint32 c = 0; c < m_channels; ++c) {
+            const auto* x = m_history.data() + static_cast<size_t>(c) * m_capacity + m_index;
+            out[static_cast<size_t>(written) * m_channels + c] = kernels.dot(x, m_kernel.data(), m_taps);
+        }
+        ++written;
+
+        m_frac += m_in_step;
+        m_index += static_cast<uint32>(m_frac / m_out_step);
+        m_frac %= m_out_step;
+    }
+
+    // drop what no future output can reach
+    const auto consumed = std::min(m_index, m_fill);
+    if (consumed > 0) {
+        for (uint32 c = 0; c < m_channels; ++c) {
+            auto* x = m_history.data() + static_cast<size_t>(c) * m_capacity;
+            std::memmove(x, x + consumed, (m_fill - consumed) * sizeof(float32));
+        }
+        m_fill -= consumed;
+        m_index -= consumed;
+    }
+    return written;
+}
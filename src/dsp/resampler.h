@@ -0,0 +1,65 @@
+#pragma once
+
+#include "util.h"
+
+#include <vector>
+
+// taps per output frame, kernel table size and stopband rejection rise together with the cpu cost.
+// draft is fine for monitoring, best for bouncing.
+enum class Resampler_Quality { Draft, Normal, High, Best };
+
+// polyphase windowed-sinc sample rate converter for interleaved frames. the kernel for each output frame
+// is linearly interpolated between the two nearest of a table of precomputed fractional phases, then
+// applied to every channel's planar history with simd dot products. the rate ratio is tracked as an exact
+// fraction, so there is no long-term drift between input and output.
+class Sinc_Resampler final {
+  public:
+    void create(
+        uint32 channels, uint32 in_rate, uint32 out_rate, Resampler_Quality quality, uint32 max_input_frames);
+    void reset();
+
+    // input frames to pass to the next process call so it can write exactly out_frames
+    uint32 input_frames_needed(uint32 out_frames) const;
+
+    // takes all of in and writes as many frames as the buffered input allows, up to max_out_frames.
+    // returns the frames written. in is at most max_input_frames, except that the first call after a
+    // reset may need up to taps() more to fill the kernel.
+    uint32 process(const float32* in, uint32 in_frames, float32* out, uint32 max_out_frames);
+
+    uint32 channels() const {
+        return m_channels;
+    }
+
+    uint32 taps() const {
+        return m_taps;
+    }
+
+    // in input frames
+    uint32 latency() const {
+        return m_taps / 2;
+    }
+
+  private:
+    uint32 m_channels = 0;
+    uint32 m_taps = 0;
+    uint32 m_phases = 0;
+
+    // input frames advanced per output frame, as the reduced fraction m_in_step / m_out_step
+    uint64 m_in_step = 1;
+    uint64 m_out_step = 1;
+    // position of the next output: m_index frames into the history plus m_frac / m_out_step
+    uint32 m_index = 0;
+    uint64 m_frac = 0;
+    // m_frac to a position in the kernel table
+    float64 m_phase_scale = 0.0;
+
+    // m_phases + 1 rows of taps, and the difference from each row to the next
+    std::vector<float32> m_rows;
+    std::vector<float32> m_deltas;
+    std::vector<float32> m_kernel;
+
+    // planar, m_capacity frames per channel, of which m_fill are valid
+    std::vector<float32> m_history;
+    uint32 m_capacity = 0;
+    uint32 m_fill = 0;
+};
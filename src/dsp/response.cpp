@@ -0,0 +1,105 @@
+#include "response.h"
+#include "kernels.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+// the kernel reads the coefficients as an array
+static_assert(sizeof(Biquad_Coeffs) == 5 * sizeof(float32));
+
+void Freq_Response::create(float32 sample_rate, uint32 point_count, float32 min_hz, float32 max_hz) {
+    sb_ASSERT(point_count >= 2 && min_hz > 0.f && min_hz < max_hz);
+    m_point_count = point_count;
+    m_stride = (point_count + SIMD_MAX_WIDTH - 1) / SIMD_MAX_WIDTH * SIMD_MAX_WIDTH;
+
+    // the padding points sit at dc
+    m_freqs.assign(m_stride, 0.f);
+    m_trig.assign(static_cast<size_t>(m_stride) * 4, 0.f);
+
+    const auto top = std::min<float64>(max_hz, sample_rate * 0.5);
+    const auto octaves = std::log2(top / min_hz);
+    for (uint32 i = 0; i < point_count; ++i) {
+        const auto hz = min_hz * std::exp2(octaves * i / (point_count - 1));
+        const auto w = 2.0 * Math_Consts<float64>::pi * hz / sample_rate;
+        m_freqs[i] = static_cast<float32>(hz);
+        // cos w - 1 as -2 sin^2(w / 2), which keeps its precision near dc
+        m_trig[i] = static_cast<float32>(-2.0 * std::sin(0.5 * w) * std::sin(0.5 * w));
+        m_trig[m_stride + i] = static_cast<float32>(std::sin(w));
+        m_trig[m_stride * 2 + i] = static_cast<float32>(-2.0 * std::sin(w) * std::sin(w));
+        m_trig[m_stride * 3 + i] = static_cast<float32>(std::sin(2.0 * w));
+    }
+
+    m_db.assign(m_stride, 0.f);
+    m_phase.assign(m_stride, 0.f);
+    m_delay.assign(m_stride, 0.f);
+    for (auto& stage : m_stages) {
+        stage.dirty.assign(stage.sections.size(), 1);
+        stage.curves.resize(stage.sections.size() * 3 * m_stride);
+    }
+    m_refold = true;
+}
+
+void Freq_Response::set_stage_count(uint32 stage_count) {
+    if (stage_count == m_stages.size())
+        return;
+    m_stages.resize(stage_count);
+    m_refold = true;
+}
+
+void Freq_Response::set_stage(uint32 stage, std::span<const Biquad_Coeffs> sections) {
+    sb_ASSERT(stage < m_stages.size());
+    auto& s = m_stages[stage];
+    if (s.sections.size() != sections.size()) {
+        s.sections.assign(sections.begin(), sections.end());
+        s.dirty.assign(sections.size(), 1);
+        s.curves.resize(sections.size() * 3 * m_stride);
+        m_refold = true;
+        return;
+    }
+    for (size_t i = 0; i < sections.size(); ++i) {
+        if (s.sections[i] != sections[i]) {
+            s.sections[i] = sections[i];
+            s.dirty[i] = 1;
+        }
+    }
+}
+
+bool Freq_Response::update() {
+    const auto& kernels = dsp_kernels();
+    const auto stride = static_cast<size_t>(m_stride);
+
+    m_evaluated = 0;
+    for (auto& s : m_stages) {
+        for (size_t i = 0; i < s.sections.size(); ++i) {
+            if (!s.dirty[i])
+                continue;
+            auto* c = s.curves.data() + i * 3 * stride;
+            kernels.biquad_response(
+                &s.sections[i].b0, m_trig.data(), c, c + stride, c + stride * 2, m_stride);
+            s.dirty[i] = 0;
+            ++m_evaluated;
+        }
+    }
+    if (m_evaluated == 0 && !m_refold)
+        return false;
+    m_refold = false;
+
+    // a section in series adds its db, phase and delay; summing them again is far cheaper than evaluating
+    std::fill(m_db.begin(), m_db.end(), 0.f);
+    std::fill(m_phase.begin(), m_phase.end(), 0.f);
+    std::fill(m_delay.begin(), m_delay.end(), 0.f);
+    for (const auto& s : m_stages) {
+        for (size_t i = 0; i < s.sections.size(); ++i) {
+            const auto* c = s.curves.data() + i * 3 * stride;
+            kernels.madd(c, 1.f, m_db.data(), m_db.data(), m_stride);
+            kernels.madd(c + stride, 1.f, m_phase.data(), m_phase.data(), m_stride);
+            kernels.madd(c + stride * 2, 1.f, m_delay.data(), m_delay.data(), m_stride);
+        }
+    }
+
+    constexpr auto two_pi = 2.f * Math_Consts<float32>::pi;
+    for (auto& p : m_phase)
+        p -= two_pi * std::round(p / two_pi);
+    return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "biquad.h"
+
+#include <span>
+#include <vector>
+
+// magnitude, phase and group delay of a chain of biquad stages at log spaced frequencies, for drawing
+// filter curves. a stage is usually one node's sections. every section keeps its own curves, so update()
+// only evaluates the sections whose coefficients changed since the last one and then sums; dragging one
+// band of a 20 band eq costs one section, not twenty.
+class Freq_Response final {
+  public:
+    void create(float32 sample_rate, uint32 point_count, float32 min_hz = 20.f, float32 max_hz = 20000.f);
+
+    // the chain is stages 0 .. stage_count - 1 in series, new stages start empty
+    void set_stage_count(uint32 stage_count);
+    // cheap when nothing changed; sections equal to what the stage already had keep their curves
+    void set_stage(uint32 stage, std::span<const Biquad_Coeffs> sections);
+
+    // evaluates what set_stage changed and refolds the totals. returns false if nothing did.
+    bool update();
+
+    std::span<const float32> freqs() const {
+        return {m_freqs.data(), m_point_count};
+    }
+    std::span<const float32> magnitude_db() const {
+        return {m_db.data(), m_point_count};
+    }
+    // radians, wrapped to [-pi, pi]
+    std::span<const float32> phase() const {
+        return {m_phase.data(), m_point_count};
+    }
+    // samples
+    std::span<const float32> group_delay() const {
+        return {m_delay.data(), m_point_count};
+    }
+
+    // sections the last update() evaluated
+    uint32 evaluated() const {
+        return m_evaluated;
+    }
+
+  private:
+    struct Stage final {
+        std::vector<Biquad_Coeffs> sections;
+        std::vector<uint8> dirty;
+        // db, phase and delay rows of m_stride per section
+        std::vector<float32> curves;
+    };
+
+    uint32 m_point_count = 0;
+    // the point count rounded up for the kernel
+    uint32 m_stride = 0;
+    std::vector<float32> m_freqs;
+    // cos w - 1, sin w, cos 2w - 1 and sin 2w rows
+    std::vector<float32> m_trig;
+    std::vector<Stage> m_stages;
+    bool m_refold = false;
+    uint32 m_evaluated = 0;
+
+    std::vector<float32> m_db;
+    std::vector<float32> m_phase;
+    std::vector<float32> m_delay;
+};
@@ -0,0 +1,194 @@
+#include "rt_alloc.h"
+
+#if defined(SB_RT_ALLOC_CHECK)
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#include <windows.h>
+#else
+#include <execinfo.h>
+#include <unistd.h>
+#endif
+
+// only the first few get a backtrace, after that they're just counted
+static constexpr uint64 RT_ALLOC_MAX_REPORTS = 16;
+
+static std::atomic<uint64> g_violations = 0;
+static thread_local uint32 t_rt_depth = 0;
+static thread_local bool t_reporting = false;
+
+Rt_Alloc_Scope::Rt_Alloc_Scope() {
+    ++t_rt_depth;
+}
+
+Rt_Alloc_Scope::~Rt_Alloc_Scope() {
+    --t_rt_depth;
+}
+
+uint64 rt_alloc_violations() {
+    return g_violations.load(std::memory_order_relaxed);
+}
+
+static void rt_alloc_report(const char* what, size_t size) {
+    // printing may allocate itself
+    if (t_rt_depth == 0 || t_reporting)
+        return;
+    t_reporting = true;
+
+    const auto count = g_violations.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (count <= RT_ALLOC_MAX_REPORTS) {
+        std::fprintf(stderr, "[rt alloc] %s of %zu bytes on a real-time thread (#%llu)\n", what, size,
+                     static_cast<unsigned long long>(count));
+        void* frames[32];
+#if defined(_WIN32)
+        const auto depth = CaptureStackBackTrace(1, 32, frames, nullptr);
+        for (USHORT i = 0; i < depth; ++i)
+            std::fprintf(stderr, "  #%u %p\n", static_cast<unsigned>(i), frames[i]);
+#else
+        // backtrace_symbols_fd writes straight to the fd without calling malloc
+        const auto depth = backtrace(frames, 32);
+        std::fflush(stderr);
+        backtrace_symbols_fd(frames + 1, depth - 1, STDERR_FILENO);
+#endif
+        if (count == RT_ALLOC_MAX_REPORTS)
+            std::fprintf(stderr, "[rt alloc] further violations are only counted\n");
+    }
+
+    t_reporting = false;
+}
+
+static void* rt_malloc(size_t size, size_t align) {
+    size = size ? size : 1;
+    if (align <= alignof(std::max_align_t))
+        return std::malloc(size);
+#if defined(_WIN32)
+    return _aligned_malloc(size, align);
+#else
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+}
+
+static void rt_free(void* p, size_t align) {
+#if defined(_WIN32)
+    if (align > alignof(std::max_align_t)) {
+        _aligned_free(p);
+        return;
+    }
+#endif
+    (void)align;
+    std::free(p);
+}
+
+static void* rt_new(size_t size, size_t align) {
+    rt_alloc_report("new", size);
+    if (auto* p = rt_malloc(size, align))
+        return p;
+    throw std::bad_alloc{};
+}
+
+static void* rt_new_nothrow(size_t size, size_t align) noexcept {
+    rt_alloc_report("new", size);
+    return rt_malloc(size, align);
+}
+
+static void rt_delete(void* p, size_t size, size_t align) noexcept {
+    if (!p)
+        return;
+    rt_alloc_report("delete", size);
+    rt_free(p, align);
+}
+
+static constexpr size_t DEFAULT_ALIGN = alignof(std::max_align_t);
+
+void* operator new(size_t size) {
+    return rt_new(size, DEFAULT_ALIGN);
+}
+
+void* operator new[](size_t size) {
+    return rt_new(size, DEFAULT_ALIGN);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return rt_new_nothrow(size, DEFAULT_ALIGN);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return rt_new_nothrow(size, DEFAULT_ALIGN);
+}
+
+void* operator new(size_t size, std::align_val_t align) {
+    return rt_new(size, static_cast<size_t>(align));
+}
+
+void* operator new[](size_t size, std::align_val_t align) {
+    return rt_new(size, static_cast<size_t>(align));
+}
+
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return rt_new_nothrow(size, static_cast<size_t>(align));
+}
+
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return rt_new_nothrow(size, static_cast<size_t>(align));
+}
+
+void operator delete(void* p) noexcept {
+    rt_delete(p, 0, DEFAULT_ALIGN);
+}
+
+void operator delete[](void* p) noexcept {
+    rt_delete(p, 0, DEFAULT_ALIGN);
+}
+
+void operator delete(void* p, size_t size) noexcept {
+    rt_delete(p, size, DEFAULT_ALIGN);
+}
+
+void operator delete[](void* p, size_t size) noexcept {
+    rt_delete(p, size, DEFAULT_ALIGN);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    rt_delete(p, 0, DEFAULT_ALIGN);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    rt_delete(p, 0, DEFAULT_ALIGN);
+}
+
+void operator delete(void* p, std::align_val_t align) noexcept {
+    rt_delete(p, 0, static_cast<size_t>(align));
+}
+
+void operator delete[](void* p, std::align_val_t align) noexcept {
+    rt_delete(p, 0, static_cast<size_t>(align));
+}
+
+void operator delete(void* p, size_t size, std::align_val_t align) noexcept {
+    rt_delete(p, size, static_cast<size_t>(align));
+}
+
+void operator delete[](void* p, size_t size, std::align_val_t align) noexcept {
+    rt_delete(p, size, static_cast<size_t>(align));
+}
+
+void operator delete(void* p, std::align_val_t align, const std::nothrow_t&) noexcept {
+    rt_delete(p, 0, static_cast<size_t>(align));
+}
+
+void operator delete[](void* p, std::align_val_t align, const std::nothrow_t&) noexcept {
+    rt_delete(p, 0, static_cast<size_t>(align));
+}
+
+#else
+
+uint64 rt_alloc_violations() {
+    return 0;
+}
+
+#endif
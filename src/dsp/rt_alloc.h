@@ -0,0 +1,24 @@
+#pragma once
+
+#include "util.h"
+
+// marks the current thread as a real-time thread while alive; scopes nest.
+// built with SB_RT_ALLOC_CHECK, the global operator new and delete report every call made inside a scope to
+// stderr with a backtrace, so a stray std::vector growth or std::function copy on the audio path shows up
+// the first time it runs. without it a scope costs nothing.
+class Rt_Alloc_Scope final {
+  public:
+#if defined(SB_RT_ALLOC_CHECK)
+    Rt_Alloc_Scope();
+    ~Rt_Alloc_Scope();
+#else
+    Rt_Alloc_Scope() {
+    }
+#endif
+
+    Rt_Alloc_Scope(const Rt_Alloc_Scope&) = delete;
+    Rt_Alloc_Scope& operator=(const Rt_Alloc_Scope&) = delete;
+};
+
+// allocations and frees seen inside scopes so far, always 0 without SB_RT_ALLOC_CHECK
+uint64 rt_alloc_violations();
@@ -0,0 +1,252 @@
+#include "sample_stream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static uint64 stream_request(uint32 generation, uint32 sample) {
+    return static_cast<uint64>(generation) << 32 | sample;
+}
+
+Sample_Streamer::~Sample_Streamer() {
+    destroy();
+}
+
+void Sample_Streamer::create(std::span<const Stream_Sample> samples, uint32 head_frames, bool synchronous) {
+    destroy();
+
+    size_t head_samples = 0;
+    m_samples.reserve(samples.size());
+    for (const auto& source : samples) {
+        const auto channels = std::min(source.channels, MAX_CHANNELS);
+        const auto head = std::min<uint64>(source.frames, head_frames);
+        m_samples.push_back({source, channels, head, head_samples});
+        head_samples += static_cast<size_t>(head) * channels;
+    }
+
+    // this is where the heads are read from disk, once
+    m_heads.resize(head_samples);
+    for (const auto& sample : m_samples) {
+        for (uint32 c = 0; c < sample.channels; ++c) {
+            std::memcpy(
+                m_heads.data() + sample.head_offset + c * sample.head_frames,
+                sample.source.data + c * sample.source.frames, sample.head_frames * sizeof(float32));
+        }
+    }
+
+    m_streams = std::make_unique<Stream[]>(STREAMS);
+    m_age = 0;
+    m_io_block.resize(static_cast<size_t>(IO_FRAMES) * MAX_CHANNELS);
+    m_synchronous = synchronous;
+    if (synchronous)
+        return;
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread{[this] { run(); }};
+}
+
+void Sample_Streamer::destroy() {
+    if (!m_streams)
+        return;
+
+    m_running.store(false, std::memory_order_release);
+    if (m_thread.joinable())
+        m_thread.join();
+    while (m_prefetch.front())
+        m_prefetch.pop();
+
+    m_streams.reset();
+    m_samples.clear();
+    m_heads.clear();
+}
+
+void Sample_Streamer::note_on(uint32 key, uint32 sample, float32 velocity) {
+    // an empty slot has nothing to play and no channels to stream
+    if (!m_streams || sample >= m_samples.size() || m_samples[sample].source.frames == 0)
+        return;
+
+    // the key's own stream, else an idle one, else the oldest
+    Stream* stream = nullptr;
+    for (uint32 s = 0; s < STREAMS && !stream; ++s) {
+        if (m_streams[s].sample != NO_SAMPLE && m_streams[s].key == key)
+            stream = &m_streams[s];
+    }
+    for (uint32 s = 0; s < STREAMS && !stream; ++s) {
+        if (m_streams[s].sample == NO_SAMPLE)
+            stream = &m_streams[s];
+    }
+    if (!stream) {
+        stream = &m_streams[0];
+        for (uint32 s = 1; s < STREAMS; ++s) {
+            if (m_streams[s].age < stream->age)
+                stream = &m_streams[s];
+        }
+    }
+
+    stream->generation++;
+    stream->key = key;
+    stream->sample = sample;
+    stream->ring_ready = false;
+    stream->frame = 0;
+    stream->age = ++m_age;
+    stream->gain = velocity;
+    stream->level = 1.f;
+    stream->level_step = 0.f;
+    stream->request.store(stream_request(stream->generation, sample), std::memory_order_release);
+}
+
+void Sample_Streamer::note_off(uint32 key) {
+    if (!m_streams)
+        return;
+    for (uint32 s = 0; s < STREAMS; ++s) {
+        auto& stream = m_streams[s];
+        if (stream.sample != NO_SAMPLE && stream.key == key && stream.level_step == 0.f)
+            stream.level_step = 1.f / RELEASE_FRAMES;
+    }
+}
+
+void Sample_Streamer::prefetch(uint32 sample) {
+    // a synchronous render reads as it goes, and nothing would drain the queue
+    if (m_streams && !m_synchronous && sample < m_samples.size())
+        m_prefetch.try_push(sample);
+}
+
+void Sample_Streamer::render(const Dsp_Buffer& out, uint32 offset, uint32 frames) {
+    if (!m_streams)
+        return;
+
+    // frames from the ring are copied out a block at a time, interleaved as the io thread wrote them
+    static constexpr uint32 BLOCK = 256;
+    float32 block[BLOCK * MAX_CHANNELS];
+
+    for (uint32 s = 0; s < STREAMS; ++s) {
+        auto& stream = m_streams[s];
+        if (stream.sample == NO_SAMPLE)
+            continue;
+        // the io thread's half of the restart handshake
+        if (m_synchronous && !stream.ring_ready)
+            fill(stream);
+        if (!stream.ring_ready && stream.flushed.load(std::memory_order_acquire) == stream.generation) {
+            stream.ring.consumerClear();
+            stream.cleared.store(stream.generation, std::memory_order_release);
+            stream.ring_ready = true;
+        }
+
+        const auto& sample = m_samples[stream.sample];
+        const auto channels = sample.channels;
+        for (uint32 i = 0; i < frames && stream.sample != NO_SAMPLE;) {
+            if (stream.frame == sample.source.frames) {
+                stop(stream);
+                break;
+            }
+
+            const float32* src = nullptr;
+            size_t channel_stride = 0;
+            uint32 frame_stride = 0;
+            uint32 n = 0;
+            if (stream.frame < sample.head_frames) {
+                n = static_cast<uint32>(std::min<uint64>(frames - i, sample.head_frames - stream.frame));
+                src = m_heads.data() + sample.head_offset + stream.frame;
+                channel_stride = sample.head_frames;
+                frame_stride = 1;
+            } else {
+                // topped up right before it's read, up to a full ring
+                while (m_synchronous && fill(stream)) {
+                }
+                const auto available = stream.ring_ready ? stream.ring.readAvailable() / channels : 0;
+                const auto wanted = std::min<uint64>(
+                    std::min(frames - i, BLOCK), sample.source.frames - stream.frame);
+                n = static_cast<uint32>(std::min<uint64>(wanted, available));
+                if (n == 0) {
+                    m_underruns.store(underruns() + (frames - i), std::memory_order_relaxed);
+                    break;
+                }
+                stream.ring.readBuff(block, static_cast<size_t>(n) * channels);
+                src = block;
+                channel_stride = 1;
+                frame_stride = channels;
+            }
+
+            for (uint32 j = 0; j < n; ++j) {
+                const auto gain = stream.gain * stream.level;
+                for (uint32 c = 0; c < out.channels; ++c) {
+                    const auto from = std::min(c, channels - 1);
+                    out.channel(c)[offset + i + j] += gain * src[from * channel_stride + j * frame_stride];
+                }
+                stream.level = std::max(stream.level - stream.level_step, 0.f);
+            }
+            stream.frame += n;
+            i += n;
+
+            if (stream.level == 0.f)
+                stop(stream);
+        }
+    }
+}
+
+void Sample_Streamer::stop(Stream& stream) {
+    stream.generation++;
+    stream.sample = NO_SAMPLE;
+    stream.request.store(stream_request(stream.generation, NO_SAMPLE), std::memory_order_release);
+}
+
+void Sample_Streamer::run() {
+    while (m_running.load(std::memory_order_acquire)) {
+        bool busy = false;
+        while (const auto* sample = m_prefetch.front()) {
+            touch(*sample);
+            m_prefetch.pop();
+        }
+        for (uint32 s = 0; s < STREAMS; ++s)
+            busy |= fill(m_streams[s]);
+        // a ring lasts hundreds of milliseconds, so a millisecond's nap can't starve one
+        if (!busy)
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+}
+
+bool Sample_Streamer::fill(Stream& stream) {
+    const auto request = stream.request.load(std::memory_order_acquire);
+    const auto generation = static_cast<uint32>(request >> 32);
+    if (generation != stream.io_generation) {
+        // nothing older is written from here on
+        stream.io_generation = generation;
+        stream.io_sample = static_cast<uint32>(request);
+        if (stream.io_sample != NO_SAMPLE)
+            stream.io_frame = m_samples[stream.io_sample].head_frames;
+        stream.flushed.store(generation, std::memory_order_release);
+    }
+    if (stream.io_sample == NO_SAMPLE || stream.cleared.load(std::memory_order_acquire) != generation)
+        return false;
+
+    const auto& sample = m_samples[stream.io_sample];
+    const auto channels = sample.channels;
+    const auto space = stream.ring.writeAvailable() / channels;
+    const auto n = static_cast<uint32>(
+        std::min<uint64>(std::min<uint64>(space, IO_FRAMES), sample.source.frames - stream.io_frame));
+    if (n == 0)
+        return false;
+
+    // planar on disk, interleaved in the ring; reading the mapping here is what pages it in
+    for (uint32 c = 0; c < channels; ++c) {
+        const auto* src = sample.source.data + c * sample.source.frames + stream.io_frame;
+        for (uint32 i = 0; i < n; ++i)
+            m_io_block[static_cast<size_t>(i) * channels + c] = src[i];
+    }
+    stream.ring.writeBuff(m_io_block.data(), static_cast<size_t>(n) * channels);
+    stream.io_frame += n;
+    return true;
+}
+
+void Sample_Streamer::touch(uint32 sample) {
+    const auto& s = m_samples[sample];
+    const auto end = std::min<uint64>(s.source.frames, s.head_frames + PREFETCH_FRAMES);
+    // one read a page
+    static constexpr uint64 PAGE_FLOATS = 4096 / sizeof(float32);
+    float32 sum = 0.f;
+    for (uint32 c = 0; c < s.channels; ++c) {
+        const auto* data = s.source.data + c * s.source.frames;
+        for (auto i = s.head_frames; i < end; i += PAGE_FLOATS)
+            sum += static_cast<const volatile float32*>(data)[i];
+    }
+    [[maybe_unused]] volatile float32 sink = sum;
+}
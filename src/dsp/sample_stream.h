@@ -0,0 +1,131 @@
+#pragma once
+
+#include "graph.h"
+
+#include <ringbuffer.hpp>
+#include <rigtorp/SPSCQueue.h>
+
+#include <atomic>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+// one sample's audio, planar, channel c from data + c * frames. data is usually a mapped project file; only
+// the streamer's io thread reads it past the head.
+struct Stream_Sample final {
+    const float32* data = nullptr;
+    uint32 channels = 0;
+    uint64 frames = 0;
+};
+
+// plays samples too big to keep in memory. the first head_frames of every sample are copied in at create
+// and a note starts from those; the rest comes off disk on an io thread, into a ring per stream, while the
+// head plays. the audio thread only ever reads the heads and the rings: a ring that runs dry plays silence
+// and is counted in underruns(), and the sample carries on from where it stopped once data arrives.
+//
+// restarting a stream is a handshake, so the io thread never has to wait and the audio thread never sees
+// the old sample's frames: the audio thread bumps the stream's generation, the io thread stops writing the
+// old sample and says so, the audio thread empties the ring and says so, and only then does filling start.
+// samples play frame for frame at the engine rate.
+//
+// a synchronous streamer has no io thread: render fills the rings itself, so an offline render running
+// faster than realtime never finds one dry and comes out the same every time.
+class Sample_Streamer final {
+  public:
+    // voices sounding at once, each with a ring
+    static constexpr uint32 STREAMS = 32;
+    static constexpr uint32 MAX_CHANNELS = 2;
+    // interleaved samples per ring, about 340 ms of stereo at 48 kHz
+    static constexpr size_t RING_SIZE = 1 << 15;
+    // the most the io thread moves into one ring before looking at the others
+    static constexpr uint32 IO_FRAMES = 2048;
+    // the fade after a note-off, and the pages touched past the head by prefetch
+    static constexpr uint32 RELEASE_FRAMES = 256;
+    static constexpr uint32 PREFETCH_FRAMES = RING_SIZE / MAX_CHANNELS;
+
+    Sample_Streamer() = default;
+    ~Sample_Streamer();
+
+    Sample_Streamer(const Sample_Streamer&) = delete;
+    Sample_Streamer& operator=(const Sample_Streamer&) = delete;
+
+    // ui thread, with nothing rendering. samples of more than MAX_CHANNELS play their first channels; the
+    // data has to stay valid until destroy.
+    void create(std::span<const Stream_Sample> samples, uint32 head_frames, bool synchronous = false);
+    void destroy();
+
+    uint32 sample_count() const {
+        return static_cast<uint32>(m_samples.size());
+    }
+
+    // any thread
+    uint64 underruns() const {
+        return m_underruns.load(std::memory_order_relaxed);
+    }
+
+    // audio thread. a note-on for a key that's playing restarts its stream, otherwise it takes an idle one or
+    // the oldest.
+    void note_on(uint32 key, uint32 sample, float32 velocity);
+    void note_off(uint32 key);
+    // asks the io thread to read the start of the sample's streamed part into the os cache, for a note that's
+    // coming up. dropped if the io thread is behind.
+    void prefetch(uint32 sample);
+    // adds the streams into every channel of out, frames frames from offset
+    void render(const Dsp_Buffer& out, uint32 offset, uint32 frames);
+
+  private:
+    static constexpr uint32 NO_SAMPLE = ~0u;
+
+    struct Sample final {
+        Stream_Sample source;
+        uint32 channels;
+        uint64 head_frames;
+        // in m_heads, planar with a stride of head_frames
+        size_t head_offset;
+    };
+
+    struct Stream final {
+        // audio to io: generation << 32 | sample, NO_SAMPLE when stopped
+        std::atomic<uint64> request = NO_SAMPLE;
+        // io to audio: the generation it stopped writing older frames for
+        std::atomic<uint32> flushed = 0;
+        // audio to io: the generation whose ring has been emptied, so filling can start
+        std::atomic<uint32> cleared = 0;
+        jnk0le::Ringbuffer<float32, RING_SIZE> ring;
+
+        // audio thread
+        uint32 generation = 0;
+        uint32 key = 0;
+        uint32 sample = NO_SAMPLE;
+        bool ring_ready = false;
+        uint64 frame = 0;
+        uint64 age = 0;
+        float32 gain = 0.f;
+        float32 level = 0.f;
+        float32 level_step = 0.f;
+
+        // io thread
+        alignas(64) uint32 io_generation = 0;
+        uint32 io_sample = NO_SAMPLE;
+        uint64 io_frame = 0;
+    };
+
+    void run();
+    // io thread, or the rendering thread when synchronous. true if it moved anything
+    bool fill(Stream& stream);
+    void touch(uint32 sample);
+    void stop(Stream& stream);
+
+    std::vector<Sample> m_samples;
+    std::vector<float32> m_heads;
+    std::unique_ptr<Stream[]> m_streams;
+    uint64 m_age = 0;
+    std::atomic<uint64> m_underruns = 0;
+
+    rigtorp::SPSCQueue<uint32> m_prefetch{64};
+    std::vector<float32> m_io_block;
+    std::thread m_thread;
+    std::atomic<bool> m_running = false;
+    bool m_synchronous = false;
+};
@@ -0,0 +1,486 @@
+#pragma once
+
+#include "util.h"
+
+// sse everywhere; on arm the same intrinsics are translated to neon by sse2neon
+#if defined(__aarch64__) || defined(_M_ARM64) || defined(__arm__) || defined(_M_ARM)
+#define SB_SIMD_NEON
+#include <sse2neon.h>
+#else
+#include <immintrin.h>
+#endif
+
+// widest register any build of the kernels uses; buffers the kernels load whole registers from are padded
+// to a multiple of it
+inline constexpr uint32 SIMD_MAX_WIDTH = 16;
+
+// kernels.cpp is compiled once per instruction set. the inline namespace gives each build its own copy of
+// these inline functions, so the linker can't fold an avx copy into code that has to run on plain sse2.
+#if defined(__AVX512F__)
+#define SB_SIMD_NAMESPACE simd_avx512
+#elif defined(__AVX2__)
+#define SB_SIMD_NAMESPACE simd_avx2
+#elif defined(__AVX__)
+#define SB_SIMD_NAMESPACE simd_avx
+#elif defined(SB_SIMD_NEON)
+#define SB_SIMD_NAMESPACE simd_neon
+#else
+#define SB_SIMD_NAMESPACE simd_sse2
+#endif
+
+inline namespace SB_SIMD_NAMESPACE {
+
+struct Simd_F32x4 final {
+    using Reg = __m128;
+    static constexpr uint32 WIDTH = 4;
+
+    static Reg zero() {
+        return _mm_setzero_ps();
+    }
+
+    static Reg set1(float32 x) {
+        return _mm_set1_ps(x);
+    }
+
+    static Reg load(const float32* p) {
+        return _mm_load_ps(p);
+    }
+
+    static Reg loadu(const float32* p) {
+        return _mm_loadu_ps(p);
+    }
+
+    static void store(float32* p, Reg v) {
+        _mm_store_ps(p, v);
+    }
+
+    static void storeu(float32* p, Reg v) {
+        _mm_storeu_ps(p, v);
+    }
+
+    static Reg add(Reg a, Reg b) {
+        return _mm_add_ps(a, b);
+    }
+
+    static Reg sub(Reg a, Reg b) {
+        return _mm_sub_ps(a, b);
+    }
+
+    static Reg mul(Reg a, Reg b) {
+        return _mm_mul_ps(a, b);
+    }
+
+    // a * b + c
+    static Reg madd(Reg a, Reg b, Reg c) {
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
+    }
+
+    static Reg div(Reg a, Reg b) {
+        return _mm_div_ps(a, b);
+    }
+
+    static Reg min(Reg a, Reg b) {
+        return _mm_min_ps(a, b);
+    }
+
+    static Reg max(Reg a, Reg b) {
+        return _mm_max_ps(a, b);
+    }
+
+    static Reg abs(Reg a) {
+        return _mm_andnot_ps(_mm_set1_ps(-0.f), a);
+    }
+
+    // the magnitude of m with the sign of s
+    static Reg copysign(Reg m, Reg s) {
+        const auto sign = _mm_set1_ps(-0.f);
+        return _mm_or_ps(_mm_andnot_ps(sign, m), _mm_and_ps(sign, s));
+    }
+
+    // to the nearest integer, ties to even; |a| below 2^31
+    static Reg round(Reg a) {
+        return _mm_cvtepi32_ps(_mm_cvtps_epi32(a));
+    }
+
+    // towards zero, so the floor of non-negative a; |a| below 2^31
+    static Reg trunc(Reg a) {
+        return _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+    }
+
+    // base[index] per lane, index holding whole numbers below 2^24. sse has no gather, so lane by lane.
+    static Reg gather(const float32* base, Reg index) {
+        alignas(16) int32 i[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(i), _mm_cvttps_epi32(index));
+        return _mm_setr_ps(base[i[0]], base[i[1]], base[i[2]], base[i[3]]);
+    }
+
+    // a < b ? x : y
+    static Reg select_lt(Reg a, Reg b, Reg x, Reg y) {
+        const auto m = _mm_cmplt_ps(a, b);
+        return _mm_or_ps(_mm_and_ps(m, x), _mm_andnot_ps(m, y));
+    }
+
+    // 2^n for integral n in [-126, 127]
+    static Reg exp2i(Reg n) {
+        const auto e = _mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127));
+        return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+    }
+
+    // positive normal a as m * 2^e with m in [0.5, 1); returns m
+    static Reg frexp(Reg a, Reg& e) {
+        const auto bits = _mm_castps_si128(a);
+        e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126)));
+        const auto m = _mm_and_si128(bits, _mm_set1_epi32(0x007fffff));
+        return _mm_castsi128_ps(_mm_or_si128(m, _mm_set1_epi32(0x3f000000)));
+    }
+};
+
+// the double precision counterparts only carry what the float64 kernels use
+struct Simd_F64x2 final {
+    using Reg = __m128d;
+    static constexpr uint32 WIDTH = 2;
+
+    static Reg zero() {
+        return _mm_setzero_pd();
+    }
+
+    static Reg set1(float64 x) {
+        return _mm_set1_pd(x);
+    }
+
+    static Reg loadu(const float64* p) {
+        return _mm_loadu_pd(p);
+    }
+
+    static void storeu(float64* p, Reg v) {
+        _mm_storeu_pd(p, v);
+    }
+
+    static Reg add(Reg a, Reg b) {
+        return _mm_add_pd(a, b);
+    }
+
+    static Reg sub(Reg a, Reg b) {
+        return _mm_sub_pd(a, b);
+    }
+
+    static Reg mul(Reg a, Reg b) {
+        return _mm_mul_pd(a, b);
+    }
+
+    static Reg madd(Reg a, Reg b, Reg c) {
+        return _mm_add_pd(_mm_mul_pd(a, b), c);
+    }
+};
+
+#if defined(__AVX__)
+#define SB_SIMD_AVX
+
+struct Simd_F32x8 final {
+    using Reg = __m256;
+    static constexpr uint32 WIDTH = 8;
+
+    static Reg zero() {
+        return _mm256_setzero_ps();
+    }
+
+    static Reg set1(float32 x) {
+        return _mm256_set1_ps(x);
+    }
+
+    static Reg load(const float32* p) {
+        return _mm256_load_ps(p);
+    }
+
+    static Reg loadu(const float32* p) {
+        return _mm256_loadu_ps(p);
+    }
+
+    static void store(float32* p, Reg v) {
+        _mm256_store_ps(p, v);
+    }
+
+    static void storeu(float32* p, Reg v) {
+        _mm256_storeu_ps(p, v);
+    }
+
+    static Reg add(Reg a, Reg b) {
+        return _mm256_add_ps(a, b);
+    }
+
+    static Reg sub(Reg a, Reg b) {
+        return _mm256_sub_ps(a, b);
+    }
+
+    static Reg mul(Reg a, Reg b) {
+        return _mm256_mul_ps(a, b);
+    }
+
+    static Reg madd(Reg a, Reg b, Reg c) {
+#if defined(__FMA__) || defined(__AVX2__)
+        return _mm256_fmadd_ps(a, b, c);
+#else
+        return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+    }
+
+    static Reg div(Reg a, Reg b) {
+        return _mm256_div_ps(a, b);
+    }
+
+    static Reg min(Reg a, Reg b) {
+        return _mm256_min_ps(a, b);
+    }
+
+    static Reg max(Reg a, Reg b) {
+        return _mm256_max_ps(a, b);
+    }
+
+    static Reg abs(Reg a) {
+        return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a);
+    }
+
+    static Reg copysign(Reg m, Reg s) {
+        const auto sign = _mm256_set1_ps(-0.f);
+        return _mm256_or_ps(_mm256_andnot_ps(sign, m), _mm256_and_ps(sign, s));
+    }
+
+    static Reg round(Reg a) {
+        return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    }
+
+    static Reg trunc(Reg a) {
+        return _mm256_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    }
+
+    static Reg gather(const float32* base, Reg index) {
+#if defined(__AVX2__)
+        return _mm256_i32gather_ps(base, _mm256_cvttps_epi32(index), 4);
+#else
+        const auto lo = Simd_F32x4::gather(base, _mm256_castps256_ps128(index));
+        const auto hi = Simd_F32x4::gather(base, _mm256_extractf128_ps(index, 1));
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+#endif
+    }
+
+    static Reg select_lt(Reg a, Reg b, Reg x, Reg y) {
+        return _mm256_blendv_ps(y, x, _mm256_cmp_ps(a, b, _CMP_LT_OQ));
+    }
+
+    // plain avx has no 256-bit integer ops, so without avx2 these go through two sse halves
+    static Reg exp2i(Reg n) {
+#if defined(__AVX2__)
+        const auto e = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+#else
+        const auto lo = Simd_F32x4::exp2i(_mm256_castps256_ps128(n));
+        const auto hi = Simd_F32x4::exp2i(_mm256_extractf128_ps(n, 1));
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+#endif
+    }
+
+    static Reg frexp(Reg a, Reg& e) {
+#if defined(__AVX2__)
+        const auto bits = _mm256_castps_si256(a);
+        e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+        const auto m = _mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff));
+        return _mm256_castsi256_ps(_mm256_or_si256(m, _mm256_set1_epi32(0x3f000000)));
+#else
+        __m128 e_lo, e_hi;
+        const auto lo = Simd_F32x4::frexp(_mm256_castps256_ps128(a), e_lo);
+        const auto hi = Simd_F32x4::frexp(_mm256_extractf128_ps(a, 1), e_hi);
+        e = _mm256_insertf128_ps(_mm256_castps128_ps256(e_lo), e_hi, 1);
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+#endif
+    }
+};
+
+struct Simd_F64x4 final {
+    using Reg = __m256d;
+    static constexpr uint32 WIDTH = 4;
+
+    static Reg zero() {
+        return _mm256_setzero_pd();
+    }
+
+    static Reg set1(float64 x) {
+        return _mm256_set1_pd(x);
+    }
+
+    static Reg loadu(const float64* p) {
+        return _mm256_loadu_pd(p);
+    }
+
+    static void storeu(float64* p, Reg v) {
+        _mm256_storeu_pd(p, v);
+    }
+
+    static Reg add(Reg a, Reg b) {
+        return _mm256_add_pd(a, b);
+    }
+
+    static Reg sub(Reg a, Reg b) {
+        return _mm256_sub_pd(a, b);
+    }
+
+    static Reg mul(Reg a, Reg b) {
+        return _mm256_mul_pd(a, b);
+    }
+
+    static Reg madd(Reg a, Reg b, Reg c) {
+#if defined(__FMA__) || defined(__AVX2__)
+        return _mm256_fmadd_pd(a, b, c);
+#else
+        return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+#endif
+    }
+};
+#endif
+
+#if defined(__AVX512F__)
+#define SB_SIMD_AVX512
+
+struct Simd_F32x16 final {
+    using Reg = __m512;
+    static constexpr uint32 WIDTH = 16;
+
+    static Reg zero() {
+        return _mm512_setzero_ps();
+    }
+
+    static Reg set1(float32 x) {
+        return _mm512_set1_ps(x);
+    }
+
+    static Reg load(const float32* p) {
+        return _mm512_load_ps(p);
+    }
+
+    static Reg loadu(const float32* p) {
+        return _mm512_loadu_ps(p);
+    }
+
+    static void store(float32* p, Reg v) {
+        _mm512_store_ps(p, v);
+    }
+
+    static void storeu(float32* p, Reg v) {
+        _mm512_storeu_ps(p, v);
+    }
+
+    static Reg add(Reg a, Reg b) {
+        return _mm512_add_ps(a, b);
+    }
+
+    static Reg sub(Reg a, Reg b) {
+        return _mm512_sub_ps(a, b);
+    }
+
+    static Reg mul(Reg a, Reg b) {
+        return _mm512_mul_ps(a, b);
+    }
+
+    static Reg madd(Reg a, Reg b, Reg c) {
+        return _mm512_fmadd_ps(a, b, c);
+    }
+
+    static Reg div(Reg a, Reg b) {
+        return _mm512_div_ps(a, b);
+    }
+
+    static Reg min(Reg a, Reg b) {
+        return _mm512_min_ps(a, b);
+    }
+
+    static Reg max(Reg a, Reg b) {
+        return _mm512_max_ps(a, b);
+    }
+
+    static Reg abs(Reg a) {
+        return _mm512_abs_ps(a);
+    }
+
+    // the float bitwise ops need avx-512dq, the integer ones only the foundation
+    static Reg copysign(Reg m, Reg s) {
+        const auto sign = _mm512_set1_epi32(static_cast<int>(0x80000000u));
+        const auto mag = _mm512_andnot_si512(sign, _mm512_castps_si512(m));
+        return _mm512_castsi512_ps(_mm512_or_si512(mag, _mm512_and_si512(sign, _mm512_castps_si512(s))));
+    }
+
+    static Reg round(Reg a) {
+        return _mm512_cvtepi32_ps(_mm512_cvtps_epi32(a));
+    }
+
+    static Reg trunc(Reg a) {
+        return _mm512_cvtepi32_ps(_mm512_cvttps_epi32(a));
+    }
+
+    static Reg gather(const float32* base, Reg index) {
+        return _mm512_i32gather_ps(_mm512_cvttps_epi32(index), base, 4);
+    }
+
+    static Reg select_lt(Reg a, Reg b, Reg x, Reg y) {
+        return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(a, b, _CMP_LT_OQ), y, x);
+    }
+
+    static Reg exp2i(Reg n) {
+        const auto e = _mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127));
+        return _mm512_castsi512_ps(_mm512_slli_epi32(e, 23));
+    }
+
+    static Reg frexp(Reg a, Reg& e) {
+        const auto bits = _mm512_castps_si512(a);
+        e = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(bits, 23), _mm512_set1_epi32(126)));
+        const auto m = _mm512_and_si512(bits, _mm512_set1_epi32(0x007fffff));
+        return _mm512_castsi512_ps(_mm512_or_si512(m, _mm512_set1_epi32(0x3f000000)));
+    }
+};
+
+struct Simd_F64x8 final {
+    using Reg = __m512d;
+    static constexpr uint32 WIDTH = 8;
+
+    static Reg zero() {
+        return _mm512_setzero_pd();
+    }
+
+    static Reg set1(float64 x) {
+        return _mm512_set1_pd(x);
+    }
+
+    static Reg loadu(const float64* p) {
+        return _mm512_loadu_pd(p);
+    }
+
+    static void storeu(float64* p, Reg v) {
+        _mm512_storeu_pd(p, v);
+    }
+
+    static Reg add(Reg a, Reg b) {
+        return _mm512_add_pd(a, b);
+    }
+
+    static Reg sub(Reg a, Reg b) {
+        return _mm512_sub_pd(a, b);
+    }
+
+    static Reg mul(Reg a, Reg b) {
+        return _mm512_mul_pd(a, b);
+    }
+
+    static Reg madd(Reg a, Reg b, Reg c) {
+        return _mm512_fmadd_pd(a, b, c);
+    }
+};
+
+using Simd_F32 = Simd_F32x16;
+using Simd_F64 = Simd_F64x8;
+#elif defined(SB_SIMD_AVX)
+using Simd_F32 = Simd_F32x8;
+using Simd_F64 = Simd_F64x4;
+#else
+using Simd_F32 = Simd_F32x4;
+using Simd_F64 = Simd_F64x2;
+#endif
+
+} // namespace SB_SIMD_NAMESPACE
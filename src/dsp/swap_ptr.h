@@ -0,0 +1,60 @@
+#pragma once
+
+#include "util.h"
+
+#include <rigtorp/SPSCQueue.h>
+
+#include <atomic>
+#include <memory>
+
+// one writer hands whole immutable objects to one reader through a pointer swap. the reader picks up the
+// newest at a point of its choosing and never frees: the object it lets go of goes back to the writer,
+// which deletes it on its next publish. neither side waits, and the reader never touches the heap.
+template <typename T>
+class Swap_Ptr final {
+  public:
+    Swap_Ptr() = default;
+    ~Swap_Ptr() {
+        collect();
+        delete m_pending.load(std::memory_order_acquire);
+        delete m_current;
+    }
+
+    Swap_Ptr(const Swap_Ptr&) = delete;
+    Swap_Ptr& operator=(const Swap_Ptr&) = delete;
+
+    // writer. an object published before and not picked up yet is replaced and freed
+    void publish(std::unique_ptr<const T> next) {
+        collect();
+        delete m_pending.exchange(next.release(), std::memory_order_acq_rel);
+    }
+
+    // writer. frees what the reader has let go of
+    void collect() {
+        while (const auto* p = m_retired.front()) {
+            delete *p;
+            m_retired.pop();
+        }
+    }
+
+    // reader. the newest published object, null until the first
+    const T* acquire() {
+        if (m_pending.load(std::memory_order_relaxed)) {
+            if (const auto* next = m_pending.exchange(nullptr, std::memory_order_acq_rel)) {
+                // every retire follows a publish and every publish collects first, so at most two wait here
+                if (m_current) {
+                    [[maybe_unused]] const auto retired = m_retired.try_push(m_current);
+                    sb_ASSERT(retired);
+                }
+                m_current = next;
+            }
+        }
+        return m_current;
+    }
+
+  private:
+    alignas(64) std::atomic<const T*> m_pending = nullptr;
+    rigtorp::SPSCQueue<const T*> m_retired{4};
+    // reader side
+    alignas(64) const T* m_current = nullptr;
+};
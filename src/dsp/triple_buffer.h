@@ -0,0 +1,48 @@
+#pragma once
+
+#include "util.h"
+
+#include <atomic>
+
+// one writer, one reader. the writer always has a slot of its own to fill and the reader always gets the most
+// recently published one, so neither side ever waits or allocates.
+template <typename T>
+class Triple_Buffer final {
+  public:
+    // writer. fill this slot, then publish it
+    T& write_slot() {
+        return m_slots[m_write];
+    }
+
+    void publish() {
+        m_write = m_shared.exchange(m_write | DIRTY, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // reader. picks up the newest published slot, returns false if nothing was published since the last call
+    bool update() {
+        if ((m_shared.load(std::memory_order_relaxed) & DIRTY) == 0)
+            return false;
+        m_read = m_shared.exchange(m_read, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    const T& read_slot() const {
+        return m_slots[m_read];
+    }
+
+    // for preallocating before either side starts
+    template <typename F>
+    void for_each(F&& f) {
+        for (auto& slot : m_slots)
+            f(slot);
+    }
+
+  private:
+    static constexpr uint8 INDEX = 3;
+    static constexpr uint8 DIRTY = 4;
+
+    std::array<T, 3> m_slots;
+    uint8 m_write = 0;
+    alignas(64) std::atomic<uint8> m_shared = 1;
+    alignas(64) uint8 m_read = 2;
+};
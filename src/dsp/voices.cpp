@@ -0,0 +1,283 @@
+#include "voices.h"
+#include "kernels.h"
+#include "params.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static constexpr uint32 NO_VOICE = ~0u;
+// -80 db, where a releasing voice is let go
+static constexpr float32 VOICE_SILENT = 1e-4f;
+
+static uint32 voice_lanes(uint32 voices) {
+    return (voices + SIMD_MAX_WIDTH - 1) / SIMD_MAX_WIDTH * SIMD_MAX_WIDTH;
+}
+
+Voice_Allocator::Voice_Allocator(std::shared_ptr<const Wavetable> table, uint32 max_voices)
+    : Voice_Allocator{std::allocator_arg, {}, std::move(table), max_voices} {
+}
+
+Voice_Allocator::Voice_Allocator(
+    std::allocator_arg_t, const allocator_type& alloc, std::shared_ptr<const Wavetable> table,
+    uint32 max_voices)
+    : m_table{std::move(table)}, m_max_voices{max_voices}, m_offset{alloc}, m_inc{alloc}, m_phase{alloc},
+      m_amp{alloc}, m_amp_step{alloc}, m_lp_coeff{alloc}, m_lp_state{alloc}, m_key{alloc}, m_stage{alloc},
+      m_velocity{alloc}, m_amp_end{alloc}, m_started{alloc} {
+    sb_ASSERT(m_table && max_voices > 0);
+    const auto lanes = voice_lanes(max_voices);
+    m_offset.resize(lanes, 0.f);
+    m_inc.resize(lanes, 0.f);
+    m_phase.resize(lanes, 0.f);
+    m_amp.resize(lanes, 0.f);
+    m_amp_step.resize(lanes, 0.f);
+    m_lp_coeff.resize(lanes, 1.f);
+    m_lp_state.resize(lanes, 0.f);
+    m_key.resize(max_voices, 0);
+    m_stage.resize(max_voices, Stage_Release);
+    m_velocity.resize(max_voices, 0.f);
+    m_amp_end.resize(max_voices, 0.f);
+    m_started.resize(max_voices, 0);
+}
+
+void Voice_Allocator::set_sample_rate(float32 sample_rate) {
+    m_sample_rate = sample_rate;
+    reset();
+}
+
+void Voice_Allocator::set_envelope(const Voice_Envelope& envelope) {
+    m_envelope = envelope;
+}
+
+void Voice_Allocator::set_brightness(float32 harmonics) {
+    m_brightness = harmonics;
+}
+
+bool Voice_Allocator::note_on(uint32 key, float32 note, float32 velocity) {
+    note_off(key);
+
+    auto voice = NO_VOICE;
+    if (m_active < m_max_voices) {
+        voice = m_active++;
+        m_phase[voice] = 0.f;
+        m_amp[voice] = 0.f;
+        m_lp_state[voice] = 0.f;
+    } else {
+        // a stolen voice keeps its phase, level and filter, so it glides into the new attack without a click
+        voice = steal();
+        if (voice == NO_VOICE)
+            return false;
+    }
+    start(voice, key, note, velocity);
+    return true;
+}
+
+void Voice_Allocator::note_off(uint32 key) {
+    const auto voice = find_key(key);
+    if (voice != NO_VOICE)
+        m_stage[voice] = Stage_Release;
+}
+
+void Voice_Allocator::reset() {
+    std::fill(m_amp.begin(), m_amp.end(), 0.f);
+    std::fill(m_amp_step.begin(), m_amp_step.end(), 0.f);
+    std::fill(m_lp_state.begin(), m_lp_state.end(), 0.f);
+    m_active = 0;
+}
+
+void Voice_Allocator::render(float32* out, uint32 frame_count) {
+    const auto& kernels = dsp_kernels();
+    for (uint32 i = 0; i < frame_count && m_active > 0; i += DSP_CONTROL_FRAMES) {
+        const auto n = std::min(DSP_CONTROL_FRAMES, frame_count - i);
+        step_envelopes(n);
+
+        const Dsp_Wavetable_Lanes lanes{
+            .offset = m_offset.data(),
+            .inc = m_inc.data(),
+            .phase = m_phase.data(),
+            .amp = m_amp.data(),
+            .amp_step = m_amp_step.data(),
+            .lp_coeff = m_lp_coeff.data(),
+            .lp_state = m_lp_state.data(),
+            .count = voice_lanes(m_active),
+        };
+        kernels.wavetable(m_table->data(), Wavetable::SIZE, lanes, out + i, n);
+
+        // the envelope's exact end rather than the kernel's sum of steps, then finished voices go
+        std::memcpy(m_amp.data(), m_amp_end.data(), m_active * sizeof(float32));
+        for (auto v = m_active; v-- > 0;) {
+            if (m_amp[v] == 0.f && m_stage[v] == Stage_Release)
+                remove(v);
+        }
+    }
+}
+
+uint32 Voice_Allocator::find_key(uint32 key) const {
+    for (uint32 v = 0; v < m_active; ++v) {
+        if (m_key[v] == key && m_stage[v] != Stage_Release)
+            return v;
+    }
+    return NO_VOICE;
+}
+
+uint32 Voice_Allocator::steal() const {
+    if (m_steal == Voice_Steal::None)
+        return NO_VOICE;
+
+    // releasing voices rank below held ones, then by age or level
+    auto best = NO_VOICE;
+    auto best_held = true;
+    auto best_score = 0.0;
+    for (uint32 v = 0; v < m_active; ++v) {
+        const auto held = m_stage[v] != Stage_Release;
+        const auto score = m_steal == Voice_Steal::Oldest ? static_cast<float64>(m_started[v]) : m_amp[v];
+        if (best == NO_VOICE || (!held && best_held) || (held == best_held && score < best_score)) {
+            best = v;
+            best_held = held;
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+void Voice_Allocator::start(uint32 voice, uint32 key, float32 note, float32 velocity) {
+    const auto hz = 440.f * std::exp2((note - 69.f) / 12.f);
+    const auto inc = hz / m_sample_rate;
+    m_inc[voice] = inc;
+    m_offset[voice] = static_cast<float32>(Wavetable::level_for(inc) * Wavetable::LEVEL_STRIDE);
+
+    velocity = std::clamp(velocity, 0.f, 1.f);
+    const auto cutoff = std::min(hz * m_brightness * (0.25f + 0.75f * velocity), m_sample_rate * 0.45f);
+    m_lp_coeff[voice] = 1.f - std::exp(-2.f * Math_Consts<float32>::pi * cutoff / m_sample_rate);
+
+    m_key[voice] = key;
+    m_stage[voice] = Stage_Attack;
+    m_velocity[voice] = velocity;
+    m_started[voice] = ++m_note_count;
+}
+
+void Voice_Allocator::step_envelopes(uint32 frame_count) {
+    const auto n = static_cast<float32>(frame_count);
+    const auto attack = n / std::max(m_envelope.attack_s * m_sample_rate, 1.f);
+    const auto decay = std::exp(-n / std::max(m_envelope.decay_s * m_sample_rate, 1.f));
+    const auto release = std::exp(-n / std::max(m_envelope.release_s * m_sample_rate, 1.f));
+
+    for (uint32 v = 0; v < m_active; ++v) {
+        const auto peak = m_velocity[v];
+        const auto amp = m_amp[v];
+        auto end = 0.f;
+        switch (m_stage[v]) {
+        case Stage_Attack:
+            end = amp + peak * attack;
+            if (end >= peak) {
+                end = peak;
+                m_stage[v] = Stage_Decay;
+            }
+            break;
+        case Stage_Decay: {
+            const auto sustain = peak * m_envelope.sustain;
+            end = sustain + (amp - sustain) * decay;
+            break;
+        }
+        case Stage_Release:
+            end = amp * release;
+            if (end < VOICE_SILENT)
+                end = 0.f;
+            break;
+        }
+        m_amp_step[v] = (end - amp) / n;
+        m_amp_end[v] = end;
+    }
+}
+
+void Voice_Allocator::remove(uint32 voice) {
+    const auto last = --m_active;
+    if (voice != last) {
+        m_offset[voice] = m_offset[last];
+        m_inc[voice] = m_inc[last];
+        m_phase[voice] = m_phase[last];
+        m_amp[voice] = m_amp[last];
+        m_amp_step[voice] = m_amp_step[last];
+        m_lp_coeff[voice] = m_lp_coeff[last];
+        m_lp_state[voice] = m_lp_state[last];
+        m_key[voice] = m_key[last];
+        m_stage[voice] = m_stage[last];
+        m_velocity[voice] = m_velocity[last];
+        m_amp_end[voice] = m_amp_end[last];
+        m_started[voice] = m_started[last];
+    }
+    // padding the kernel still runs over has to stay silent
+    m_amp[last] = 0.f;
+    m_amp_step[last] = 0.f;
+    m_lp_state[last] = 0.f;
+}
+
+Dsp_Voice_Node::Dsp_Voice_Node(
+    uint32 channels, std::shared_ptr<const Wavetable> table, uint32 voice_count, uint32 keys)
+    : Dsp_Voice_Node{std::allocator_arg, {}, channels, std::move(table), voice_count, keys} {
+}
+
+Dsp_Voice_Node::Dsp_Voice_Node(
+    std::allocator_arg_t, const allocator_type& alloc, uint32 channels,
+    std::shared_ptr<const Wavetable> table, uint32 voice_count, uint32 keys)
+    : channels{channels}, voices{std::allocator_arg, alloc, std::move(table), voice_count},
+      m_key_velocity{alloc} {
+    m_key_velocity.resize(keys, 1.f);
+}
+
+Dsp_Node_Desc Dsp_Voice_Node::desc() const {
+    return {"Voices", 0, 1, channels};
+}
+
+void Dsp_Voice_Node::prepare(const Dsp_Prepare& prepare) {
+    voices.set_sample_rate(static_cast<float32>(prepare.sample_rate));
+}
+
+void Dsp_Voice_Node::process(const Dsp_Process_Args& args) {
+    const auto& out = args.outputs[0];
+    auto* dst = out.channel(0);
+    std::memset(dst, 0, args.frame_count * sizeof(float32));
+    voices.render(dst, args.frame_count);
+    for (uint32 c = 1; c < channels; ++c)
+        std::memcpy(out.channel(c), dst, args.frame_count * sizeof(float32));
+}
+
+void Dsp_Voice_Node::set_param(uint32 param, float32 value, uint32) {
+    if (param >= PARAM_KEYS) {
+        const auto key = (param - PARAM_KEYS) / PARAMS_PER_KEY;
+        if (key >= m_key_velocity.size())
+            return;
+        if ((param - PARAM_KEYS) % PARAMS_PER_KEY == PARAM_KEY_VELOCITY)
+            m_key_velocity[key] = value;
+        else if (value < 0.f)
+            voices.note_off(key);
+        else
+            voices.note_on(key, value, m_key_velocity[key]);
+        return;
+    }
+
+    switch (param) {
+    case PARAM_ATTACK:
+        m_envelope.attack_s = value;
+        break;
+    case PARAM_DECAY:
+        m_envelope.decay_s = value;
+        break;
+    case PARAM_SUSTAIN:
+        m_envelope.sustain = value;
+        break;
+    case PARAM_RELEASE:
+        m_envelope.release_s = value;
+        break;
+    case PARAM_BRIGHTNESS:
+        voices.set_brightness(value);
+        return;
+    case PARAM_STEAL:
+        voices.set_steal(static_cast<Voice_Steal>(std::clamp(static_cast<int32>(value), 0, 2)));
+        return;
+    default:
+        return;
+    }
+    voices.set_envelope(m_envelope);
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "graph.h"
+#include "wavetable.h"
+
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// which voice a note-on takes when every voice is sounding. both policies take a releasing voice before a
+// held one.
+enum class Voice_Steal {
+    // the new note is dropped
+    None,
+    Oldest,
+    Quietest,
+};
+
+// attack is linear; decay heads for the sustain level and release for silence exponentially, with the given
+// time constants
+struct Voice_Envelope final {
+    float32 attack_s = 0.005f;
+    float32 decay_s = 0.2f;
+    float32 sustain = 0.6f;
+    float32 release_s = 0.15f;
+};
+
+// polyphonic wavetable voices, each an oscillator, a one-pole lowpass and an envelope. all per-voice state
+// lives in structure-of-arrays form with the sounding voices packed at the front, so the kernel runs
+// straight over them and a finished voice is replaced by the last one. notes are addressed by key: a tracker
+// channel, a midi note, whatever the caller routes by; a note-on for a key that's sounding releases its old
+// voice. render interleaved with note_on and note_off is sample accurate; envelopes are stepped every
+// DSP_CONTROL_FRAMES from the start of each render.
+class Voice_Allocator final {
+  public:
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    Voice_Allocator(std::shared_ptr<const Wavetable> table, uint32 max_voices);
+    Voice_Allocator(
+        std::allocator_arg_t, const allocator_type& alloc, std::shared_ptr<const Wavetable> table,
+        uint32 max_voices);
+
+    void set_sample_rate(float32 sample_rate);
+    void set_envelope(const Voice_Envelope& envelope);
+    // the lowpass cutoff in harmonics of the note at full velocity, scaled down to a quarter at zero
+    void set_brightness(float32 harmonics);
+
+    void set_steal(Voice_Steal steal) {
+        m_steal = steal;
+    }
+
+    // note is a midi note number, fractions allowed; velocity in [0, 1]. false if no voice could be had.
+    bool note_on(uint32 key, float32 note, float32 velocity);
+    void note_off(uint32 key);
+    // silences everything at once
+    void reset();
+
+    // adds the sounding voices into out
+    void render(float32* out, uint32 frame_count);
+
+    uint32 active() const {
+        return m_active;
+    }
+
+    uint32 capacity() const {
+        return m_max_voices;
+    }
+
+  private:
+    // decay carries on into the sustain level, so a changed sustain is glided to rather than jumped
+    enum Stage : uint8 {
+        Stage_Attack,
+        Stage_Decay,
+        Stage_Release,
+    };
+
+    uint32 find_key(uint32 key) const;
+    uint32 steal() const;
+    void start(uint32 voice, uint32 key, float32 note, float32 velocity);
+    void step_envelopes(uint32 frame_count);
+    void remove(uint32 voice);
+
+    std::shared_ptr<const Wavetable> m_table;
+    uint32 m_max_voices;
+    uint32 m_active = 0;
+    float32 m_sample_rate = 48000.f;
+    Voice_Envelope m_envelope;
+    float32 m_brightness = 16.f;
+    Voice_Steal m_steal = Voice_Steal::Oldest;
+    uint64 m_note_count = 0;
+
+    // the kernel's lanes, padded to a multiple of SIMD_MAX_WIDTH; amp is the envelope level times velocity
+    std::pmr::vector<float32> m_offset;
+    std::pmr::vector<float32> m_inc;
+    std::pmr::vector<float32> m_phase;
+    std::pmr::vector<float32> m_amp;
+    std::pmr::vector<float32> m_amp_step;
+    std::pmr::vector<float32> m_lp_coeff;
+    std::pmr::vector<float32> m_lp_state;
+    // the rest of the voice
+    std::pmr::vector<uint32> m_key;
+    std::pmr::vector<uint8> m_stage;
+    std::pmr::vector<float32> m_velocity;
+    // where each voice's envelope is at the end of the current control chunk
+    std::pmr::vector<float32> m_amp_end;
+    // note-on order, for stealing the oldest
+    std::pmr::vector<uint64> m_started;
+};
+
+// a Voice_Allocator in the graph, summed to every channel. note events arrive as params so they land on
+// their sample: key k's PARAM_KEYS + k * PARAMS_PER_KEY + PARAM_KEY_VELOCITY sets the velocity for its
+// next note, and + PARAM_KEY_NOTE starts a note with the value as its midi note, or releases it if the
+// value is negative. the rest set the envelope in seconds and sustain level, the brightness in harmonics and
+// the Voice_Steal policy; none of them ramp.
+struct Dsp_Voice_Node final {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    static constexpr uint32 PARAM_ATTACK = 0;
+    static constexpr uint32 PARAM_DECAY = 1;
+    static constexpr uint32 PARAM_SUSTAIN = 2;
+    static constexpr uint32 PARAM_RELEASE = 3;
+    static constexpr uint32 PARAM_BRIGHTNESS = 4;
+    static constexpr uint32 PARAM_STEAL = 5;
+    static constexpr uint32 PARAM_KEYS = 8;
+    static constexpr uint32 PARAM_KEY_VELOCITY = 0;
+    static constexpr uint32 PARAM_KEY_NOTE = 1;
+    static constexpr uint32 PARAMS_PER_KEY = 2;
+
+    Dsp_Voice_Node(uint32 channels, std::shared_ptr<const Wavetable> table, uint32 voice_count, uint32 keys);
+    Dsp_Voice_Node(
+        std::allocator_arg_t, const allocator_type& alloc, uint32 channels,
+        std::shared_ptr<const Wavetable> table, uint32 voice_count, uint32 keys);
+
+    Dsp_Node_Desc desc() const;
+    void prepare(const Dsp_Prepare& prepare);
+    void process(const Dsp_Process_Args& args);
+    void set_param(uint32 param, float32 value, uint32 ramp_frames);
+
+    static uint32 key_param(uint32 key, uint32 param) {
+        return PARAM_KEYS + key * PARAMS_PER_KEY + param;
+    }
+
+    uint32 channels;
+    Voice_Allocator voices;
+
+  private:
+    Voice_Envelope m_envelope;
+    std::pmr::vector<float32> m_key_velocity;
+};
@@ -0,0 +1,235 @@
+#include "wavetable.h"
+#include "kernels.h"
+#include "simd.h"
+
+#include <fft.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static_assert(Wavetable::LEVEL_STRIDE % SIMD_MAX_WIDTH == 0);
+static_assert(Wavetable::HARMONICS >> (Wavetable::LEVELS - 2) == 1);
+
+static float32* wavetable_alloc(size_t count) {
+    return static_cast<float32*>(mufft_calloc(count * sizeof(float32)));
+}
+
+static uint32 wavetable_lanes(uint32 voices) {
+    return std::max<uint32>(1, (voices + SIMD_MAX_WIDTH - 1) / SIMD_MAX_WIDTH) * SIMD_MAX_WIDTH;
+}
+
+Wavetable::Wavetable(Wavetable_Shape shape)
+    : m_samples{wavetable_alloc(static_cast<size_t>(LEVELS) * LEVEL_STRIDE)} {
+    // sine series a_k sin(k x), which an inverse fft gives back from bin k = -j a_k / 2
+    std::vector<float32> spectrum((HARMONICS + 1) * 2, 0.f);
+    const auto pi = Math_Consts<float64>::pi;
+    for (uint32 k = 1; k <= HARMONICS; ++k) {
+        auto a = 0.0;
+        switch (shape) {
+        case Wavetable_Shape::Sine:
+            a = k == 1 ? 1.0 : 0.0;
+            break;
+        case Wavetable_Shape::Saw:
+            a = (k % 2 ? 2.0 : -2.0) / (pi * k);
+            break;
+        case Wavetable_Shape::Square:
+            a = k % 2 ? 4.0 / (pi * k) : 0.0;
+            break;
+        case Wavetable_Shape::Triangle:
+            a = k % 2 ? ((k / 2) % 2 ? -8.0 : 8.0) / (pi * pi * k * k) : 0.0;
+            break;
+        }
+        spectrum[k * 2 + 1] = static_cast<float32>(-a / 2.0);
+    }
+    build(spectrum.data());
+}
+
+Wavetable::Wavetable(std::span<const float32> cycle)
+    : m_samples{wavetable_alloc(static_cast<size_t>(LEVELS) * LEVEL_STRIDE)} {
+    const auto n = static_cast<uint32>(cycle.size());
+    sb_ASSERT(n >= 2 && (n & (n - 1)) == 0); // mufft needs a power of two
+
+    auto* plan = mufft_create_plan_1d_r2c(n, MUFFT_FLAG_CPU_ANY);
+    auto* time = wavetable_alloc(n);
+    auto* bins = wavetable_alloc(static_cast<size_t>(n / 2 + 1) * 2);
+    std::memcpy(time, cycle.data(), n * sizeof(float32));
+    mufft_execute_plan_1d(plan, bins, time);
+
+    // the forward transform is unnormalized; the nyquist bin has no phase to keep, so it goes with dc
+    std::vector<float32> spectrum((HARMONICS + 1) * 2, 0.f);
+    const auto scale = 1.f / static_cast<float32>(n);
+    for (uint32 k = 1; k < std::min(n / 2, HARMONICS + 1); ++k) {
+        spectrum[k * 2] = bins[k * 2] * scale;
+        spectrum[k * 2 + 1] = bins[k * 2 + 1] * scale;
+    }
+
+    mufft_free(bins);
+    mufft_free(time);
+    mufft_free_plan_1d(plan);
+    build(spectrum.data());
+}
+
+Wavetable::~Wavetable() {
+    mufft_free(m_samples);
+}
+
+uint32 Wavetable::level_for(float32 increment) {
+    // ceil(log2(increment * 2 * HARMONICS)), from the exponent so the audio thread needn't call log2
+    int e;
+    const auto m = std::frexp(increment * static_cast<float32>(HARMONICS * 2), &e);
+    const auto level = m == 0.5f ? e - 1 : e;
+    return static_cast<uint32>(std::clamp(level, 0, static_cast<int>(LEVELS) - 1));
+}
+
+void Wavetable::build(const float32* spectrum) {
+    auto* plan = mufft_create_plan_1d_c2r(SIZE, MUFFT_FLAG_CPU_ANY);
+    auto* bins = wavetable_alloc(static_cast<size_t>(SIZE / 2 + 1) * 2);
+
+    // the last level stays silent
+    for (uint32 l = 0; l + 1 < LEVELS; ++l) {
+        std::memset(bins, 0, static_cast<size_t>(SIZE / 2 + 1) * 2 * sizeof(float32));
+        std::memcpy(bins + 2, spectrum + 2, (HARMONICS >> l) * 2 * sizeof(float32));
+        auto* dst = m_samples + static_cast<size_t>(l) * LEVEL_STRIDE;
+        mufft_execute_plan_1d(plan, dst, bins);
+    }
+
+    // every level scaled by the fullest one's peak, so loudness holds across octaves
+    auto peak = 0.f;
+    for (uint32 i = 0; i < SIZE; ++i)
+        peak = std::max(peak, std::abs(m_samples[i]));
+    const auto gain = peak > 0.f ? 1.f / peak : 0.f;
+    for (uint32 l = 0; l + 1 < LEVELS; ++l) {
+        auto* dst = m_samples + static_cast<size_t>(l) * LEVEL_STRIDE;
+        for (uint32 i = 0; i < SIZE; ++i)
+            dst[i] *= gain;
+        dst[SIZE] = dst[0];
+        dst[SIZE + 1] = dst[1];
+    }
+
+    mufft_free(bins);
+    mufft_free_plan_1d(plan);
+}
+
+Dsp_Wavetable_Node::Dsp_Wavetable_Node(uint32 channels, std::shared_ptr<const Wavetable> table, uint32 voices)
+    : Dsp_Wavetable_Node{std::allocator_arg, {}, channels, std::move(table), voices} {
+}
+
+Dsp_Wavetable_Node::Dsp_Wavetable_Node(
+    std::allocator_arg_t, const allocator_type& alloc, uint32 channels,
+    std::shared_ptr<const Wavetable> table, uint32 voices)
+    : channels{channels}, m_table{std::move(table)}, m_voices{voices}, m_log2_freq{alloc}, m_amplitude{alloc},
+      m_ramping{alloc}, m_offset{alloc}, m_inc{alloc}, m_phase{alloc}, m_amp{alloc}, m_amp_step{alloc},
+      m_lp_coeff{alloc}, m_lp_state{alloc} {
+    sb_ASSERT(m_table);
+    m_log2_freq.resize(voices, Dsp_Smoothed{std::log2(440.f)});
+    m_amplitude.resize(voices, Dsp_Smoothed{0.f});
+    m_ramping.reserve(voices);
+
+    const auto lanes = wavetable_lanes(voices);
+    m_offset.resize(lanes, static_cast<float32>((Wavetable::LEVELS - 1) * Wavetable::LEVEL_STRIDE));
+    m_inc.resize(lanes, 0.f);
+    m_phase.resize(lanes, 0.f);
+    m_amp.resize(lanes, 0.f);
+    m_amp_step.resize(lanes, 0.f);
+    m_lp_coeff.resize(lanes, 1.f);
+    m_lp_state.resize(lanes, 0.f);
+    for (uint32 v = 0; v < voices; ++v)
+        retune(v);
+}
+
+Dsp_Node_Desc Dsp_Wavetable_Node::desc() const {
+    return {"Wavetable", 0, 1, channels};
+}
+
+void Dsp_Wavetable_Node::prepare(const Dsp_Prepare& prepare) {
+    m_sample_rate = static_cast<float32>(prepare.sample_rate);
+    for (uint32 v = 0; v < m_voices; ++v)
+        retune(v);
+}
+
+void Dsp_Wavetable_Node::process(const Dsp_Process_Args& args) {
+    const auto& out = args.outputs[0];
+    auto* dst = out.channel(0);
+    std::memset(dst, 0, args.frame_count * sizeof(float32));
+
+    const auto& kernels = dsp_kernels();
+    const Dsp_Wavetable_Lanes lanes{
+        .offset = m_offset.data(),
+        .inc = m_inc.data(),
+        .phase = m_phase.data(),
+        .amp = m_amp.data(),
+        .amp_step = m_amp_step.data(),
+        .lp_coeff = m_lp_coeff.data(),
+        .lp_state = m_lp_state.data(),
+        .count = static_cast<uint32>(m_amp.size()),
+    };
+    auto run = [&](float32* o, uint32 n) {
+        kernels.wavetable(m_table->data(), Wavetable::SIZE, lanes, o, n);
+    };
+
+    if (m_ramping.empty()) {
+        run(dst, args.frame_count);
+    } else {
+        // the kernel ramps amplitude linearly within a control chunk; pitch moves between them
+        for (uint32 i = 0; i < args.frame_count; i += DSP_CONTROL_FRAMES) {
+            const auto n = std::min(DSP_CONTROL_FRAMES, args.frame_count - i);
+            for (const auto v : m_ramping) {
+                m_amp[v] = m_amplitude[v].value;
+                m_amp_step[v] = (m_amplitude[v].advance(n) - m_amp[v]) / static_cast<float32>(n);
+                if (m_log2_freq[v].ramping()) {
+                    m_log2_freq[v].advance(n);
+                    retune(v);
+                }
+            }
+            run(dst + i, n);
+        }
+
+        for (uint32 r = 0; r < m_ramping.size();) {
+            const auto v = m_ramping[r];
+            m_amp[v] = m_amplitude[v].value;
+            m_amp_step[v] = 0.f;
+            if (m_amplitude[v].ramping() || m_log2_freq[v].ramping()) {
+                ++r;
+            } else {
+                m_ramping[r] = m_ramping.back();
+                m_ramping.pop_back();
+            }
+        }
+    }
+
+    for (uint32 c = 1; c < channels; ++c)
+        std::memcpy(out.channel(c), dst, args.frame_count * sizeof(float32));
+}
+
+void Dsp_Wavetable_Node::set_param(uint32 param, float32 value, uint32 ramp_frames) {
+    const auto voice = param / PARAMS_PER_VOICE;
+    if (voice >= m_voices)
+        return;
+
+    const auto was_ramping = m_amplitude[voice].ramping() || m_log2_freq[voice].ramping();
+    switch (param % PARAMS_PER_VOICE) {
+    case PARAM_FREQ:
+        m_log2_freq[voice].set(std::log2(std::max(value, 1.f)), ramp_frames);
+        if (ramp_frames == 0)
+            retune(voice);
+        break;
+    case PARAM_AMPLITUDE:
+        m_amplitude[voice].set(value, ramp_frames);
+        if (ramp_frames == 0)
+            m_amp[voice] = value;
+        break;
+    }
+    if (ramp_frames > 0 && !was_ramping)
+        m_ramping.push_back(voice);
+}
+
+void Dsp_Wavetable_Node::set_voice(uint32 voice, float32 freq, float32 amplitude) {
+    set_param(voice * PARAMS_PER_VOICE + PARAM_FREQ, freq, 0);
+    set_param(voice * PARAMS_PER_VOICE + PARAM_AMPLITUDE, amplitude, 0);
+}
+
+void Dsp_Wavetable_Node::retune(uint32 voice) {
+    const auto inc = std::exp2(m_log2_freq[voice].value) / m_sample_rate;
+    m_inc[voice] = inc;
+    m_offset[voice] = static_cast<float32>(Wavetable::level_for(inc) * Wavetable::LEVEL_STRIDE);
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "graph.h"
+#include "params.h"
+
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+enum class Wavetable_Shape {
+    Sine,
+    Saw,
+    Square,
+    Triangle,
+};
+
+// one cycle of a waveform, band-limited once per octave of playback pitch so no harmonic ever passes
+// nyquist: level l keeps HARMONICS >> l harmonics and serves increments up to 2^l / (2 * HARMONICS)
+// cycles per sample, and a last silent level takes everything above nyquist. the tables are at least eight
+// samples per cycle of their highest harmonic, which keeps linear interpolation's images down. built with
+// mufft at load time and immutable afterwards so it can be shared between nodes.
+class Wavetable final {
+  public:
+    static constexpr uint32 SIZE = 4096;
+    static constexpr uint32 HARMONICS = SIZE / 8;
+    static constexpr uint32 LEVELS = 11;
+    // a level, the two guard samples interpolation reads past its end, and padding to keep levels aligned
+    static constexpr uint32 LEVEL_STRIDE = SIZE + 16;
+
+    explicit Wavetable(Wavetable_Shape shape);
+    // one cycle of any power of two length; its dc is dropped and it's resampled to SIZE through its spectrum
+    explicit Wavetable(std::span<const float32> cycle);
+    ~Wavetable();
+
+    Wavetable(const Wavetable&) = delete;
+    Wavetable& operator=(const Wavetable&) = delete;
+
+    // all the levels, LEVEL_STRIDE apart
+    const float32* data() const {
+        return m_samples;
+    }
+
+    const float32* level(uint32 l) const {
+        return m_samples + static_cast<size_t>(l) * LEVEL_STRIDE;
+    }
+
+    // the fullest level whose harmonics all stay below nyquist at increment cycles per sample
+    static uint32 level_for(float32 increment);
+
+  private:
+    // spectrum holds bins 0 ..= HARMONICS interleaved complex, scaled so an inverse fft gives the cycle
+    void build(const float32* spectrum);
+
+    float32* m_samples;
+};
+
+// a bank of wavetable oscillators summed to every channel: one voice for test tones and sweeps, hundreds
+// for tracker playback. voice v's parameters are v * PARAMS_PER_VOICE plus PARAM_FREQ in hz, ramped in
+// octaves so a ramp is an exponential sweep, or PARAM_AMPLITUDE, ramped linearly. the voices are kept in
+// structure-of-arrays form and run a simd register of voices at a time, so register blocks of silent voices
+// cost only a check; keep the sounding ones packed low.
+struct Dsp_Wavetable_Node final {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    static constexpr uint32 PARAM_FREQ = 0;
+    static constexpr uint32 PARAM_AMPLITUDE = 1;
+    static constexpr uint32 PARAMS_PER_VOICE = 2;
+
+    Dsp_Wavetable_Node(uint32 channels, std::shared_ptr<const Wavetable> table, uint32 voices = 1);
+    Dsp_Wavetable_Node(
+        std::allocator_arg_t, const allocator_type& alloc, uint32 channels,
+        std::shared_ptr<const Wavetable> table, uint32 voices = 1);
+
+    Dsp_Node_Desc desc() const;
+    void prepare(const Dsp_Prepare& prepare);
+    void process(const Dsp_Process_Args& args);
+    void set_param(uint32 param, float32 value, uint32 ramp_frames);
+
+    // straight away, for setting voices up before the graph runs
+    void set_voice(uint32 voice, float32 freq, float32 amplitude);
+
+    uint32 voices() const {
+        return m_voices;
+    }
+
+    uint32 channels;
+
+  private:
+    void retune(uint32 voice);
+
+    std::shared_ptr<const Wavetable> m_table;
+    uint32 m_voices;
+    float32 m_sample_rate = 48000.f;
+    std::pmr::vector<Dsp_Smoothed> m_log2_freq;
+    std::pmr::vector<Dsp_Smoothed> m_amplitude;
+    // voices with a ramp in flight, stepped at DSP_CONTROL_FRAMES
+    std::pmr::vector<uint32> m_ramping;
+
+    // the kernel's lanes, padded to a multiple of SIMD_MAX_WIDTH with silent voices
+    std::pmr::vector<float32> m_offset;
+    std::pmr::vector<float32> m_inc;
+    std::pmr::vector<float32> m_phase;
+    std::pmr::vector<float32> m_amp;
+    std::pmr::vector<float32> m_amp_step;
+    std::pmr::vector<float32> m_lp_coeff;
+    std::pmr::vector<float32> m_lp_state;
+};
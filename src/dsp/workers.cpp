@@ -0,0 +1,165 @@
+#include "workers.h"
+#include "rt_alloc.h"
+#include "simd.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+static void pin_thread(std::thread& thread, uint32 core) {
+#if defined(_WIN32)
+    SetThreadAffinityMask(thread.native_handle(), DWORD_PTR{1} << core);
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+    // macos has no hard affinity, the scheduler keeps busy threads on separate cores anyway
+    (void)thread;
+    (void)core;
+#endif
+}
+
+// spins briefly, then yields so an oversubscribed machine still makes progress
+struct Spin_Wait final {
+    uint32 spins = 0;
+
+    void operator()() {
+        if (spins < 256) {
+            ++spins;
+            _mm_pause();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+};
+
+// generation in the top 32 bits, slice end and next index in 16 bits each
+static uint64 slice_word(uint32 generation, uint32 end, uint32 next) {
+    return (static_cast<uint64>(generation) << 32) | (static_cast<uint64>(end) << 16) | next;
+}
+
+Dsp_Worker_Pool::~Dsp_Worker_Pool() {
+    destroy();
+}
+
+void Dsp_Worker_Pool::create(uint32 worker_count, bool pin) {
+    destroy();
+
+    worker_count = std::min(worker_count, MAX_WORKERS);
+    m_participants = worker_count + 1;
+    m_slices = std::make_unique<Slice[]>(m_participants);
+    m_quit.store(false, std::memory_order_relaxed);
+
+    const auto cores = std::max(std::thread::hardware_concurrency(), 1u);
+    m_workers.reserve(worker_count);
+    for (uint32 i = 0; i < worker_count; ++i) {
+        m_workers.emplace_back([this, i] { worker_main(i + 1); });
+        if (pin)
+            pin_thread(m_workers.back(), (i + 1) % cores);
+    }
+}
+
+void Dsp_Worker_Pool::destroy() {
+    if (m_workers.empty())
+        return;
+
+    m_quit.store(true, std::memory_order_release);
+    m_active.store(true, std::memory_order_release);
+    m_active.notify_all();
+    for (auto& worker : m_workers)
+        worker.join();
+    m_workers.clear();
+    m_active.store(false, std::memory_order_relaxed);
+}
+
+void Dsp_Worker_Pool::begin_period() {
+    if (m_workers.empty())
+        return;
+    // seq_cst on both sides: either this sees the worker's count, or the worker's wait sees active
+    m_active.store(true, std::memory_order_seq_cst);
+    if (m_parked.load(std::memory_order_seq_cst) != 0)
+        m_active.notify_all();
+}
+
+void Dsp_Worker_Pool::end_period() {
+    m_active.store(false, std::memory_order_release);
+}
+
+void Dsp_Worker_Pool::run(Job_Fn fn, void* context, uint32 count) {
+    sb_ASSERT(count <= MAX_ITEMS);
+    if (count == 0)
+        return;
+
+    if (m_workers.empty() || count == 1) {
+        for (uint32 i = 0; i < count; ++i)
+            fn(context, i);
+        return;
+    }
+
+    const auto generation = m_generation.load(std::memory_order_relaxed) + 1;
+    m_fn.store(fn, std::memory_order_relaxed);
+    m_context.store(context, std::memory_order_relaxed);
+    m_remaining.store(count, std::memory_order_relaxed);
+    for (uint32 p = 0; p < m_participants; ++p) {
+        const auto begin = count * p / m_participants;
+        const auto end = count * (p + 1) / m_participants;
+        m_slices[p].word.store(slice_word(generation, end, begin), std::memory_order_relaxed);
+    }
+    m_generation.store(generation, std::memory_order_release);
+
+    participate(0, generation);
+    Spin_Wait spin;
+    while (m_remaining.load(std::memory_order_acquire) != 0)
+        spin();
+}
+
+void Dsp_Worker_Pool::worker_main(uint32 index) {
+    uint32 seen = m_generation.load(std::memory_order_acquire);
+    Spin_Wait spin;
+    while (!m_quit.load(std::memory_order_acquire)) {
+        if (!m_active.load(std::memory_order_acquire)) {
+            m_parked.fetch_add(1, std::memory_order_seq_cst);
+            m_active.wait(false, std::memory_order_seq_cst);
+            m_parked.fetch_sub(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        const auto generation = m_generation.load(std::memory_order_acquire);
+        if (generation == seen) {
+            spin();
+            continue;
+        }
+        seen = generation;
+        spin = {};
+        participate(index, generation);
+    }
+}
+
+void Dsp_Worker_Pool::participate(uint32 self, uint32 generation) {
+    Rt_Alloc_Scope rt;
+    const auto fn = m_fn.load(std::memory_order_relaxed);
+    auto* context = m_context.load(std::memory_order_relaxed);
+
+    // own slice first, then steal from the others in turn
+    for (uint32 k = 0; k < m_participants; ++k) {
+        auto& word = m_slices[(self + k) % m_participants].word;
+        auto current = word.load(std::memory_order_acquire);
+        for (;;) {
+            const auto next = static_cast<uint32>(current & 0xffff);
+            const auto end = static_cast<uint32>((current >> 16) & 0xffff);
+            if (static_cast<uint32>(current >> 32) != generation || next >= end)
+                break;
+            if (!word.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel))
+                continue;
+
+            fn(context, next);
+            m_remaining.fetch_sub(1, std::memory_order_acq_rel);
+            current = word.load(std::memory_order_acquire);
+        }
+    }
+}
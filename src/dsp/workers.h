@@ -0,0 +1,71 @@
+#pragma once
+
+#include "util.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// a few worker threads that help the audio thread through the independent steps of one dependency level.
+// the calling thread always takes part, so a pool with no workers still runs everything.
+//
+// each participant starts on its own slice of the job and then steals from the others' slices. a slice is
+// one 64 bit word holding the job's generation, the slice end and the next index; claiming an item is a
+// single compare-and-swap, and the generation keeps a worker that wakes up late from claiming items of a
+// newer job.
+//
+// between begin_period() and end_period() idle workers spin so dispatch costs no syscalls; outside of it
+// they block. begin_period() only makes the wake syscall when a worker has actually gone to sleep.
+class Dsp_Worker_Pool final {
+  public:
+    using Job_Fn = void (*)(void* context, uint32 index);
+
+    static constexpr uint32 MAX_WORKERS = 15;
+    // items per job are limited by the 16 bit slice indices
+    static constexpr uint32 MAX_ITEMS = 0xffff;
+
+    Dsp_Worker_Pool() = default;
+    ~Dsp_Worker_Pool();
+
+    Dsp_Worker_Pool(const Dsp_Worker_Pool&) = delete;
+    Dsp_Worker_Pool& operator=(const Dsp_Worker_Pool&) = delete;
+
+    // pins worker i to core i + 1 where the platform allows it, so no two workers share a core. the calling
+    // thread isn't pinned; it's the device's, and the os keeps it where it likes
+    void create(uint32 worker_count, bool pin = true);
+    void destroy();
+
+    uint32 worker_count() const {
+        return static_cast<uint32>(m_workers.size());
+    }
+
+    // audio thread. brackets the jobs of one device period
+    void begin_period();
+    void end_period();
+
+    // audio thread. runs fn(context, i) for every i in [0, count) and returns once all of them finished
+    void run(Job_Fn fn, void* context, uint32 count);
+
+  private:
+    struct alignas(64) Slice final {
+        std::atomic<uint64> word = 0;
+    };
+
+    void worker_main(uint32 index);
+    void participate(uint32 self, uint32 generation);
+
+    std::vector<std::thread> m_workers;
+    std::unique_ptr<Slice[]> m_slices;
+    uint32 m_participants = 1;
+
+    std::atomic<Job_Fn> m_fn = nullptr;
+    std::atomic<void*> m_context = nullptr;
+
+    alignas(64) std::atomic<uint32> m_generation = 0;
+    alignas(64) std::atomic<uint32> m_remaining = 0;
+    alignas(64) std::atomic<bool> m_active = false;
+    // workers blocked on m_active, or about to
+    std::atomic<uint32> m_parked = 0;
+    std::atomic<bool> m_quit = false;
+};
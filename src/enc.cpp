@@ -42,8 +42,7 @@ std::vector<uint8> enc_decode_exact_bytes(std::istream& is, size_t count) {
 }
 
 std::vector<uint8> enc_sstream_to_bytes(const std::stringstream& ss) {
-    const auto s = ss.str();
-    std::vector<uint8> bytes;
-    bytes.assign((const uint8*)(&s[0]), (const uint8*)(&s[s.size() - 1]));
-    return bytes;
+    // a view of the buffer, so the one copy is into the vector
+    const auto s = ss.view();
+    return std::vector<uint8>((const uint8*)s.data(), (const uint8*)s.data() + s.size());
 }
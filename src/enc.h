@@ -9,6 +9,9 @@
 #include <string_view>
 #include <span>
 #include <sstream>
+#include <optional>
+#include <cstring>
+#include <algorithm>
 
 void enc_encode_string(std::ostream& os, std::string_view str);
 std::string enc_decode_string(std::istream& is);
@@ -18,6 +21,8 @@ void enc_encode_exact_bytes(std::ostream& os, std::span<const uint8> bytes);
 std::vector<uint8> enc_decode_bytes(std::istream& is);
 std::vector<uint8> enc_decode_exact_bytes(std::istream& is, size_t count);
 
+std::vector<uint8> enc_sstream_to_bytes(const std::stringstream& ss);
+
 template <typename T>
 void enc_encode_span(std::ostream& os, std::span<const T> sp) {
     enc_encode_bytes(os, std::span{(const uint8*)sp.data(), sizeof(T) * sp.size()});
@@ -40,8 +45,203 @@ void enc_encode_one(std::ostream& os, const T& v) {
 
 template<typename T>
 T enc_decode_one(std::istream& is) {
-    const auto bytes = enc_decode_exact_bytes(is, sizeof(T));
     T out;
-    memcpy(&out, bytes.data(), sizeof(T));
+    is.read((char*)(&out), sizeof(T));
     return out;
-}
\ No newline at end of file
+}
+
+// the same encoding as the stream functions, appended to a buffer that grows as needed. small values go in
+// with a memcpy and no stream state; arrays of pods go in with one.
+class Enc_Writer final {
+  public:
+    Enc_Writer() = default;
+    explicit Enc_Writer(size_t capacity) {
+        m_bytes.resize(capacity);
+    }
+
+    void encode_string(std::string_view str) {
+        encode_one((uint32)str.size());
+        encode_exact_bytes({(const uint8*)str.data(), str.size()});
+    }
+
+    void encode_bytes(std::span<const uint8> bytes) {
+        encode_one((uint32)bytes.size());
+        encode_exact_bytes(bytes);
+    }
+
+    void encode_exact_bytes(std::span<const uint8> bytes) {
+        if (bytes.empty())
+            return;
+        const auto at = grow(bytes.size());
+        memcpy(m_bytes.data() + at, bytes.data(), bytes.size());
+    }
+
+    void encode_zeros(size_t count) {
+        const auto at = grow(count);
+        memset(m_bytes.data() + at, 0, count);
+    }
+
+    template <typename T>
+    void encode_one(const T& v) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto at = grow(sizeof(T));
+        memcpy(m_bytes.data() + at, &v, sizeof(T));
+    }
+
+    // size-prefixed, as enc_encode_span
+    template <typename T>
+    void encode_span(std::span<const T> sp) {
+        encode_bytes({(const uint8*)sp.data(), sp.size_bytes()});
+    }
+
+    // no size, the reader knows the count
+    template <typename T>
+    void encode_array(std::span<const T> sp) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        encode_exact_bytes({(const uint8*)sp.data(), sp.size_bytes()});
+    }
+
+    // rewrites a value already written at offset, for sizes and offsets only known later
+    template <typename T>
+    void patch(size_t offset, const T& v) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        sb_ASSERT(offset <= m_size && m_size - offset >= sizeof(T));
+        memcpy(m_bytes.data() + offset, &v, sizeof(T));
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+    std::span<const uint8> bytes() const {
+        return {m_bytes.data(), m_size};
+    }
+
+    // keeps the capacity
+    void clear() {
+        m_size = 0;
+    }
+
+    std::vector<uint8> release() {
+        m_bytes.resize(m_size);
+        m_size = 0;
+        return std::move(m_bytes);
+    }
+
+  private:
+    // the vector's size is the capacity and m_size is what's written. writes within it never touch the
+    // vector; only growing it zero-fills, and that's amortised by doubling
+    size_t grow(size_t count) {
+        const auto at = m_size;
+        if (m_bytes.size() - at < count)
+            m_bytes.resize(std::max(m_bytes.size() * 2, at + count));
+        m_size = at + count;
+        return at;
+    }
+
+    std::vector<uint8> m_bytes;
+    size_t m_size = 0;
+};
+
+// reads the same encoding back from memory. every read is bounds checked, and the first that runs past the
+// end fails the reader: it and every read after it return nothing. strings, bytes and arrays are views
+// into the input, valid as long as it is.
+class Enc_Reader final {
+  public:
+    Enc_Reader() = default;
+    explicit Enc_Reader(std::span<const uint8> bytes) : m_bytes{bytes} {
+    }
+
+    template <typename T>
+    std::optional<T> decode_one() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto bytes = take(sizeof(T));
+        if (!bytes)
+            return std::nullopt;
+        T out;
+        memcpy(&out, bytes->data(), sizeof(T));
+        return out;
+    }
+
+    std::optional<std::string_view> decode_string() {
+        const auto bytes = decode_bytes();
+        if (!bytes)
+            return std::nullopt;
+        return std::string_view{(const char*)bytes->data(), bytes->size()};
+    }
+
+    std::optional<std::span<const uint8>> decode_bytes() {
+        const auto size = decode_one<uint32>();
+        if (!size)
+            return std::nullopt;
+        return take(*size);
+    }
+
+    std::optional<std::span<const uint8>> decode_exact_bytes(size_t count) {
+        return take(count);
+    }
+
+    // count values in place; fails if they aren't aligned for T where they lie in memory
+    template <typename T>
+    std::optional<std::span<const T>> decode_array(size_t count) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (m_failed || count > remaining() / sizeof(T) || (uintptr_t)(m_bytes.data() + m_pos) % alignof(T)) {
+            m_failed = true;
+            return std::nullopt;
+        }
+        const auto* data = (const T*)(m_bytes.data() + m_pos);
+        m_pos += count * sizeof(T);
+        return std::span{data, count};
+    }
+
+    // as encode_span wrote it
+    template <typename T>
+    std::optional<std::span<const T>> decode_span() {
+        const auto size = decode_one<uint32>();
+        if (!size || *size % sizeof(T)) {
+            m_failed = true;
+            return std::nullopt;
+        }
+        return decode_array<T>(*size / sizeof(T));
+    }
+
+    bool skip(size_t count) {
+        return take(count).has_value();
+    }
+
+    bool seek(size_t offset) {
+        if (m_failed || offset > m_bytes.size()) {
+            m_failed = true;
+            return false;
+        }
+        m_pos = offset;
+        return true;
+    }
+
+    size_t position() const {
+        return m_pos;
+    }
+
+    size_t remaining() const {
+        return m_bytes.size() - m_pos;
+    }
+
+    bool failed() const {
+        return m_failed;
+    }
+
+  private:
+    std::optional<std::span<const uint8>> take(size_t count) {
+        if (m_failed || count > remaining()) {
+            m_failed = true;
+            return std::nullopt;
+        }
+        const auto out = m_bytes.subspan(m_pos, count);
+        m_pos += count;
+        return out;
+    }
+
+    std::span<const uint8> m_bytes;
+    size_t m_pos = 0;
+    bool m_failed = false;
+};
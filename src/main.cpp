@@ -1,5 +1,49 @@
 #include "app.h"
+#include "dsp/kernels.h"
+
+#include <spdlog/spdlog.h>
+#include <cmath>
+#include <cstdlib>
+#include <string_view>
+
+// Signalbox --render <out.wav> [seconds] [project.sbp]
+static int render_headless(const char* path, float64 seconds, const char* project) {
+    Tracker tracker;
+    tracker.create_headless();
+    if (project && !tracker.open_project(project)) {
+        spdlog::error("failed to open project {}", project);
+        tracker.destroy();
+        return EXIT_FAILURE;
+    }
+    // the only sources offline are the pattern and a silent device input
+    tracker.play_pattern(0);
+    const auto stats = tracker.render_offline(path, seconds);
+    tracker.destroy();
+
+    if (!stats) {
+        spdlog::error("failed to write {}", path);
+        return EXIT_FAILURE;
+    }
+
+    spdlog::info(
+        "rendered {:.2f}s of audio in {:.3f}s ({:.1f}x realtime) to {}", stats->audio_seconds,
+        stats->wall_seconds, stats->realtime_factor, path);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+    spdlog::info("dsp kernels: {}", cpu_isa_name(dsp_kernels().isa));
+
+    if (argc >= 3 && std::string_view{argv[1]} == "--render") {
+        // a project in the seconds' place would otherwise parse as a silent zero-second render
+        char* end = nullptr;
+        const auto seconds = argc >= 4 ? std::strtod(argv[3], &end) : 10.0;
+        if (argc >= 4 && (end == argv[3] || *end != '\0' || !(seconds > 0.0 && std::isfinite(seconds)))) {
+            spdlog::error("usage: --render <out.wav> [seconds > 0] [project.sbp], got seconds '{}'", argv[3]);
+            return EXIT_FAILURE;
+        }
+        return render_headless(argv[2], seconds, argc >= 5 ? argv[4] : nullptr);
+    }
 
-int main() {
     App{}.create().run_loop().destroy();
 }
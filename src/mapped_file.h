@@ -0,0 +1,35 @@
+#pragma once
+
+#include "util.h"
+
+#include <span>
+
+// a whole file mapped read-only. nothing is read up front: pages come in from the os cache as they're
+// first touched, so opening costs the same for any file size.
+class Mapped_File final {
+  public:
+    Mapped_File() = default;
+    ~Mapped_File();
+
+    Mapped_File(const Mapped_File&) = delete;
+    Mapped_File& operator=(const Mapped_File&) = delete;
+
+    bool create(const char* path);
+    void destroy();
+
+    std::span<const uint8> bytes() const {
+        return {m_data, m_size};
+    }
+
+    bool is_open() const {
+        return m_data != nullptr;
+    }
+
+  private:
+    const uint8* m_data = nullptr;
+    size_t m_size = 0;
+#if defined(_WIN32)
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+};
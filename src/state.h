@@ -56,6 +56,11 @@ struct UI_Colors final {
     NVGcolor dial_border_to;
     NVGcolor dial_tick;
 
+    NVGcolor plot_bg;
+    NVGcolor plot_grid;
+    NVGcolor plot_line;
+    NVGcolor plot_line_dim;
+
     NVGcolor scroll_bar_bg;
     NVGcolor scroll_bar_fg;
     NVGcolor scroll_bar_press_fg;
@@ -88,6 +93,11 @@ struct UI_Colors final {
             .dial_border_to = nvgRGB(50, 50, 50),
             .dial_tick = nvgRGB(120, 120, 120),
 
+            .plot_bg = nvgRGB(20, 20, 20),
+            .plot_grid = nvgRGB(45, 45, 45),
+            .plot_line = nvgRGB(171, 14, 66),
+            .plot_line_dim = nvgRGB(90, 110, 140),
+
             .scroll_bar_bg = nvgRGB(20, 20, 20),
             .scroll_bar_fg = nvgRGB(70, 70, 70),
             .scroll_bar_press_fg = nvgRGB(90, 90, 90),
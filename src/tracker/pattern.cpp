@@ -0,0 +1,46 @@
+#include "pattern.h"
+
+#include <spdlog/fmt/fmt.h>
+
+Pattern::Pattern(uint32 rows, uint32 channels) : m_rows{rows}, m_channels{channels} {
+    sb_ASSERT(rows > 0 && rows <= MAX_ROWS && channels > 0 && channels <= MAX_CHANNELS);
+    m_cells.resize(static_cast<size_t>(rows) * channels);
+    m_filled.resize(channels, 0);
+}
+
+Pattern::Pattern(uint32 rows, uint32 channels, std::span<const Pattern_Cell> cells)
+    : Pattern{rows, channels} {
+    sb_ASSERT(cells.size() == m_cells.size());
+    m_cells.assign(cells.begin(), cells.end());
+    for (uint32 c = 0; c < channels; ++c) {
+        for (const auto& cell : column(c))
+            m_filled[c] += static_cast<uint32>(!cell.empty());
+    }
+}
+
+void Pattern::set(uint32 channel, uint32 row, const Pattern_Cell& cell) {
+    sb_ASSERT(channel < m_channels && row < m_rows);
+    auto& dst = m_cells[static_cast<size_t>(channel) * m_rows + row];
+    m_filled[channel] += static_cast<uint32>(!cell.empty()) - static_cast<uint32>(!dst.empty());
+    dst = cell;
+}
+
+std::string pattern_cell_text(const Pattern_Cell& cell) {
+    static constexpr const char* NAMES[] = {
+        "C-", "C#", "D-", "D#", "E-", "F-", "F#", "G-", "G#", "A-", "A#", "B-",
+    };
+
+    std::string note = "...";
+    if (cell.note == Pattern_Cell::NOTE_OFF)
+        note = "===";
+    else if (cell.note != Pattern_Cell::NOTE_NONE)
+        note = fmt::format("{}{}", NAMES[cell.note % 12], cell.note / 12 - 1);
+
+    const auto instrument = cell.instrument ? fmt::format("{:02X}", cell.instrument) : std::string{".."};
+    const auto volume =
+        cell.volume != Pattern_Cell::VOLUME_NONE ? fmt::format("{:02X}", cell.volume) : std::string{".."};
+    const auto effect = cell.effect != Pattern_Cell::EFFECT_NONE
+                            ? fmt::format("{:X}{:02X}", cell.effect, cell.param)
+                            : std::string{"..."};
+    return fmt::format("{} {} {} {}", note, instrument, volume, effect);
+}
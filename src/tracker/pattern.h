@@ -0,0 +1,83 @@
+#pragma once
+
+#include "util.h"
+
+#include <span>
+#include <string>
+#include <vector>
+
+// one row of one channel, five bytes like a classic tracker's
+struct Pattern_Cell final {
+    static constexpr uint8 NOTE_NONE = 0;
+    static constexpr uint8 NOTE_OFF = 0xff;
+    static constexpr uint8 VOLUME_NONE = 0xff;
+    static constexpr uint8 VOLUME_MAX = 64;
+    static constexpr uint8 EFFECT_NONE = 0;
+    // Fxx: tempo in bpm, for xx of 32 and up
+    static constexpr uint8 EFFECT_TEMPO = 0x0f;
+
+    // a midi note number, or NOTE_NONE or NOTE_OFF
+    uint8 note = NOTE_NONE;
+    // 0 for none
+    uint8 instrument = 0;
+    // 0 ..= VOLUME_MAX, or VOLUME_NONE for full
+    uint8 volume = VOLUME_NONE;
+    uint8 effect = EFFECT_NONE;
+    uint8 param = 0;
+
+    bool empty() const {
+        return note == NOTE_NONE && instrument == 0 && volume == VOLUME_NONE && effect == EFFECT_NONE;
+    }
+
+    bool operator==(const Pattern_Cell&) const = default;
+};
+
+static_assert(sizeof(Pattern_Cell) == 5);
+
+// rows by channels of cells, column-major so each channel's rows are one contiguous run. the ui edits its
+// own copy and hands the sequencer immutable copies through a Swap_Ptr. a count of filled cells per channel
+// lets the sequencer skip the channels that have nothing in them.
+class Pattern final {
+  public:
+    static constexpr uint32 MAX_ROWS = 1 << 16;
+    static constexpr uint32 MAX_CHANNELS = 256;
+
+    Pattern(uint32 rows, uint32 channels);
+    // cells in the same column-major order as cells()
+    Pattern(uint32 rows, uint32 channels, std::span<const Pattern_Cell> cells);
+
+    uint32 rows() const {
+        return m_rows;
+    }
+
+    uint32 channels() const {
+        return m_channels;
+    }
+
+    const Pattern_Cell& at(uint32 channel, uint32 row) const {
+        return m_cells[static_cast<size_t>(channel) * m_rows + row];
+    }
+
+    void set(uint32 channel, uint32 row, const Pattern_Cell& cell);
+
+    std::span<const Pattern_Cell> cells() const {
+        return m_cells;
+    }
+
+    std::span<const Pattern_Cell> column(uint32 channel) const {
+        return {m_cells.data() + static_cast<size_t>(channel) * m_rows, m_rows};
+    }
+
+    bool channel_used(uint32 channel) const {
+        return m_filled[channel] > 0;
+    }
+
+  private:
+    uint32 m_rows;
+    uint32 m_channels;
+    std::vector<Pattern_Cell> m_cells;
+    std::vector<uint32> m_filled;
+};
+
+// "C#4 01 40 F7D", with dots for what's empty
+std::string pattern_cell_text(const Pattern_Cell& cell);
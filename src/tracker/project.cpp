@@ -0,0 +1,293 @@
+#include "project.h"
+#include "enc.h"
+#include "sample_cache.h"
+
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+static_assert(std::endian::native == std::endian::little, "project files are read in place");
+
+static constexpr char PROJECT_MAGIC[8] = {'S', 'B', 'P', 'R', 'O', 'J', 0, 0};
+static constexpr uint64 PROJECT_ALIGN = 64;
+
+struct Project_Header final {
+    char magic[8];
+    uint32 version;
+    uint32 chunk_count;
+    uint64 directory_offset;
+    uint64 reserved;
+};
+
+struct Project_Dir_Entry final {
+    uint32 id;
+    uint32 version;
+    uint64 offset;
+    uint64 size;
+    uint64 reserved;
+};
+
+struct Project_Sample_Header final {
+    uint32 sample_rate;
+    uint32 channels;
+    uint64 frames;
+    uint32 name_size;
+    uint32 data_offset;
+};
+
+static_assert(sizeof(Project_Header) == 32 && sizeof(Project_Dir_Entry) == 32);
+static_assert(sizeof(Project_Sample_Header) == 24 && sizeof(Project_Graph) == 16);
+
+static uint64 project_align(uint64 offset) {
+    return (offset + PROJECT_ALIGN - 1) / PROJECT_ALIGN * PROJECT_ALIGN;
+}
+
+// metadata goes through an Enc_Writer that's flushed to the file whenever a sample body goes out, so the
+// bodies are written straight from the caller's memory and the file is never held whole
+class Project_Output final {
+  public:
+    explicit Project_Output(std::FILE* file) : m_file{file}, m_enc{1 << 16} {
+    }
+
+    Enc_Writer& enc() {
+        return m_enc;
+    }
+
+    uint64 offset() const {
+        return m_flushed + m_enc.size();
+    }
+
+    void pad(uint64 to) {
+        m_enc.encode_zeros(static_cast<size_t>(to - offset()));
+    }
+
+    void write_direct(std::span<const uint8> bytes) {
+        flush();
+        m_ok = m_ok && std::fwrite(bytes.data(), 1, bytes.size(), m_file) == bytes.size();
+        m_flushed += bytes.size();
+    }
+
+    bool flush() {
+        const auto bytes = m_enc.bytes();
+        m_ok = m_ok && std::fwrite(bytes.data(), 1, bytes.size(), m_file) == bytes.size();
+        m_flushed += bytes.size();
+        m_enc.clear();
+        return m_ok;
+    }
+
+  private:
+    std::FILE* m_file;
+    Enc_Writer m_enc;
+    uint64 m_flushed = 0;
+    bool m_ok = true;
+};
+
+static std::span<const uint8> project_bytes(const void* data, size_t size) {
+    return {static_cast<const uint8*>(data), size};
+}
+
+static bool project_write(const char* path, const Project& project) {
+    auto* file = std::fopen(path, "wb");
+    if (!file)
+        return false;
+
+    Project_Output out{file};
+    auto& enc = out.enc();
+    std::vector<Project_Dir_Entry> directory;
+    auto begin_chunk = [&](uint32 id, uint32 version = 1) {
+        out.pad(project_align(out.offset()));
+        directory.push_back({id, version, out.offset(), 0, 0});
+    };
+    auto end_chunk = [&] {
+        directory.back().size = out.offset() - directory.back().offset;
+    };
+
+    // patched once the directory's place is known
+    Project_Header header{};
+    std::memcpy(header.magic, PROJECT_MAGIC, sizeof(PROJECT_MAGIC));
+    header.version = PROJECT_VERSION;
+    enc.encode_one(header);
+
+    begin_chunk(PROJECT_CHUNK_GRAPH);
+    enc.encode_one(project.graph);
+    end_chunk();
+
+    begin_chunk(PROJECT_CHUNK_PARAMS);
+    enc.encode_one(static_cast<uint32>(project.params.size()));
+    for (const auto& param : project.params) {
+        enc.encode_string(param.name);
+        enc.encode_one(param.value);
+    }
+    end_chunk();
+
+    if (project.pattern) {
+        begin_chunk(PROJECT_CHUNK_PATTERN);
+        enc.encode_one(project.pattern->rows());
+        enc.encode_one(project.pattern->channels());
+        enc.encode_array(project.pattern->cells());
+        end_chunk();
+    }
+
+    for (const auto& sample : project.samples) {
+        begin_chunk(PROJECT_CHUNK_SAMPLE, PROJECT_SAMPLE_VERSION);
+        const auto start = directory.back().offset;
+        const auto head = sizeof(Project_Sample_Header) + sizeof(uint64) + sample.name.size();
+        const Project_Sample_Header sh{sample.sample_rate, sample.channels, sample.frames,
+            static_cast<uint32>(sample.name.size()), static_cast<uint32>(project_align(head))};
+        const auto count = static_cast<size_t>(sample.channels) * sample.frames;
+        const auto data = project_bytes(sample.data, count * sizeof(float32));
+        enc.encode_one(sh);
+        enc.encode_one(sample.hash ? sample.hash : content_hash(data));
+        enc.encode_exact_bytes(project_bytes(sample.name.data(), sample.name.size()));
+        out.pad(start + sh.data_offset);
+        out.write_direct(data);
+        end_chunk();
+    }
+
+    out.pad(project_align(out.offset()));
+    header.chunk_count = static_cast<uint32>(directory.size());
+    header.directory_offset = out.offset();
+    for (const auto& entry : directory)
+        enc.encode_one(entry);
+
+    // the header is the only thing written twice
+    auto ok = out.flush() && std::fseek(file, 0, SEEK_SET) == 0 &&
+              std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = std::fclose(file) == 0 && ok;
+    return ok;
+}
+
+bool project_save(const char* path, const Project& project) {
+    return project_write_temp(path, project) && project_replace(path);
+}
+
+bool project_write_temp(const char* path, const Project& project) {
+    const auto tmp = std::string{path} + ".tmp";
+    if (project_write(tmp.c_str(), project))
+        return true;
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+    return false;
+}
+
+bool project_replace(const char* path) {
+    std::error_code ec;
+    std::filesystem::rename(std::string{path} + ".tmp", path, ec);
+    return !ec;
+}
+
+bool Project_File::create(const char* path) {
+    destroy();
+    if (!m_file.create(path))
+        return false;
+
+    Enc_Reader in{m_file.bytes()};
+    const auto header = in.decode_one<Project_Header>();
+    if (!header || std::memcmp(header->magic, PROJECT_MAGIC, sizeof(PROJECT_MAGIC)) || header->version == 0 ||
+        header->version > PROJECT_VERSION || !in.seek(header->directory_offset)) {
+        destroy();
+        return false;
+    }
+
+    m_chunks.reserve(std::min<size_t>(header->chunk_count, in.remaining() / sizeof(Project_Dir_Entry)));
+    for (uint32 i = 0; i < header->chunk_count; ++i) {
+        const auto entry = in.decode_one<Project_Dir_Entry>();
+        Enc_Reader body{m_file.bytes()};
+        std::optional<std::span<const uint8>> bytes;
+        if (entry && body.seek(entry->offset))
+            bytes = body.decode_exact_bytes(entry->size);
+        if (!bytes) {
+            destroy();
+            return false;
+        }
+        m_chunks.push_back({entry->id, entry->version, *bytes});
+    }
+    m_version = header->version;
+    return true;
+}
+
+void Project_File::destroy() {
+    m_chunks.clear();
+    m_version = 0;
+    m_file.destroy();
+}
+
+std::span<const uint8> Project_File::chunk(uint32 id, uint32* version) const {
+    for (const auto& chunk : m_chunks) {
+        if (chunk.id == id) {
+            if (version)
+                *version = chunk.version;
+            return chunk.bytes;
+        }
+    }
+    return {};
+}
+
+std::optional<Pattern> Project_File::pattern() const {
+    Enc_Reader in{chunk(PROJECT_CHUNK_PATTERN)};
+    const auto rows = in.decode_one<uint32>();
+    const auto channels = in.decode_one<uint32>();
+    if (!rows || !channels || *rows == 0 || *rows > Pattern::MAX_ROWS || *channels == 0 ||
+        *channels > Pattern::MAX_CHANNELS)
+        return std::nullopt;
+    const auto cells = in.decode_array<Pattern_Cell>(static_cast<size_t>(*rows) * *channels);
+    if (!cells)
+        return std::nullopt;
+    return Pattern{*rows, *channels, *cells};
+}
+
+std::optional<Project_Graph> Project_File::graph() const {
+    Enc_Reader in{chunk(PROJECT_CHUNK_GRAPH)};
+    return in.decode_one<Project_Graph>();
+}
+
+std::vector<Project_Param> Project_File::params() const {
+    Enc_Reader in{chunk(PROJECT_CHUNK_PARAMS)};
+    std::vector<Project_Param> params;
+    const auto count = in.decode_one<uint32>().value_or(0);
+    for (uint32 i = 0; i < count; ++i) {
+        const auto name = in.decode_string();
+        const auto value = in.decode_one<float32>();
+        if (!value)
+            break;
+        params.push_back({std::string{*name}, *value});
+    }
+    return params;
+}
+
+std::vector<Project_Sample> Project_File::samples() const {
+    std::vector<Project_Sample> samples;
+    for (const auto& chunk : m_chunks) {
+        if (chunk.id != PROJECT_CHUNK_SAMPLE)
+            continue;
+        Enc_Reader in{chunk.bytes};
+        const auto sh = in.decode_one<Project_Sample_Header>();
+        if (!sh || sh->channels == 0 || sh->data_offset % PROJECT_ALIGN)
+            continue;
+        // version 1 had no hash, it's worked out when needed
+        std::optional<uint64> hash = 0;
+        if (chunk.version >= 2)
+            hash = in.decode_one<uint64>();
+        if (!hash)
+            continue;
+        const auto name = in.decode_exact_bytes(sh->name_size);
+        if (!name || sh->data_offset < in.position() || !in.seek(sh->data_offset))
+            continue;
+        // frames first, so a huge count can't overflow the product
+        if (sh->frames > in.remaining() / sizeof(float32) / sh->channels)
+            continue;
+        const auto data = in.decode_array<float32>(static_cast<size_t>(sh->frames) * sh->channels);
+        if (!data)
+            continue;
+        samples.push_back({
+            {reinterpret_cast<const char*>(name->data()), name->size()},
+            sh->sample_rate,
+            sh->channels,
+            sh->frames,
+            data->data(),
+            *hash,
+        });
+    }
+    return samples;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "util.h"
+#include "mapped_file.h"
+#include "pattern.h"
+
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// a project file is a header, chunks and a directory of them at the end. every chunk starts 64-byte
+// aligned and carries its own version, so a reader skips ids it doesn't know and a chunk's layout can grow
+// without touching the others. sample data is stored planar float32 exactly as it's played, so opening maps
+// the file and hands out pointers into it; nothing is parsed or copied and sample pages are only read in
+// when first touched. little endian throughout.
+//
+//   header     magic "SBPROJ\0\0", u32 version, u32 chunk count, u64 directory offset, u64 reserved
+//   directory  per chunk: u32 id, u32 version, u64 offset, u64 size, u64 reserved
+//   PATT       u32 rows, u32 channels, then the cells column-major, five bytes each
+//   GRPH       u32 sample rate, u32 period frames, u32 block frames, u32 resampler quality
+//   PARM       u32 count, then per parameter a u32-length-prefixed name and an f32 value
+//   SMPL       one per sample: u32 rate, u32 channels, u64 frames, u32 name size, u32 data offset from the
+//              chunk start, from version 2 a u64 content_hash of the data, the name, then channels * frames
+//              f32 at the 64-byte aligned data offset
+inline constexpr uint32 PROJECT_VERSION = 1;
+inline constexpr uint32 PROJECT_SAMPLE_VERSION = 2;
+
+inline constexpr uint32 project_chunk_id(const char (&id)[5]) {
+    return static_cast<uint32>(id[0]) | static_cast<uint32>(id[1]) << 8 | static_cast<uint32>(id[2]) << 16 |
+           static_cast<uint32>(id[3]) << 24;
+}
+
+inline constexpr uint32 PROJECT_CHUNK_PATTERN = project_chunk_id("PATT");
+inline constexpr uint32 PROJECT_CHUNK_GRAPH = project_chunk_id("GRPH");
+inline constexpr uint32 PROJECT_CHUNK_PARAMS = project_chunk_id("PARM");
+inline constexpr uint32 PROJECT_CHUNK_SAMPLE = project_chunk_id("SMPL");
+
+// how the graph is run, see Tracker_Audio_Config
+struct Project_Graph final {
+    uint32 sample_rate = 48000;
+    uint32 period_frames = 480;
+    uint32 block_frames = 0;
+    uint32 quality = 1;
+};
+
+struct Project_Param final {
+    std::string name;
+    float32 value;
+};
+
+struct Project_Sample final {
+    std::string_view name;
+    uint32 sample_rate = 0;
+    uint32 channels = 0;
+    uint64 frames = 0;
+    // planar, channel c from data + c * frames. from a Project_File it points into the mapping.
+    const float32* data = nullptr;
+    // content_hash of the data, so nothing has to read it all to tell samples apart. 0 if not known, and a
+    // save works it out then.
+    uint64 hash = 0;
+};
+
+// what gets saved
+struct Project final {
+    Project_Graph graph;
+    std::vector<Project_Param> params;
+    const Pattern* pattern = nullptr;
+    std::vector<Project_Sample> samples;
+};
+
+// writes to a temporary next to path and renames it over, so a failed save leaves the old file whole
+bool project_save(const char* path, const Project& project);
+
+// the two halves of project_save, for a caller that has to let go of path in between. windows won't
+// replace a file that is still mapped, and the temporary is written from the open file's samples.
+bool project_write_temp(const char* path, const Project& project);
+bool project_replace(const char* path);
+
+// an open project file. create only maps it and checks the directory; the accessors read their chunk when
+// called, and sample views stay valid until destroy.
+class Project_File final {
+  public:
+    bool create(const char* path);
+    void destroy();
+
+    uint32 version() const {
+        return m_version;
+    }
+
+    // the first chunk with the id and its version, an empty span if there's none
+    std::span<const uint8> chunk(uint32 id, uint32* version = nullptr) const;
+
+    std::optional<Pattern> pattern() const;
+    std::optional<Project_Graph> graph() const;
+    std::vector<Project_Param> params() const;
+    std::vector<Project_Sample> samples() const;
+
+  private:
+    struct Chunk final {
+        uint32 id;
+        uint32 version;
+        std::span<const uint8> bytes;
+    };
+
+    Mapped_File m_file;
+    uint32 m_version = 0;
+    std::vector<Chunk> m_chunks;
+};
@@ -0,0 +1,298 @@
+#include "sample_cache.h"
+#include "enc.h"
+#include "dsp/resampler.h"
+
+#include <miniaudio.h>
+#include <spdlog/fmt/fmt.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+static constexpr char CACHE_MAGIC[8] = {'S', 'B', 'P', 'C', 'M', 0, 0, 0};
+
+struct Cache_Header final {
+    char magic[8];
+    uint32 version;
+    uint32 channels;
+    uint32 sample_rate;
+    uint32 reserved;
+    uint64 frames;
+    uint64 source_hash;
+    uint64 source_size;
+};
+
+static_assert(sizeof(Cache_Header) <= Cached_Sample::DATA_OFFSET);
+
+// decoded libraries run past what a long can seek to on windows
+static bool cache_seek(std::FILE* file, uint64 offset) {
+#if defined(_WIN32)
+    return _fseeki64(file, static_cast<int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+uint64 content_hash(std::span<const uint8> bytes) {
+    static constexpr uint64 PRIME_1 = 0x9e3779b185ebca87ull;
+    static constexpr uint64 PRIME_2 = 0xc2b2ae3d27d4eb4full;
+    auto round = [](uint64 h, uint64 v) {
+        h += v * PRIME_2;
+        h = (h << 31) | (h >> 33);
+        return h * PRIME_1;
+    };
+
+    // four independent lanes over 32-byte stripes keep the multiplies in flight, then the tail a word and
+    // a byte at a time
+    uint64 lanes[4] = {PRIME_1 + PRIME_2, PRIME_2, 0, 0 - PRIME_1};
+    size_t i = 0;
+    for (; i + 32 <= bytes.size(); i += 32) {
+        for (uint32 l = 0; l < 4; ++l) {
+            uint64 v;
+            std::memcpy(&v, bytes.data() + i + l * 8, 8);
+            lanes[l] = round(lanes[l], v);
+        }
+    }
+    auto h = static_cast<uint64>(bytes.size());
+    for (const auto lane : lanes)
+        h = round(h, lane);
+    for (; i + 8 <= bytes.size(); i += 8) {
+        uint64 v;
+        std::memcpy(&v, bytes.data() + i, 8);
+        h = round(h, v);
+    }
+    for (; i < bytes.size(); ++i)
+        h = round(h, bytes[i]);
+
+    h ^= h >> 33;
+    h *= PRIME_2;
+    h ^= h >> 29;
+    return h;
+}
+
+bool Cached_Sample::create(const char* path) {
+    destroy();
+    if (!m_file.create(path))
+        return false;
+
+    Enc_Reader in{m_file.bytes()};
+    const auto header = in.decode_one<Cache_Header>();
+    if (!header || std::memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) ||
+        header->version != VERSION || header->channels == 0 || !in.seek(DATA_OFFSET) ||
+        header->frames > in.remaining() / sizeof(float32) / header->channels) {
+        destroy();
+        return false;
+    }
+
+    m_data = in.decode_array<float32>(static_cast<size_t>(header->frames) * header->channels)->data();
+    m_channels = header->channels;
+    m_sample_rate = header->sample_rate;
+    m_frames = header->frames;
+    m_source_hash = header->source_hash;
+    m_source_size = header->source_size;
+    return true;
+}
+
+void Cached_Sample::destroy() {
+    m_file.destroy();
+    m_data = nullptr;
+    m_channels = 0;
+    m_frames = 0;
+}
+
+void Sample_Cache::create(std::string dir) {
+    m_dir = std::move(dir);
+    std::error_code ec;
+    std::filesystem::create_directories(m_dir, ec);
+}
+
+std::string Sample_Cache::entry_path(uint64 hash, uint32 sample_rate) const {
+    return fmt::format("{}/{:016x}-{}.pcm", m_dir, hash, sample_rate);
+}
+
+// writes an entry a chunk at a time, so the file is never held whole. read fills up to the frames asked for
+// interleaved and returns how many it did, 0 at the end; short of header.frames the rest stays silent.
+template <typename Read>
+static bool write_entry(const std::string& path, const Cache_Header& header, Read&& read) {
+    const auto tmp = path + ".tmp";
+    auto* file = header.frames > 0 ? std::fopen(tmp.c_str(), "wb") : nullptr;
+    if (!file)
+        return false;
+
+    Enc_Writer out{Cached_Sample::DATA_OFFSET};
+    out.encode_one(header);
+    out.encode_zeros(Cached_Sample::DATA_OFFSET - out.size());
+    auto ok = std::fwrite(out.bytes().data(), 1, out.size(), file) == out.size();
+
+    // every channel's run is written in place
+    static constexpr uint32 CHUNK = 16384;
+    const auto channels = header.channels;
+    const auto frames = header.frames;
+    std::vector<float32> chunk(static_cast<size_t>(CHUNK) * channels);
+    std::vector<float32> planar(CHUNK);
+    for (uint64 at = 0; ok && at < frames;) {
+        const auto count = read(chunk.data(), std::min<uint64>(CHUNK, frames - at));
+        if (count == 0)
+            break;
+        for (uint32 c = 0; c < channels && ok; ++c) {
+            for (uint64 i = 0; i < count; ++i)
+                planar[i] = chunk[i * channels + c];
+            const auto offset = Cached_Sample::DATA_OFFSET + (c * frames + at) * sizeof(float32);
+            ok = cache_seek(file, offset) &&
+                 std::fwrite(planar.data(), sizeof(float32), count, file) == count;
+        }
+        at += count;
+    }
+    ok = std::fclose(file) == 0 && ok;
+
+    // unwritten channel ends read back as silence once the file is its full size
+    std::error_code ec;
+    const auto size = Cached_Sample::DATA_OFFSET + channels * frames * sizeof(float32);
+    if (ok)
+        std::filesystem::resize_file(tmp, size, ec);
+    if (ok && !ec)
+        std::filesystem::rename(tmp, path, ec);
+    if (!ok || ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+// a hit has to agree on the size too, so a hash collision decodes rather than plays the wrong sample
+static bool cache_hit(Cached_Sample& out, const std::string& entry, uint64 hash, uint64 size) {
+    return out.create(entry.c_str()) && out.source_hash() == hash && out.source_size() == size;
+}
+
+static Cache_Header cache_header(
+    uint32 channels, uint32 sample_rate, uint64 frames, uint64 hash, uint64 size) {
+    Cache_Header h{};
+    std::memcpy(h.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    h.version = Cached_Sample::VERSION;
+    h.channels = channels;
+    h.sample_rate = sample_rate;
+    h.frames = frames;
+    h.source_hash = hash;
+    h.source_size = size;
+    return h;
+}
+
+// the source resampled to sample_rate, with the best kernel since it's made once and kept
+static bool resample_entry(Stream_Sample source, uint32 source_rate, uint32 sample_rate, uint64 hash,
+    uint64 source_size, const std::string& entry) {
+    if (source.channels == 0 || source.frames == 0 || source_rate == 0)
+        return false;
+
+    static constexpr uint32 BLOCK = 4096;
+    Sinc_Resampler resampler;
+    resampler.create(source.channels, source_rate, sample_rate, Resampler_Quality::Best, BLOCK);
+    std::vector<float32> in(static_cast<size_t>(BLOCK) * source.channels);
+
+    // the resampler lines its first output up with the first input, so the tail only needs silence fed in
+    const auto frames = (source.frames * sample_rate + source_rate - 1) / source_rate;
+    uint64 read_at = 0;
+    const auto header = cache_header(source.channels, sample_rate, frames, hash, source_size);
+    return write_entry(entry, header, [&](float32* chunk, uint64 count) -> uint64 {
+        uint64 written = 0;
+        while (written < count) {
+            const auto want = static_cast<uint32>(count - written);
+            const auto need = std::min(resampler.input_frames_needed(want), BLOCK);
+            for (uint32 i = 0; i < need; ++i, ++read_at) {
+                for (uint32 c = 0; c < source.channels; ++c) {
+                    in[static_cast<size_t>(i) * source.channels + c] =
+                        read_at < source.frames ? source.data[c * source.frames + read_at] : 0.f;
+                }
+            }
+            written += resampler.process(in.data(), need, chunk + written * source.channels, want);
+        }
+        return written;
+    });
+}
+
+bool Sample_Cache::decode(std::span<const uint8> source, uint64 hash, Cached_Sample& out) {
+    // the source is already mapped for the hash, so the decoder reads the same pages. a rate of 0 keeps the
+    // file's own, which opening the decoder is enough to learn
+    const auto config = ma_decoder_config_init(ma_format_f32, 0, 0);
+    ma_decoder decoder;
+    if (ma_decoder_init_memory(source.data(), source.size(), &config, &decoder) != MA_SUCCESS)
+        return false;
+    const auto channels = decoder.outputChannels;
+    const auto path = entry_path(hash, decoder.outputSampleRate);
+    if (cache_hit(out, path, hash, source.size())) {
+        ma_decoder_uninit(&decoder);
+        return true;
+    }
+    out.destroy();
+
+    // planar needs the length up front. decoders that can't tell are read into memory first; past the
+    // length the others give, frames are dropped, and short of it the rest stays silent.
+    ma_uint64 frames = 0;
+    std::vector<float32> decoded;
+    if (ma_decoder_get_length_in_pcm_frames(&decoder, &frames) != MA_SUCCESS || frames == 0) {
+        float32 chunk[4096];
+        ma_uint64 read = 0;
+        do {
+            // a short read comes back as MA_AT_END, so only the frame count matters
+            read = 0;
+            ma_decoder_read_pcm_frames(&decoder, chunk, std::size(chunk) / channels, &read);
+            decoded.insert(decoded.end(), chunk, chunk + read * channels);
+        } while (read > 0);
+        frames = decoded.size() / channels;
+    }
+
+    uint64 at = 0;
+    const auto header = cache_header(channels, decoder.outputSampleRate, frames, hash, source.size());
+    const auto ok = write_entry(path, header, [&](float32* chunk, uint64 count) -> uint64 {
+        if (decoded.empty()) {
+            ma_uint64 read = 0;
+            ma_decoder_read_pcm_frames(&decoder, chunk, count, &read);
+            return read;
+        }
+        std::copy_n(decoded.data() + at * channels, count * channels, chunk);
+        at += count;
+        return count;
+    });
+    ma_decoder_uninit(&decoder);
+    return ok && out.create(path.c_str());
+}
+
+bool Sample_Cache::convert(
+    Stream_Sample source, uint64 source_hash, uint32 source_rate, uint32 sample_rate, Cached_Sample& out) {
+    const std::span bytes{
+        reinterpret_cast<const uint8*>(source.data), source.frames * source.channels * sizeof(float32)};
+    // the same frames at another rate convert to something else, so the rate goes into the hash
+    const auto rate = static_cast<uint64>(source_rate);
+    const auto hash = (source_hash ? source_hash : content_hash(bytes)) ^
+                      content_hash({reinterpret_cast<const uint8*>(&rate), sizeof(rate)});
+    const auto entry = entry_path(hash, sample_rate);
+    if (cache_hit(out, entry, hash, bytes.size()))
+        return true;
+    out.destroy();
+    return resample_entry(source, source_rate, sample_rate, hash, bytes.size(), entry) &&
+           out.create(entry.c_str());
+}
+
+bool Sample_Cache::load(const char* path, uint32 sample_rate, Cached_Sample& out) {
+    Mapped_File source;
+    if (!source.create(path))
+        return false;
+    const auto hash = content_hash(source.bytes());
+    const auto entry = entry_path(hash, sample_rate);
+    if (cache_hit(out, entry, hash, source.bytes().size()))
+        return true;
+    // unmapped first, windows won't rename over a mapped file
+    out.destroy();
+
+    // decoded at the file's own rate and resampled like a project's samples, so miniaudio's converter
+    // never makes what's kept
+    Cached_Sample native;
+    if (!decode(source.bytes(), hash, native))
+        return false;
+    const auto size = source.bytes().size();
+    if (native.sample_rate() != sample_rate &&
+        !resample_entry(native.stream(), native.sample_rate(), sample_rate, hash, size, entry))
+        return false;
+    native.destroy();
+    return out.create(entry.c_str());
+}
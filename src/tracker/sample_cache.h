@@ -0,0 +1,85 @@
+#pragma once
+
+#include "util.h"
+#include "mapped_file.h"
+#include "dsp/sample_stream.h"
+
+#include <string>
+
+// a decoded sample as the cache keeps it: a 64-byte header, then planar float32 at the rate it was decoded
+// at, mapped so it's read in as it's played
+//
+//   header  magic "SBPCM\0\0\0", u32 version, u32 channels, u32 sample rate, u32 reserved, u64 frames,
+//           u64 source hash, u64 source size, zeros up to 64
+class Cached_Sample final {
+  public:
+    static constexpr uint32 VERSION = 1;
+    static constexpr uint32 DATA_OFFSET = 64;
+
+    bool create(const char* path);
+    void destroy();
+
+    Stream_Sample stream() const {
+        return {m_data, m_channels, m_frames};
+    }
+
+    uint32 channels() const {
+        return m_channels;
+    }
+
+    uint32 sample_rate() const {
+        return m_sample_rate;
+    }
+
+    uint64 frames() const {
+        return m_frames;
+    }
+
+    uint64 source_hash() const {
+        return m_source_hash;
+    }
+
+    uint64 source_size() const {
+        return m_source_size;
+    }
+
+  private:
+    Mapped_File m_file;
+    const float32* m_data = nullptr;
+    uint32 m_channels = 0;
+    uint32 m_sample_rate = 0;
+    uint64 m_frames = 0;
+    uint64 m_source_hash = 0;
+    uint64 m_source_size = 0;
+};
+
+// the decoded, resampled audio of imported files, kept in a directory under a hash of each file's bytes
+// and the rate it was decoded at. a file seen before is hashed and mapped, never decoded again, whatever
+// its path or name; a new one is decoded by miniaudio once at its own rate and written out, and any other
+// rate is made from that with Sinc_Resampler, the same as a project's samples. entries are written to a
+// temporary and renamed into place, so a crash mid-import leaves no half entry behind.
+class Sample_Cache final {
+  public:
+    void create(std::string dir);
+
+    // ui thread. any file miniaudio decodes, at sample_rate with its own channel count
+    bool load(const char* path, uint32 sample_rate, Cached_Sample& out);
+
+    // ui thread. planar frames recorded at source_rate, resampled to sample_rate. keyed on the frames'
+    // content_hash, so a project's samples are converted once whichever file they're opened from. a known
+    // hash is passed in, so a hit never reads the frames; 0 has them hashed here.
+    bool convert(
+        Stream_Sample source, uint64 source_hash, uint32 source_rate, uint32 sample_rate, Cached_Sample& out);
+
+    // the file an entry is kept in
+    std::string entry_path(uint64 hash, uint32 sample_rate) const;
+
+  private:
+    // at the file's own rate, into the entry for that rate unless it's already there
+    bool decode(std::span<const uint8> source, uint64 hash, Cached_Sample& out);
+
+    std::string m_dir;
+};
+
+// 64 bits of a fast non-cryptographic hash, for telling files apart rather than for security
+uint64 content_hash(std::span<const uint8> bytes);
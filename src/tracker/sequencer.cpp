@@ -0,0 +1,150 @@
+#include "sequencer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+Dsp_Pattern_Node::Dsp_Pattern_Node(
+    uint32 channels, Swap_Ptr<Pattern>* patterns, std::atomic<int32>* position,
+    std::shared_ptr<const Wavetable> table, uint32 voice_count, Sample_Streamer* streamer)
+    : Dsp_Pattern_Node{
+          std::allocator_arg, {}, channels, patterns, position, std::move(table), voice_count, streamer} {
+}
+
+Dsp_Pattern_Node::Dsp_Pattern_Node(
+    std::allocator_arg_t, const allocator_type& alloc, uint32 channels, Swap_Ptr<Pattern>* patterns,
+    std::atomic<int32>* position, std::shared_ptr<const Wavetable> table, uint32 voice_count,
+    Sample_Streamer* streamer)
+    : channels{channels}, voices{std::allocator_arg, alloc, std::move(table), voice_count},
+      m_patterns{patterns}, m_position{position}, m_streamer{streamer} {
+    update_row_frames();
+    m_position->store(-1, std::memory_order_relaxed);
+}
+
+Dsp_Node_Desc Dsp_Pattern_Node::desc() const {
+    return {"Pattern", 0, 1, channels};
+}
+
+void Dsp_Pattern_Node::prepare(const Dsp_Prepare& prepare) {
+    m_sample_rate = static_cast<float32>(prepare.sample_rate);
+    voices.set_sample_rate(m_sample_rate);
+    update_row_frames();
+}
+
+void Dsp_Pattern_Node::process(const Dsp_Process_Args& args) {
+    const auto& out = args.outputs[0];
+    auto* dst = out.channel(0);
+    std::memset(dst, 0, args.frame_count * sizeof(float32));
+
+    const auto* pattern = m_patterns->acquire();
+    if (!pattern && m_playing)
+        stop();
+
+    for (uint32 i = 0; i < args.frame_count;) {
+        auto n = args.frame_count - i;
+        if (m_playing) {
+            if (m_countdown <= 0.0) {
+                play_row(*pattern);
+                m_countdown += m_row_frames;
+            }
+            n = std::min(n, static_cast<uint32>(std::ceil(m_countdown)));
+            m_countdown -= n;
+        }
+        voices.render(dst + i, n);
+        for (uint32 c = 1; c < channels; ++c)
+            std::memcpy(out.channel(c) + i, dst + i, n * sizeof(float32));
+        if (m_streamer)
+            m_streamer->render(out, i, n);
+        i += n;
+    }
+}
+
+void Dsp_Pattern_Node::set_param(uint32 param, float32 value, uint32) {
+    switch (param) {
+    case PARAM_PLAY:
+        if (value < 0.f) {
+            stop();
+        } else {
+            m_playing = true;
+            m_row = static_cast<uint32>(value);
+            m_countdown = 0.0;
+        }
+        break;
+    case PARAM_BPM:
+        m_bpm = std::max(value, 1.f);
+        update_row_frames();
+        break;
+    case PARAM_ROWS_PER_BEAT:
+        m_rows_per_beat = std::max(value, 1.f);
+        update_row_frames();
+        break;
+    }
+}
+
+void Dsp_Pattern_Node::play_row(const Pattern& pattern) {
+    // the pattern may have shrunk since the last row
+    if (m_row >= pattern.rows())
+        m_row = 0;
+    m_position->store(static_cast<int32>(m_row), std::memory_order_relaxed);
+
+    const auto keys = pattern.channels();
+    m_keys = std::max(m_keys, keys);
+    for (uint32 c = 0; c < keys; ++c) {
+        if (!pattern.channel_used(c))
+            continue;
+        const auto& cell = pattern.at(c, m_row);
+        if (cell.note == Pattern_Cell::NOTE_OFF) {
+            voices.note_off(c);
+            if (m_streamer)
+                m_streamer->note_off(c);
+        } else if (cell.note != Pattern_Cell::NOTE_NONE) {
+            const auto velocity = cell.volume == Pattern_Cell::VOLUME_NONE
+                                      ? 1.f
+                                      : static_cast<float32>(cell.volume) / Pattern_Cell::VOLUME_MAX;
+            // a channel plays one note at a time, from the synth or a sample
+            if (m_streamer && cell.instrument > 0 && cell.instrument <= m_streamer->sample_count()) {
+                voices.note_off(c);
+                m_streamer->note_on(c, cell.instrument - 1u, velocity);
+            } else {
+                if (m_streamer)
+                    m_streamer->note_off(c);
+                voices.note_on(c, cell.note, velocity);
+            }
+        }
+        if (cell.effect == Pattern_Cell::EFFECT_TEMPO && cell.param >= 32) {
+            m_bpm = cell.param;
+            update_row_frames();
+        }
+    }
+
+    if (m_streamer && m_streamer->sample_count() > 0)
+        prefetch_row(pattern, (m_row + PREFETCH_ROWS) % pattern.rows());
+    m_row = m_row + 1 < pattern.rows() ? m_row + 1 : 0;
+}
+
+void Dsp_Pattern_Node::prefetch_row(const Pattern& pattern, uint32 row) {
+    for (uint32 c = 0; c < pattern.channels(); ++c) {
+        if (!pattern.channel_used(c))
+            continue;
+        const auto& cell = pattern.at(c, row);
+        const auto note = cell.note != Pattern_Cell::NOTE_NONE && cell.note != Pattern_Cell::NOTE_OFF;
+        if (note && cell.instrument > 0)
+            m_streamer->prefetch(cell.instrument - 1u);
+    }
+}
+
+void Dsp_Pattern_Node::stop() {
+    m_playing = false;
+    for (uint32 k = 0; k < m_keys; ++k) {
+        voices.note_off(k);
+        if (m_streamer)
+            m_streamer->note_off(k);
+    }
+    m_keys = 0;
+    m_position->store(-1, std::memory_order_relaxed);
+}
+
+void Dsp_Pattern_Node::update_row_frames() {
+    const auto rows_per_second = static_cast<float64>(m_bpm) * m_rows_per_beat / 60.0;
+    m_row_frames = static_cast<float64>(m_sample_rate) / rows_per_second;
+}
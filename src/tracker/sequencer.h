@@ -0,0 +1,66 @@
+#pragma once
+
+#include "pattern.h"
+#include "dsp/graph.h"
+#include "dsp/sample_stream.h"
+#include "dsp/swap_ptr.h"
+#include "dsp/voices.h"
+
+#include <atomic>
+#include <memory>
+
+// plays the newest published Pattern on its own Voice_Allocator, channel c as key c, summed to every
+// channel of its output. a row's notes start on the frame the row does, and the frames between rows cost a
+// comparison, so a callback with no row boundary in it is just the voices. PARAM_PLAY starts from the row
+// given as the value, or stops and releases everything if it's negative; the others set the tempo.
+//
+// a note with instrument i plays the streamer's sample i - 1 instead, if there is one. each row also asks
+// the streamer to prefetch the samples PREFETCH_ROWS ahead, so their streamed parts are in the os cache by
+// the time the heads run out.
+struct Dsp_Pattern_Node final {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    static constexpr uint32 PARAM_PLAY = 0;
+    static constexpr uint32 PARAM_BPM = 1;
+    static constexpr uint32 PARAM_ROWS_PER_BEAT = 2;
+    static constexpr uint32 PREFETCH_ROWS = 8;
+
+    // patterns, position and streamer outlive the node; position is the row playing, -1 when stopped, for
+    // the ui. streamer may be null.
+    Dsp_Pattern_Node(
+        uint32 channels, Swap_Ptr<Pattern>* patterns, std::atomic<int32>* position,
+        std::shared_ptr<const Wavetable> table, uint32 voice_count, Sample_Streamer* streamer = nullptr);
+    Dsp_Pattern_Node(
+        std::allocator_arg_t, const allocator_type& alloc, uint32 channels, Swap_Ptr<Pattern>* patterns,
+        std::atomic<int32>* position, std::shared_ptr<const Wavetable> table, uint32 voice_count,
+        Sample_Streamer* streamer = nullptr);
+
+    Dsp_Node_Desc desc() const;
+    void prepare(const Dsp_Prepare& prepare);
+    void process(const Dsp_Process_Args& args);
+    void set_param(uint32 param, float32 value, uint32 ramp_frames);
+
+    uint32 channels;
+    Voice_Allocator voices;
+
+  private:
+    void play_row(const Pattern& pattern);
+    void prefetch_row(const Pattern& pattern, uint32 row);
+    void stop();
+    void update_row_frames();
+
+    Swap_Ptr<Pattern>* m_patterns;
+    std::atomic<int32>* m_position;
+    Sample_Streamer* m_streamer;
+    float32 m_sample_rate = 48000.f;
+    float32 m_bpm = 125.f;
+    float32 m_rows_per_beat = 4.f;
+    float64 m_row_frames = 0.0;
+
+    bool m_playing = false;
+    uint32 m_row = 0;
+    // frames until the next row starts; it starts on the first whole frame at or past zero
+    float64 m_countdown = 0.0;
+    // keys started since the last stop, so stopping releases only those
+    uint32 m_keys = 0;
+};
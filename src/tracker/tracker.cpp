@@ -1,9 +1,26 @@
 #include "tracker.h"
 
 #include "ui.h"
+#include "dsp/nodes.h"
+#include "sequencer.h"
+#include "dsp/rt_alloc.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <nfd.hpp>
+#include <spdlog/spdlog.h>
+
+static int64 steady_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
 
 void Tracker::create() {
-    sb_ASSERT(ma_context_init(nullptr, 0, nullptr, &m_context) == MA_SUCCESS);
+    m_context_created = ma_context_init(nullptr, 0, nullptr, &m_context) == MA_SUCCESS;
+    sb_ASSERT(m_context_created);
 
     ma_device_info* playback_devs = nullptr;
     uint32 playback_dev_count = 0;
@@ -29,11 +46,246 @@ void Tracker::create() {
         m_capture_dev_names.emplace_back(capture_devs[i].name);
         m_capture_dev_ids.push_back(capture_devs[i].id);
     }
+
+    create_workers();
+    create_pattern();
+    m_arena.create(Tracker::ARENA_BYTES);
+    build_graph();
+    m_analyzer.create(m_config.sample_rate, 2);
+
+    if (!m_playback_dev_ids.empty() && !m_capture_dev_ids.empty())
+        create_device();
+}
+
+void Tracker::create_headless() {
+    create_workers();
+    create_pattern();
+    m_arena.create(Tracker::ARENA_BYTES);
+    build_graph();
+}
+
+void Tracker::set_audio_config(const Tracker_Audio_Config& config) {
+    stop_device();
+    if (config.sample_rate != m_config.sample_rate && (m_project || !m_imported.empty())) {
+        // every sample the streamer plays is at the old rate. the io thread reads the entries being
+        // replaced, so it goes first
+        m_streamer.destroy();
+        for (auto& imported : m_imported) {
+            if (!m_sample_cache.load(imported.path.c_str(), config.sample_rate, *imported.sample)) {
+                spdlog::error(
+                    "couldn't reload {} at {} Hz, it stays silent", imported.path, config.sample_rate);
+                imported.sample->destroy();
+            }
+        }
+        create_streamer(config.sample_rate);
+    }
+    m_config = config;
+    build_graph();
+    m_callback_stats.reset();
+
+    if (!m_context_created)
+        return;
+    m_analyzer.destroy();
+    m_analyzer.create(m_config.sample_rate, 2);
+    if (!m_playback_dev_ids.empty() && !m_capture_dev_ids.empty())
+        create_device();
+}
+
+void Tracker::stop_device() {
+    if (m_device_created) {
+        ma_device_uninit(&m_device);
+        m_device_created = false;
+    }
 }
 
 void Tracker::destroy() {
-    ma_device_uninit(&m_device);
-    ma_context_uninit(&m_context);
+    stop_device();
+    m_streamer.destroy();
+    m_analyzer.destroy();
+    m_workers.destroy();
+    m_schedule = {};
+    m_arena.destroy();
+    if (m_context_created)
+        ma_context_uninit(&m_context);
+}
+
+Offline_Render_Stats Tracker::render_offline(std::vector<float32>& out, float64 seconds) {
+    const auto frames = static_cast<uint64>(seconds * m_schedule.sample_rate());
+    return dsp_render_offline(m_schedule, frames, m_config.period_frames, out);
+}
+
+std::optional<Offline_Render_Stats> Tracker::render_offline(const char* wav_path, float64 seconds) {
+    const auto frames = static_cast<uint64>(seconds * m_schedule.sample_rate());
+    return dsp_render_offline_wav(m_schedule, frames, m_config.period_frames, wav_path);
+}
+
+void Tracker::set_param(Dsp_Node_Id node, uint32 param, float32 value, float32 ramp_ms) {
+    const auto time = std::max(estimate_sample_time(), m_last_event_time);
+    const auto ramp = static_cast<uint32>(ramp_ms * 0.001f * m_schedule.sample_rate());
+    if (m_param_queue.try_push({node, param, value, time, ramp}))
+        m_last_event_time = time;
+}
+
+void Tracker::play_pattern(uint32 row) {
+    set_param(m_pattern_node, Dsp_Pattern_Node::PARAM_PLAY, static_cast<float32>(row), 0.f);
+}
+
+uint64 Tracker::estimate_sample_time() const {
+    if (!m_device_created)
+        return m_schedule.sample_time();
+
+    const auto frames = m_clock_frames.load(std::memory_order_acquire);
+    const auto ns = m_clock_ns.load(std::memory_order_acquire);
+    const auto elapsed_ns = static_cast<uint64>(std::max<int64>(steady_ns() - ns, 0));
+    const auto elapsed = elapsed_ns * m_schedule.sample_rate() / 1'000'000'000ull;
+    // one period of slack keeps every event in the future, so each lands at the offset it was made at
+    const auto period = m_config.period_frames;
+    return frames + std::min<uint64>(elapsed, period) + period;
+}
+
+bool Tracker::save_project(const char* path) {
+    Project project;
+    project.graph = {
+        .sample_rate = m_config.sample_rate,
+        .period_frames = m_config.period_frames,
+        .block_frames = m_config.block_frames,
+        .quality = static_cast<uint32>(m_config.quality),
+    };
+    project.params = {{"filter.cutoff_hz", std::exp2(m_cutoff_octaves)}, {"gain", m_gain}};
+    project.pattern = &m_pattern;
+    // these point into the open file's mapping, so over that file they're written before it's let go
+    if (m_project)
+        project.samples = m_project->samples();
+    for (const auto& imported : m_imported) {
+        const auto& sample = *imported.sample;
+        // one that couldn't be reloaded keeps its slot empty, so the instruments after it still line up
+        const auto channels = std::max(sample.channels(), 1u);
+        project.samples.push_back(
+            {imported.name, sample.sample_rate(), channels, sample.frames(), sample.stream().data});
+    }
+    std::error_code ec;
+    if (!m_project || !std::filesystem::equivalent(path, m_project_path, ec))
+        return project_save(path, project);
+
+    // windows won't rename over the file while it's mapped. the streamer reads it on its io thread and
+    // the graph calls into the streamer, so all of them stop before it's unmapped
+    if (!project_write_temp(path, project))
+        return false;
+    stop_device();
+    m_streamer.destroy();
+    m_project.reset();
+    const auto saved = project_replace(path);
+    // the new file, which holds the imports now too, or the old one if the rename didn't go through
+    auto file = std::make_unique<Project_File>();
+    if (file->create(path)) {
+        m_project = std::move(file);
+        if (saved)
+            m_imported.clear();
+    } else {
+        spdlog::error("couldn't reopen {}, its samples are gone until it's opened again", path);
+    }
+    create_streamer(m_config.sample_rate);
+    set_audio_config(m_config);
+    return saved;
+}
+
+template <typename T, size_t N>
+static void find_index(const T (&values)[N], T value, uint32& idx) {
+    const auto it = std::find(std::begin(values), std::end(values), value);
+    if (it != std::end(values))
+        idx = static_cast<uint32>(it - std::begin(values));
+}
+
+bool Tracker::open_project(const char* path) {
+    auto file = std::make_unique<Project_File>();
+    if (!file->create(path))
+        return false;
+    auto pattern = file->pattern();
+    if (!pattern || pattern->channels() != CHANNELS)
+        return false;
+
+    m_pattern = std::move(*pattern);
+    publish_pattern();
+    for (const auto& param : file->params()) {
+        if (param.name == "filter.cutoff_hz")
+            m_cutoff_octaves = std::log2(std::clamp(param.value, 20.f, 20000.f));
+        else if (param.name == "gain")
+            m_gain = std::clamp(param.value, 0.f, 1.f);
+    }
+
+    // through the dropdowns' indices, so only configs the ui offers are applied
+    if (const auto graph = file->graph()) {
+        find_index(SAMPLE_RATES, graph->sample_rate, m_rate_idx);
+        find_index(PERIODS, graph->period_frames, m_period_idx);
+        find_index(BLOCKS, graph->block_frames, m_block_idx);
+        m_quality_idx = std::min(graph->quality, static_cast<uint32>(Resampler_Quality::Best));
+    }
+    Tracker_Audio_Config config;
+    config.sample_rate = SAMPLE_RATES[m_rate_idx];
+    config.period_frames = PERIODS[m_period_idx];
+    config.quality = static_cast<Resampler_Quality>(m_quality_idx);
+    config.block_frames = BLOCKS[m_block_idx];
+
+    // the streamer reads the old file on its io thread and the graph calls into the streamer, so both go
+    // with the device stopped; set_audio_config brings it back on a graph built from the loaded values
+    stop_device();
+    m_streamer.destroy();
+    m_project = std::move(file);
+    m_project_path = path;
+    m_imported.clear();
+    // a new rate has set_audio_config make the streamer
+    if (config.sample_rate == m_config.sample_rate)
+        create_streamer(config.sample_rate);
+    set_audio_config(config);
+    return true;
+}
+
+bool Tracker::import_sample(const char* path) {
+    // made on first use, so a run that never imports leaves no directory behind
+    m_sample_cache.create(SAMPLE_CACHE_DIR);
+    auto sample = std::make_unique<Cached_Sample>();
+    if (!m_sample_cache.load(path, m_config.sample_rate, *sample))
+        return false;
+
+    stop_device();
+    m_imported.push_back({std::filesystem::path{path}.stem().string(), path, std::move(sample)});
+    create_streamer(m_config.sample_rate);
+    set_audio_config(m_config);
+    return true;
+}
+
+void Tracker::create_streamer(uint32 sample_rate) {
+    // the io thread reads the converted samples, so it's stopped before they go
+    m_streamer.destroy();
+    m_converted.clear();
+
+    std::vector<Stream_Sample> samples;
+    if (m_project) {
+        for (const auto& sample : m_project->samples()) {
+            const Stream_Sample source{sample.data, sample.channels, sample.frames};
+            if (sample.sample_rate == sample_rate) {
+                samples.push_back(source);
+                continue;
+            }
+            // the streamer plays frames as they are, so anything at another rate would play off pitch
+            m_sample_cache.create(SAMPLE_CACHE_DIR);
+            auto converted = std::make_unique<Cached_Sample>();
+            if (!m_sample_cache.convert(source, sample.hash, sample.sample_rate, sample_rate, *converted)) {
+                // an empty slot keeps the instruments after it on their samples
+                spdlog::error("couldn't convert sample {} from {} Hz, it stays silent", sample.name,
+                    sample.sample_rate);
+                samples.push_back({});
+                continue;
+            }
+            samples.push_back(converted->stream());
+            m_converted.push_back(std::move(converted));
+        }
+    }
+    for (const auto& imported : m_imported)
+        samples.push_back(imported.sample->stream());
+    // headless renders run faster than realtime with nothing to wait for an io thread, so they fill the
+    // rings themselves
+    m_streamer.create(samples, SAMPLE_HEAD_MS * sample_rate / 1000, !m_context_created);
 }
 
 void Tracker::ui() {
@@ -43,22 +295,174 @@ void Tracker::ui() {
 
     using namespace ui;
     Vector2_F32 sz;
-    constexpr static auto val = [](const std::string_view note) {
-        auto itr = interact()(mux())(text(Draw_Font::Mono)(note));
-        return [itr = std::move(itr)](Vector2_F32& sz) mutable {
+    pattern_ui({0.f, 0.f});
+
+    auto cutoff = dial(m_cutoff_octaves, std::log2(20.f), std::log2(20000.f), [this](float32 v) {
+        set_param(m_filter_node, Dsp_Biquad_Node::PARAM_FREQ, std::exp2(v));
+    });
+    auto gain = dial(m_gain, 0.f, 1.f, [this](float32 v) {
+        set_param(m_gain_node, Dsp_Gain_Node::PARAM_GAIN, v);
+    });
+
+    const auto playing = m_play_row.load(std::memory_order_relaxed) >= 0;
+    auto play = button(text()(playing ? "Stop" : "Play"), onclick([this, playing] {
+        set_param(m_pattern_node, Dsp_Pattern_Node::PARAM_PLAY, playing ? -1.f : 0.f, 0.f);
+    }));
+
+    static constexpr const char* PROJECT_PATH = "project.sbp";
+    auto save = button(text()("Save"), onclick([this] {
+        if (!save_project(PROJECT_PATH))
+            spdlog::error("couldn't save {}", PROJECT_PATH);
+    }));
+    auto open = button(text()("Open"), onclick([this] {
+        if (!open_project(PROJECT_PATH))
+            spdlog::error("couldn't open {}", PROJECT_PATH);
+    }));
+
+    auto import = button(text()("Import"), onclick([this] {
+        NFD::UniquePathU8 path;
+        const nfdu8filteritem_t filters[] = {{"Audio", "wav,flac,mp3"}};
+        if (NFD::OpenDialog(path, filters, 1) == NFD_OKAY && !import_sample(path.get()))
+            spdlog::error("couldn't import {}", path.get());
+    }));
+
+    auto params = hstack(Spacing{10.f});
+    params(vstack(Spacing{4.f})(cutoff())(text()("{:.0f} Hz", std::exp2(m_cutoff_octaves))));
+    params(vstack(Spacing{4.f})(gain())(text()("Gain {:.2f}", m_gain)));
+    params(vstack(Spacing{4.f})(play())(save())(open())(import()));
+    std::move(params)(sz)({{220.f, 0.f}, {200.f, 60.f}});
+
+    // only re-evaluated on frames where the cutoff moved
+    const auto filter = biquad_design(
+        Biquad_Type::Lowpass, m_config.sample_rate, std::exp2(m_cutoff_octaves), 0.707f);
+    m_filter_response.set_stage(0, {&filter, 1});
+    m_filter_response.update();
+    freq_response(
+        m_filter_response.freqs(), m_filter_response.magnitude_db(),
+        m_filter_response.phase())(Size{{200.f, 120.f}})(sz)({{220.f, 70.f}, {200.f, 120.f}});
+
+    const auto& frame = m_analyzer.latest();
+    spectrum(frame.magnitudes_db, frame.bin_hz)(Size{{420.f, 160.f}})(sz)({{0.f, 210.f}, {420.f, 160.f}});
+
+    stats_ui({440.f, 0.f});
+    audio_ui({440.f, 210.f});
+}
+
+void Tracker::pattern_ui(Vector2_F32 pos) {
+    using namespace ui;
+    // as many channels as fit; clicking a cell toggles a c-4 in it
+    static constexpr uint32 VIEW_CHANNELS = 2;
+
+    const auto play_row = m_play_row.load(std::memory_order_relaxed);
+    auto cell = [this](uint32 channel, uint32 row, bool playing) {
+        auto itr = interact()(onclick([this, channel, row] {
+            auto c = m_pattern.at(channel, row);
+            c.note = c.note == Pattern_Cell::NOTE_NONE ? 60 : Pattern_Cell::NOTE_NONE;
+            m_pattern.set(channel, row, c);
+            publish_pattern();
+        }))(text(Draw_Font::Mono)("{}", pattern_cell_text(m_pattern.at(channel, row))));
+        return [itr = std::move(itr), playing](Vector2_F32& sz) mutable {
             auto ritr = std::move(itr)(sz);
-            return [ritr = std::move(ritr)](const Rect2_F32& r) mutable {
+            return [ritr = std::move(ritr), playing](const Rect2_F32& r) mutable {
                 const auto itr = ritr(r);
-                if (itr.hover)
-                    UI_State::get().draw->fill_rect(r, nvgRGBA(255, 255, 255, 50));
+                if (itr.hover || playing)
+                    UI_State::get().draw->fill_rect(r, nvgRGBA(255, 255, 255, itr.hover ? 50 : 30));
             };
         };
     };
-    auto vs = vstack();
-    for (uint32 i = 0; i < 64; ++i) {
-        vs(val("C-4"));
+
+    auto rows = vstack();
+    for (uint32 r = 0; r < m_pattern.rows(); ++r) {
+        auto row = hstack(Spacing{8.f});
+        row(text(Draw_Font::Mono)("{:02X}", r));
+        for (uint32 c = 0; c < std::min(VIEW_CHANNELS, m_pattern.channels()); ++c)
+            row(cell(c, r, static_cast<int32>(r) == play_row));
+        rows(std::move(row));
     }
-    scroll_view(Scroll_Direction::Vertical)(vs)(sz)({{0.f, 0.f}, {200.f, 200.f}});
+
+    Vector2_F32 sz;
+    scroll_view(Scroll_Direction::Vertical)(rows)(sz)({pos, {200.f, 200.f}});
+}
+
+void Tracker::stats_ui(Vector2_F32 pos) {
+    using namespace ui;
+    const auto s = m_callback_stats.snapshot();
+
+    auto histogram = drawn({200.f, 60.f}, [s](const Rect2_F32& r) {
+        auto& state = UI_State::get();
+        state.draw->fill_rect(r, state.colors.plot_bg);
+
+        uint32 most = 1;
+        for (const auto count : s.histogram)
+            most = std::max(most, count);
+        const auto bar = r.size.x / static_cast<float32>(Callback_Stats_Snapshot::BUCKETS);
+        for (uint32 i = 0; i < Callback_Stats_Snapshot::BUCKETS; ++i) {
+            const auto h = r.size.y * static_cast<float32>(s.histogram[i]) / static_cast<float32>(most);
+            state.draw->fill_rect(
+                {{r.pos.x + bar * static_cast<float32>(i), r.max().y - h}, {std::max(bar - 1.f, 1.f), h}},
+                state.colors.plot_line);
+        }
+        // the deadline
+        const auto deadline_x = r.pos.x + bar / Callback_Stats_Snapshot::BUCKET_LOAD;
+        state.draw->stroke_line({deadline_x, r.pos.y}, {deadline_x, r.max().y}, state.colors.fg, 1.f);
+    });
+
+    auto dump = button(text()("Dump"), onclick([this] {
+        if (m_callback_stats.dump("callback_stats.txt"))
+            spdlog::info("wrote callback_stats.txt");
+        else
+            spdlog::error("couldn't write callback_stats.txt");
+    }));
+    auto reset = button(text()("Reset"), onclick([this] { m_callback_stats.reset(); }));
+
+    auto panel = vstack(Spacing{2.f});
+    panel(text(Draw_Font::Mono)("DSP load {:5.1f}%  peak {:5.1f}%", s.load * 100.f, s.peak_load * 100.f));
+    panel(text(Draw_Font::Mono)(
+        "callback {:6.0f} us  mean {:6.0f}  max {:6.0f}", s.last_us, s.mean_us, s.max_us));
+    panel(text(Draw_Font::Mono)("budget   {:6.0f} us", s.budget_us));
+    panel(text(Draw_Font::Mono)("jitter   {:6.0f} us  max {:6.0f}", s.last_jitter_us, s.max_jitter_us));
+    panel(text(Draw_Font::Mono)("xruns {}  callbacks {}", s.xruns, s.callbacks));
+    panel(std::move(histogram));
+    panel(hstack(Spacing{4.f})(dump())(reset()));
+
+    Vector2_F32 sz;
+    auto rpanel = std::move(panel)(sz);
+    rpanel({pos, sz});
+}
+
+void Tracker::audio_ui(Vector2_F32 pos) {
+    using namespace ui;
+    static constexpr std::string_view rates[] = {"44100 Hz", "48000 Hz", "88200 Hz", "96000 Hz"};
+    static constexpr std::string_view periods[] = {"64", "128", "256", "480", "1024", "2048"};
+    static constexpr std::string_view qualities[] = {"Draft", "Normal", "High", "Best"};
+    static constexpr std::string_view blocks[] = {"Device", "32", "64", "128"};
+    static_assert(std::size(rates) == std::size(Tracker::SAMPLE_RATES));
+    static_assert(std::size(periods) == std::size(Tracker::PERIODS));
+    static_assert(std::size(blocks) == std::size(Tracker::BLOCKS));
+
+    // the dropdowns write their index while laying out; the change is applied on the next frame
+    Tracker_Audio_Config config;
+    config.sample_rate = Tracker::SAMPLE_RATES[m_rate_idx];
+    config.period_frames = Tracker::PERIODS[m_period_idx];
+    config.quality = static_cast<Resampler_Quality>(m_quality_idx);
+    config.block_frames = Tracker::BLOCKS[m_block_idx];
+    if (config.sample_rate != m_config.sample_rate || config.period_frames != m_config.period_frames ||
+        config.quality != m_config.quality || config.block_frames != m_config.block_frames)
+        set_audio_config(config);
+
+    auto panel = vstack(Spacing{4.f});
+    panel(hstack(Spacing{4.f})(dropdown(rates, m_rate_idx)())(dropdown(periods, m_period_idx)()));
+    panel(hstack(Spacing{4.f})(text()("Resampler"))(dropdown(qualities, m_quality_idx)()));
+    panel(hstack(Spacing{4.f})(text()("Block"))(dropdown(blocks, m_block_idx)()));
+    if (m_resampling)
+        panel(text(Draw_Font::Mono)("device {} Hz, resampling", m_device_rate));
+    else
+        panel(text(Draw_Font::Mono)("device {} Hz", m_device_rate));
+    panel(text(Draw_Font::Mono)("graph latency {} frames", m_schedule.latency()));
+
+    Vector2_F32 sz;
+    auto rpanel = std::move(panel)(sz);
+    rpanel({pos, sz});
 }
 
 void ma_data_callback(ma_device* device, void* output, const void* input, ma_uint32 frame_count) {
@@ -66,6 +470,20 @@ void ma_data_callback(ma_device* device, void* output, const void* input, ma_uin
         ->data_callback(output, input, static_cast<uint32>(frame_count));
 }
 
+// the engine rate if the device runs at it natively, otherwise its first native rate
+static uint32 native_sample_rate(ma_context* context, const ma_device_id* id, uint32 preferred) {
+    ma_device_info info;
+    if (ma_context_get_device_info(context, ma_device_type_playback, id, &info) != MA_SUCCESS)
+        return preferred;
+    for (uint32 i = 0; i < info.nativeDataFormatCount; ++i) {
+        // zero means any rate
+        const auto rate = info.nativeDataFormats[i].sampleRate;
+        if (rate == 0 || rate == preferred)
+            return preferred;
+    }
+    return info.nativeDataFormatCount > 0 ? info.nativeDataFormats[0].sampleRate : preferred;
+}
+
 void Tracker::create_device() {
     auto config = ma_device_config_init(ma_device_type_duplex);
 
@@ -78,14 +496,161 @@ void Tracker::create_device() {
     config.capture.pDeviceID = &m_capture_dev_ids[m_capture_dev_idx];
     config.capture.shareMode = ma_share_mode_shared;
 
-    config.sampleRate = Tracker::SAMPLE_RATE;
-    config.periodSizeInFrames = Tracker::FRAME_COUNT;
+    // run the device at its own rate so miniaudio never converts; the period keeps the same duration
+    m_device_rate = native_sample_rate(&m_context, config.playback.pDeviceID, m_config.sample_rate);
+    m_device_period = static_cast<uint32>(
+        (static_cast<uint64>(m_config.period_frames) * m_device_rate + m_config.sample_rate - 1) /
+        m_config.sample_rate);
+    config.sampleRate = m_device_rate;
+    config.periodSizeInFrames = m_device_period;
     config.dataCallback = ma_data_callback;
     config.pUserData = this;
 
-    ma_device_init(nullptr, &config, &m_device);
+    m_device_created = ma_device_init(nullptr, &config, &m_device) == MA_SUCCESS;
+    if (!m_device_created)
+        return;
+    m_device_rate = m_device.sampleRate;
+    create_resamplers();
     ma_device_start(&m_device);
 }
 
+void Tracker::create_resamplers() {
+    m_resampling = m_device_rate != m_config.sample_rate;
+    if (!m_resampling)
+        return;
+
+    // engine frames per device period, rounded up, plus the playback converter's first fill
+    const auto scaled = static_cast<uint64>(m_device_period) * m_config.sample_rate;
+    const auto period = static_cast<uint32>((scaled + m_device_rate - 1) / m_device_rate + 1);
+    m_capture_resampler.create(2, m_device_rate, m_config.sample_rate, m_config.quality, m_device_period);
+    m_playback_resampler.create(2, m_config.sample_rate, m_device_rate, m_config.quality, period);
+    const auto engine_frames = period + m_playback_resampler.taps();
+
+    // starts with silence covering both converters' startup plus a few frames of slack for the
+    // period-to-period rounding, so it never runs dry
+    const auto prime = m_capture_resampler.taps() + m_playback_resampler.taps() / 2 + 4;
+    const auto fifo_frames = engine_frames * 4 + prime;
+    m_capture_fifo.assign(static_cast<size_t>(fifo_frames) * 2, 0.f);
+    m_capture_fill = prime;
+    m_engine_out.assign(static_cast<size_t>(engine_frames) * 2, 0.f);
+}
+
+void Tracker::create_workers() {
+    // one core stays with the device callback, which takes part in every level itself
+    const auto cores = std::thread::hardware_concurrency();
+    m_workers.create(cores > 1 ? cores - 1 : 0);
+}
+
+void Tracker::create_pattern() {
+    // an arpeggio over a bass line, so there's something to play
+    static constexpr uint8 CHORD[] = {57, 60, 64, 67};
+    for (uint32 r = 0; r < m_pattern.rows(); r += 2) {
+        Pattern_Cell lead;
+        lead.note = static_cast<uint8>(CHORD[(r / 2) % 4] + 12 * ((r / 16) % 2));
+        lead.volume = 40;
+        m_pattern.set(0, r, lead);
+    }
+    for (uint32 r = 0; r < m_pattern.rows(); r += 16) {
+        Pattern_Cell bass;
+        bass.note = r % 32 ? 41 : 45;
+        m_pattern.set(1, r, bass);
+        bass.note = Pattern_Cell::NOTE_OFF;
+        m_pattern.set(1, r + 12, bass);
+    }
+    publish_pattern();
+}
+
+void Tracker::publish_pattern() {
+    m_patterns.publish(std::make_unique<const Pattern>(m_pattern));
+}
+
+void Tracker::build_graph() {
+    // the old nodes live in the arena, so they have to go before it's reused
+    m_schedule = {};
+    m_arena.reset();
+
+    if (!m_wavetable)
+        m_wavetable = std::make_shared<const Wavetable>(Wavetable_Shape::Saw);
+
+    Dsp_Graph graph{&m_arena};
+    const auto input = graph.add<Dsp_Device_Input_Node>(2);
+    const auto player =
+        graph.add<Dsp_Pattern_Node>(2, &m_patterns, &m_play_row, m_wavetable, VOICES, &m_streamer);
+    const auto mix = graph.add<Dsp_Mixer_Node>(2, 2);
+    const auto filter =
+        graph.add<Dsp_Biquad_Node>(2, Biquad_Type::Lowpass, std::exp2(m_cutoff_octaves), 0.707f);
+    const auto gain = graph.add<Dsp_Gain_Node>(2, m_gain);
+    const auto output = graph.add<Dsp_Device_Output_Node>(2);
+    graph.connect(input, 0, mix, 0);
+    graph.connect(player, 0, mix, 1);
+    graph.connect(mix, 0, filter, 0);
+    graph.connect(filter, 0, gain, 0);
+    graph.connect(gain, 0, output, 0);
+
+    m_pattern_node = player;
+    m_filter_node = filter;
+    m_gain_node = gain;
+    m_filter_response.create(static_cast<float32>(m_config.sample_rate), 512);
+    m_filter_response.set_stage_count(1);
+
+    // a fixed block is all the graph ever sees at once, so its buffers only need that much
+    const auto block = m_config.block_frames;
+    m_schedule.compile(std::move(graph), m_config.sample_rate, block > 0 ? block : m_config.period_frames, 2);
+    m_schedule.set_block_frames(block);
+    m_schedule.set_param_queue(&m_param_queue);
+    // the new schedule's clock starts from zero, so events stamped against the old one would never come
+    // due; the device is stopped here, which makes this thread the queue's only consumer
+    while (m_param_queue.front())
+        m_param_queue.pop();
+    m_clock_frames.store(0, std::memory_order_release);
+    m_clock_ns.store(0, std::memory_order_release);
+    m_last_event_time = 0;
+    m_schedule.set_worker_pool(&m_workers);
+
+    if (m_arena.overflow() > 0)
+        spdlog::warn("dsp arena overflowed by {} bytes, raise Tracker::ARENA_BYTES", m_arena.overflow());
+}
+
 void Tracker::data_callback(void* output, const void* input, uint32 frame_count) {
+    Rt_Alloc_Scope rt;
+    const auto start_ns = steady_ns();
+    m_clock_ns.store(start_ns, std::memory_order_release);
+    m_clock_frames.store(m_schedule.sample_time(), std::memory_order_release);
+    if (m_resampling) {
+        process_resampled(static_cast<float32*>(output), static_cast<const float32*>(input), frame_count);
+    } else {
+        m_schedule.process(static_cast<const float32*>(input), static_cast<float32*>(output), frame_count);
+        m_analyzer.push(static_cast<const float32*>(output), frame_count);
+    }
+    m_callback_stats.record(start_ns, steady_ns(), frame_count, m_device_rate);
+}
+
+void Tracker::process_resampled(float32* output, const float32* input, uint32 frame_count) {
+    const auto fifo_frames = static_cast<uint32>(m_capture_fifo.size() / 2);
+    for (uint32 done = 0; done < frame_count;) {
+        const auto n = std::min(frame_count - done, m_device_period);
+
+        auto* capture = m_capture_fifo.data() + static_cast<size_t>(m_capture_fill) * 2;
+        m_capture_fill += m_capture_resampler.process(
+            input + static_cast<size_t>(done) * 2, n, capture, fifo_frames - m_capture_fill);
+
+        // the engine renders exactly what the playback converter needs for n device frames
+        const auto frames = m_playback_resampler.input_frames_needed(n);
+        if (m_capture_fill < frames) {
+            std::fill(
+                m_capture_fifo.begin() + static_cast<size_t>(m_capture_fill) * 2,
+                m_capture_fifo.begin() + static_cast<size_t>(frames) * 2, 0.f);
+            m_capture_fill = frames;
+        }
+        m_schedule.process(m_capture_fifo.data(), m_engine_out.data(), frames);
+        m_analyzer.push(m_engine_out.data(), frames);
+
+        std::memmove(
+            m_capture_fifo.data(), m_capture_fifo.data() + static_cast<size_t>(frames) * 2,
+            static_cast<size_t>(m_capture_fill - frames) * 2 * sizeof(float32));
+        m_capture_fill -= frames;
+
+        m_playback_resampler.process(m_engine_out.data(), frames, output + static_cast<size_t>(done) * 2, n);
+        done += n;
+    }
 }
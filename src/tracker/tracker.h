@@ -1,35 +1,177 @@
 #pragma once
 
 #include "util.h"
+#include "dsp/graph.h"
+#include "dsp/offline.h"
+#include "dsp/analyzer.h"
+#include "dsp/arena.h"
+#include "dsp/callback_stats.h"
+#include "dsp/resampler.h"
+#include "dsp/response.h"
+#include "dsp/sample_stream.h"
+#include "dsp/swap_ptr.h"
+#include "dsp/wavetable.h"
+#include "pattern.h"
+#include "project.h"
+#include "sample_cache.h"
 
 #include <miniaudio.h>
 #include <vector>
 #include <string>
+#include <optional>
+#include <atomic>
+#include <memory>
+
+// the rate and period the graph runs at. the device keeps its native rate; when that differs, the engine
+// is converted to and from it with Sinc_Resampler at the given quality.
+struct Tracker_Audio_Config final {
+    uint32 sample_rate = 48000;
+    uint32 period_frames = 480;
+    Resampler_Quality quality = Resampler_Quality::Normal;
+    // the graph's fixed block, see Dsp_Schedule::set_block_frames; 0 runs it in whatever the device hands
+    // the callback
+    uint32 block_frames = 0;
+};
 
 class Tracker final {
   public:
-    static constexpr uint32 SAMPLE_RATE = 48000;
-    static constexpr uint32 FRAME_COUNT = 480;
+    static constexpr uint32 SAMPLE_RATES[] = {44100, 48000, 88200, 96000};
+    static constexpr uint32 PERIODS[] = {64, 128, 256, 480, 1024, 2048};
+    static constexpr uint32 BLOCKS[] = {0, 32, 64, 128};
+    // node state and the schedule's buffers
+    static constexpr size_t ARENA_BYTES = 8 << 20;
+    // the playback synth's polyphony, shared by all the pattern's channels
+    static constexpr uint32 VOICES = 256;
+    static constexpr uint32 CHANNELS = 64;
+    static constexpr uint32 PATTERN_ROWS = 64;
+    // of every project sample kept in memory, the rest is streamed
+    static constexpr uint32 SAMPLE_HEAD_MS = 250;
+    static constexpr const char* SAMPLE_CACHE_DIR = "cache/samples";
 
     void create();
+    // builds the engine without a miniaudio context or device, for offline rendering
+    void create_headless();
     void destroy();
 
     void ui();
 
+    // ui thread. restarts the device and rebuilds the graph, so parameter ramps and node state reset.
+    void set_audio_config(const Tracker_Audio_Config& config);
+
+    const Tracker_Audio_Config& audio_config() const {
+        return m_config;
+    }
+
+    Offline_Render_Stats render_offline(std::vector<float32>& out, float64 seconds);
+    std::optional<Offline_Render_Stats> render_offline(const char* wav_path, float64 seconds);
+
+    // ui thread. queues a change that lands in the audio stream at the sample the call was made at,
+    // about one period from now, and ramps over ramp_ms.
+    void set_param(Dsp_Node_Id node, uint32 param, float32 value, float32 ramp_ms = 20.f);
+    // ui thread. starts the pattern from row, as the Play button does
+    void play_pattern(uint32 row);
+
+    // ui thread. the pattern, the dial values, the audio config and the samples; opening keeps the file
+    // mapped and streams its samples from it until the next open succeeds.
+    bool save_project(const char* path);
+    bool open_project(const char* path);
+    // ui thread. decodes through the sample cache at the engine rate and adds the sample as the instrument
+    // after the last; it's saved into the project on the next save. restarts the device.
+    bool import_sample(const char* path);
+
   private:
     friend void ma_data_callback(ma_device*, void*, const void*, ma_uint32);
 
+    void create_workers();
+    void create_pattern();
+    // ui thread. hands the audio thread a copy of m_pattern
+    void publish_pattern();
+    void build_graph();
+    void pattern_ui(Vector2_F32 pos);
+    void stats_ui(Vector2_F32 pos);
+    void audio_ui(Vector2_F32 pos);
     void create_device();
+    void stop_device();
+    // with the device stopped. instruments number the project's samples first, then the imported ones.
+    void create_streamer(uint32 sample_rate);
+    void create_resamplers();
     void data_callback(void* output, const void* input, uint32 frame_count);
+    void process_resampled(float32* output, const float32* input, uint32 frame_count);
+
+    uint64 estimate_sample_time() const;
 
     ma_context m_context;
+    bool m_context_created = false;
     ma_device m_device;
+    bool m_device_created = false;
 
     std::vector<std::string> m_playback_dev_names;
     std::vector<ma_device_id> m_playback_dev_ids;
     std::vector<std::string> m_capture_dev_names;
     std::vector<ma_device_id> m_capture_dev_ids;
 
-    uint32 m_playback_dev_idx;
-    uint32 m_capture_dev_idx;
+    uint32 m_playback_dev_idx = 0;
+    uint32 m_capture_dev_idx = 0;
+
+    Tracker_Audio_Config m_config;
+    uint32 m_rate_idx = 1;
+    uint32 m_period_idx = 3;
+    uint32 m_quality_idx = 1;
+    uint32 m_block_idx = 0;
+
+    // the device's native rate, and the buffers that bridge it to the engine's when they differ
+    uint32 m_device_rate = 0;
+    uint32 m_device_period = 0;
+    bool m_resampling = false;
+    Sinc_Resampler m_capture_resampler;
+    Sinc_Resampler m_playback_resampler;
+    // capture at the engine rate, interleaved, waiting to be processed
+    std::vector<float32> m_capture_fifo;
+    uint32 m_capture_fill = 0;
+    std::vector<float32> m_engine_out;
+
+    Dsp_Worker_Pool m_workers;
+    // declared before the schedule so it outlives the nodes built in it
+    Dsp_Arena m_arena;
+    Dsp_Schedule m_schedule;
+    Spectrum_Analyzer m_analyzer;
+    // the filter's curve, redesigned from the ui's own copy of its parameters
+    Freq_Response m_filter_response;
+    Callback_Stats m_callback_stats;
+
+    Dsp_Param_Queue m_param_queue{1024};
+    uint64 m_last_event_time = 0;
+    // engine sample time and steady clock at the start of the latest callback
+    std::atomic<uint64> m_clock_frames = 0;
+    std::atomic<int64> m_clock_ns = 0;
+
+    // built once, it's an fft per octave
+    std::shared_ptr<const Wavetable> m_wavetable;
+
+    // the ui's working copy; the sequencer plays the last one published
+    Pattern m_pattern{PATTERN_ROWS, CHANNELS};
+    Swap_Ptr<Pattern> m_patterns;
+    // the row the sequencer is on, -1 when stopped
+    std::atomic<int32> m_play_row = -1;
+    // declared before the streamer, which reads its samples
+    std::unique_ptr<Project_File> m_project;
+    std::string m_project_path;
+    Sample_Cache m_sample_cache;
+    struct Imported_Sample final {
+        std::string name;
+        // decoded again from here when the sample rate changes
+        std::string path;
+        std::unique_ptr<Cached_Sample> sample;
+    };
+    std::vector<Imported_Sample> m_imported;
+    // the project's samples recorded at another rate than the engine's, resampled into the cache
+    std::vector<std::unique_ptr<Cached_Sample>> m_converted;
+    Sample_Streamer m_streamer;
+
+    Dsp_Node_Id m_pattern_node = 0;
+    Dsp_Node_Id m_filter_node = 0;
+    Dsp_Node_Id m_gain_node = 0;
+    float32 m_cutoff_octaves = std::log2(1000.f);
+    float32 m_gain = 0.5f;
 };
+
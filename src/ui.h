@@ -346,6 +346,7 @@ struct Sides final {
 };
 
 using Width = Value<float32>;
+using Size = Value<Vector2_F32>;
 
 auto evalsize(auto&& f) {
     Vector2_F32 sz;
@@ -793,6 +794,167 @@ auto textbox(std::string& txt) {
     };
 }
 
+// drag vertically to turn. on_change(value) fires on every change.
+auto dial(float32& value, float32 min, float32 max, auto&& on_change) {
+    return [&value, min, max, on_change = std::move(on_change)](auto... options) mutable {
+        auto& state = UI_State::get();
+
+        const auto width_ = *grab<Width>({30.f}, options...);
+
+        const auto key = ui_push_key(consthash("dial"));
+
+        struct S {
+            Interaction itr;
+        }* s = ui_get_state<S>(key);
+
+        auto drag = [s, &state, &value, min, max, on_change = std::move(on_change)](Interaction itr) mutable {
+            s->itr = itr;
+            if (itr.focus && state.input.mouse_is_pressed[0] && state.input.cursor_delta.y != 0.f) {
+                const auto v = clamp(min, max, value - state.input.cursor_delta.y * (max - min) / 200.f);
+                if (v != value) {
+                    value = v;
+                    on_change(v);
+                }
+            }
+        };
+
+        auto face = drawn({width_, width_}, [s, &state, &value, min, max](const Rect2_F32& r) {
+            const auto center = r.center();
+            const auto radius = std::min(r.size.x, r.size.y) / 2.f;
+
+            state.draw->tb_grad_fill_circle(
+                center, radius, state.colors.dial_border_from, state.colors.dial_border_to);
+            state.draw->tb_grad_fill_circle(
+                center, radius - state.opts.border_width, state.colors.dial_fill_from,
+                state.colors.dial_fill_to);
+
+            // 270 degree sweep, starting bottom left
+            const auto t = (value - min) / (max - min);
+            const auto angle = Math_Consts<float32>::pi * (0.75f + 1.5f * t);
+            const auto dir = Vector2_F32{std::cos(angle), std::sin(angle)};
+            state.draw->stroke_line(
+                center + dir * (radius * 0.4f), center + dir * (radius - 2.f),
+                s->itr.focus ? state.colors.focus_border : state.colors.dial_tick, 2.f);
+        });
+
+        auto r = interact()(std::move(drag))(std::move(face));
+
+        ui_pop_key(); // dial
+
+        return r;
+    };
+}
+
+// magnitudes in dB per linear frequency bin, drawn on a log frequency axis from 20 Hz to the last bin.
+// several bins landing on one pixel column draw their maximum so narrow peaks don't vanish.
+auto spectrum(std::span<const float32> magnitudes_db, float32 bin_hz) {
+    return [magnitudes_db, bin_hz](auto... options) {
+        const auto size_ = *grab<Size>({{400.f, 150.f}}, options...);
+        constexpr auto min_db = -96.f;
+        constexpr auto max_db = 0.f;
+        constexpr auto min_hz = 20.f;
+
+        return drawn(size_, [magnitudes_db, bin_hz](const Rect2_F32& r) {
+            auto& state = UI_State::get();
+            state.draw->fill_rect(r, state.colors.plot_bg);
+
+            const auto last_bin = std::max<size_t>(magnitudes_db.size(), 2) - 1;
+            const auto max_hz = bin_hz * static_cast<float32>(last_bin);
+            const auto octaves = std::log2(max_hz / min_hz);
+            const auto x_of = [&](float32 hz) {
+                return r.pos.x + r.size.x * std::log2(hz / min_hz) / octaves;
+            };
+            const auto y_of = [&](float32 db) {
+                return r.pos.y + r.size.y * (max_db - clamp(min_db, max_db, db)) / (max_db - min_db);
+            };
+
+            for (const auto hz : {100.f, 1000.f, 10000.f}) {
+                if (hz < max_hz)
+                    state.draw->stroke_line(
+                        {x_of(hz), r.pos.y}, {x_of(hz), r.max().y}, state.colors.plot_grid, 1.f);
+            }
+            for (auto db = min_db + 24.f; db < max_db; db += 24.f) {
+                state.draw->stroke_line(
+                    {r.pos.x, y_of(db)}, {r.max().x, y_of(db)}, state.colors.plot_grid, 1.f);
+            }
+
+            if (magnitudes_db.size() < 2 || bin_hz <= 0.f)
+                return;
+
+            const auto columns = static_cast<uint32>(std::max(r.size.x, 1.f));
+            std::pmr::vector<Vector2_F32> points{ui_mbr_alloc<Vector2_F32>()};
+            points.reserve(columns);
+            auto bin = std::max<size_t>(1, static_cast<size_t>(std::ceil(min_hz / bin_hz)));
+            for (uint32 x = 0; x < columns; ++x) {
+                const auto hz = min_hz * std::exp2(octaves * static_cast<float32>(x + 1) / columns);
+                const auto last = std::min(static_cast<size_t>(hz / bin_hz), magnitudes_db.size() - 1);
+                if (last < bin)
+                    continue;
+                auto db = magnitudes_db[bin];
+                for (; bin <= last; ++bin)
+                    db = std::max(db, magnitudes_db[bin]);
+                points.push_back({r.pos.x + static_cast<float32>(x), y_of(db)});
+            }
+
+            state.draw->push_clip_rect(r);
+            state.draw->stroke_polyline(points, state.colors.plot_line, 1.5f);
+            state.draw->pop_clip_rect();
+        });
+    };
+}
+
+// a filter's magnitude in dB, +-24 dB full height, and its phase, +-pi full height, at log spaced
+// frequencies such as Freq_Response's. one point per pixel column at most, the rest are skipped.
+auto freq_response(
+    std::span<const float32> freqs, std::span<const float32> magnitudes_db, std::span<const float32> phase) {
+    return [freqs, magnitudes_db, phase](auto... options) {
+        const auto size_ = *grab<Size>({{400.f, 150.f}}, options...);
+        constexpr auto range_db = 24.f;
+
+        return drawn(size_, [freqs, magnitudes_db, phase](const Rect2_F32& r) {
+            auto& state = UI_State::get();
+            state.draw->fill_rect(r, state.colors.plot_bg);
+            if (freqs.size() < 2)
+                return;
+
+            const auto min_hz = freqs.front();
+            const auto octaves = std::log2(freqs.back() / min_hz);
+            const auto x_of = [&](float32 hz) {
+                return r.pos.x + r.size.x * std::log2(hz / min_hz) / octaves;
+            };
+            const auto mid_y = r.pos.y + r.size.y * 0.5f;
+
+            for (const auto hz : {100.f, 1000.f, 10000.f}) {
+                if (hz > min_hz && hz < freqs.back())
+                    state.draw->stroke_line(
+                        {x_of(hz), r.pos.y}, {x_of(hz), r.max().y}, state.colors.plot_grid, 1.f);
+            }
+            for (auto db = -range_db + 12.f; db < range_db; db += 12.f) {
+                const auto y = mid_y - r.size.y * 0.5f * db / range_db;
+                state.draw->stroke_line({r.pos.x, y}, {r.max().x, y}, state.colors.plot_grid, 1.f);
+            }
+
+            const auto columns = static_cast<size_t>(std::max(r.size.x, 1.f));
+            const auto step = std::max<size_t>(1, freqs.size() / columns);
+            std::pmr::vector<Vector2_F32> points{ui_mbr_alloc<Vector2_F32>()};
+            points.reserve(freqs.size() / step + 1);
+            const auto plot = [&](std::span<const float32> values, float32 scale, NVGcolor color) {
+                points.clear();
+                for (size_t i = 0; i < freqs.size(); i += step) {
+                    const auto v = clamp(-1.f, 1.f, values[i] * scale);
+                    points.push_back({x_of(freqs[i]), mid_y - r.size.y * 0.5f * v});
+                }
+                state.draw->stroke_polyline(points, color, 1.5f);
+            };
+
+            state.draw->push_clip_rect(r);
+            plot(phase, 1.f / Math_Consts<float32>::pi, state.colors.plot_line_dim);
+            plot(magnitudes_db, 1.f / range_db, state.colors.plot_line);
+            state.draw->pop_clip_rect();
+        });
+    };
+}
+
 enum class Scroll_Direction { Vertical, Horizontal, Both };
 
 auto scroll_view(auto... options) {